@@ -14,6 +14,11 @@ at their original position. Other features include printing the player's
 current score, map statistics, switching the direction of gravity for boulders
 and illumination/shadow mode which hides sections of the map to simulate a 
 realistic cave experience. 
+
+This file is the console front-end: it feeds stdin to a session from
+caverun_session.c, which plays each statement on the engine in
+caverun_engine.c and prints what happened. With --server it instead hosts
+many sessions at once over a socket, see caverun_server.c.
 */
 
 //provided Libraries
@@ -22,266 +27,123 @@ realistic cave experience.
 
 //add your own #include statements below this line
 
-#include <ctype.h>
-#include <math.h>
-
-//provided constants
-
-#define COLS 10
-#define ROWS 10
-#define INVALID_ROW (-1)
-#define INVALID_COL (-1)
-#define INITIAL_LIVES 3
-
-//add your own #defines constants below this line
-
-#define FALSE                 0
-#define TRUE                  1
-
-#define LAST_ROW              (ROWS - 1)
-#define LAST_COL              (COLS - 1)
-
-#define UP_SINGLE            'w'
-#define DOWN_SINGLE          's'
-#define LEFT_SINGLE          'a'
-#define RIGHT_SINGLE         'd'
-#define UP_DASH              'W'
-#define DOWN_DASH            'S'
-#define LEFT_DASH            'A'
-#define RIGHT_DASH           'D'
-
-#define ILLUMINATE           'i'
-#define SHADOW               'u'
-#define GRAVITY              'g'
-#define QUIT                 'q'
-#define PRINT_SCORE          'p'
-#define PRINT_MAP_STATS      'm'
-#define LAVA_TRIGGER         'L'
-
-#define START                's'
-#define PLACE_WALL           'w'
-#define PLACE_BOULDER        'b'
-#define PLACE_GEM            'g'
-#define PLACE_LAVA           'l'
-#define PLACE_EXIT           'e'
-#define PLACE_GROUPED_WALLS  'W'
-
-#define POINTS_DIRT_NORMAL    1
-#define POINTS_DIRT_LAVA      10
-#define POINTS_GEM_NORMAL     20
-#define POINTS_GEM_LAVA       200
-
-#define GRAVITY_UP           'w'
-#define GRAVITY_DOWN         's'
-#define GRAVITY_LEFT         'a'
-#define GRAVITY_RIGHT        'd'
-
-#define ASCII_LIMIT           128
-#define CMD_HISTORY_LENGTH    5
-#define LAVA_GAME_BIRTH_COUNT 3
-#define LAVA_SURVIVE_MIN      2
-#define LAVA_SURVIVE_MAX      3
-#define LAVA_SEED_BIRTH_COUNT 2
-
-#define EPSILON               0.001
-#define SHADOW_RAY_STEP       0.0001
-
-const int D_ROW[ASCII_LIMIT] = {
-    [UP_SINGLE] = -1, [DOWN_SINGLE] = 1, [LEFT_SINGLE] = 0, [RIGHT_SINGLE] = 0,  
-    [UP_DASH] = -1, [DOWN_DASH] = 1, [LEFT_DASH] = 0, [RIGHT_DASH] = 0   
-};
-const int D_COL[ASCII_LIMIT] = {
-    [UP_SINGLE] = 0, [DOWN_SINGLE] = 0, [LEFT_SINGLE] = -1, [RIGHT_SINGLE] = 1,
-    [UP_DASH] = 0, [DOWN_DASH] = 0, [LEFT_DASH] = -1, [RIGHT_DASH] = 1
-};
-
-//provided Enums
-//enum for features on the game board
-enum entity {
-    EMPTY,
-    DIRT,
-    WALL,
-    BOULDER,
-    GEM,
-    EXIT_LOCKED,
-    EXIT_UNLOCKED,
-    HIDDEN,
-    PLAYER
-};
-
-//add your own enums below this line
-enum lava_mode {
-    LAVA_NONE,
-    GAME_OF_LAVA,
-    LAVA_SEEDS
-};
-
-//represents a tile/cell on the game board
-struct tile {
-    enum entity entity;
-    int has_lava;
-    int next_turn_lava;
-};
-
-//add your own structs below this line
-struct constants {
-    int start_row;
-    int start_col;
-    int init_dirt;
-    int init_gem;
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "caverun.h"
+#include "caverun_batch.h"
+#include "caverun_bench.h"
+#include "caverun_broadcast.h"
+#include "caverun_coop.h"
+#include "caverun_differential.h"
+#include "caverun_frames.h"
+#include "caverun_journal.h"
+#include "caverun_pipeline.h"
+#include "caverun_profile.h"
+#include "caverun_realtime.h"
+#include "caverun_server.h"
+#include "caverun_session.h"
+#include "caverun_trace.h"
+
+#define CONSOLE_INPUT_SIZE    4096
+
+//what the program was started to do
+enum run_mode {
+    MODE_CONSOLE,
+    MODE_SERVER,
+    MODE_BATCH,
+    MODE_BENCH,
+    MODE_REPLAY,
+    MODE_WATCH,
+    MODE_SPECTATE,
+    MODE_COOP,
+    MODE_DIFFERENTIAL
 };
 
-struct game_status {
-    int player_row;
-    int player_col;
-    int score;
-    int lives;
-    int can_dash;
-    int boulder_hit;
-    int lava_hit;
-    int illumination;
-    int illumination_radius;
-    int shadowed;
-    int shadow_entire_board;
-    char gravity;
-    enum lava_mode lava_mode;
-    char cmd_history[CMD_HISTORY_LENGTH];
+struct options {
+    enum run_mode mode;
+    struct server_options server;
+    struct batch_options batch;
+    struct bench_options bench;
+    struct differential_options differential;
+    const char *trace_path;
+    int pipeline;
+    const char *journal_path;
+    int keyframe_interval;
+    const char *replay_path;
+    int seek_turn;
+    const char *frames_path;
+    const char *broadcast_path;
+    int realtime;
+    int tick_ms;
+    const char *coop_paths[COOP_MAX_PLAYERS - 1];
+    int coop_count;
+    int bulk_setup;
 };
 
-//provided Function Prototypes
-void initialise_board(struct tile board[ROWS][COLS]);
-void print_board(struct tile board[ROWS][COLS], int lives_remaining);
-void print_board_line(void);
-void print_board_header(int lives);
-void print_map_statistics(
-    int number_of_dirt_tiles,
-    int number_of_gem_tiles,
-    int number_of_boulder_tiles,
-    double completion_percentage,
-    int maximum_points_remaining
-);
-
 //add your function prototypes below this line
 
-//setup function prototypes
-void initialise_player_pos(struct tile board[ROWS][COLS], 
-    struct constants *constants);
-void add_features(struct tile board[ROWS][COLS]);
-void add_single_tile_features(struct tile board[ROWS][COLS], char instruction);
-void add_grouped_walls(struct tile board[ROWS][COLS]);
-
-//gameplay function prototypes
-void gameplay(struct tile game_board[ROWS][COLS], 
-    struct tile true_board[ROWS][COLS], 
-    struct game_status *status, struct constants constants);
-void static_instructions(struct tile board[ROWS][COLS], 
-    struct game_status status, struct constants constants, char instruction);
-void move_player_single(struct tile board[ROWS][COLS],  
-    struct game_status *status, char instruction);
-void move_player_dash(struct tile board[ROWS][COLS], 
-    struct game_status *status, char instruction, char instruction2);
-void dash_move(struct tile board[ROWS][COLS], 
-    struct game_status *status, int new_row, int new_col);
-
-void entities_turns(struct tile game_board[ROWS][COLS],
-    struct tile true_board[ROWS][COLS], 
-    struct game_status *status, struct constants constants);
-void boulder_turn(struct tile board[ROWS][COLS], 
-    struct game_status *status, struct constants constants);
-void boulder_move(struct tile board[ROWS][COLS], struct game_status *status, 
-    struct constants constants, int r_offset, int c_offset, int i, int j);
-void boulder_spawn_check(struct tile board[ROWS][COLS], 
-    struct game_status status, struct constants constants,
-    int r_offset, int c_offset, int i, int j);
-
-void lava_turn(struct tile board[ROWS][COLS], struct game_status *status);
-void game_of_lava(struct tile board[ROWS][COLS]);
-void lava_seeds(struct tile board[ROWS][COLS]);
-
-void player_hit(struct tile game_board[ROWS][COLS], 
-    struct tile true_board[ROWS][COLS], struct game_status *status, 
-    struct constants constants);
-void zero_life_ending_sequence(struct tile game_board[ROWS][COLS],
-    struct tile true_board[ROWS][COLS], 
-    struct game_status status, struct constants constants);
-void respawn_sequence(struct tile game_board[ROWS][COLS],
-    struct tile true_board[ROWS][COLS], 
-    struct game_status *status, struct constants constants);
-void respawn_blocked_ending(struct tile game_board[ROWS][COLS],
-    struct tile true_board[ROWS][COLS], 
-    struct game_status *status, struct constants constants);
-
-void illuminate_toggle(struct game_status *status);
-void shadow_toggle(struct game_status *status);
-void illuminate(struct tile game_board[ROWS][COLS], 
-    struct tile true_board[ROWS][COLS], struct game_status status);
-void shadow(struct tile game_board[ROWS][COLS], 
-    struct tile true_board[ROWS][COLS], struct game_status status);
-int check_hidden(struct tile board[ROWS][COLS], 
-    struct game_status status, int i, int j);
-int above_corner_check(struct tile board[ROWS][COLS], 
-    double row, double col, int gradient_x, int gradient_y);
-int below_corner_check(struct tile board[ROWS][COLS], 
-    double row, double col, int gradient_x, int gradient_y);
-
-//helper functions
-void initialise_constants_and_game_status(struct tile true_board[ROWS][COLS],
-    struct game_status *status, struct constants *constants);
+int parse_options(int argc, char *argv[], struct options *options);
+void print_usage(const char *program);
+int play_console(struct options *options);
+void read_console(struct session *session);
+void handle_profile_signal(int signal_number);
 
-int check_valid_placement(struct tile board[ROWS][COLS], int row, int col);
-int validate_grouped_walls(struct tile board[ROWS][COLS], 
-    int start_row, int start_col, int end_row, int end_col);
-int valid_move(struct tile board[ROWS][COLS], int new_row, int new_col);
-
-int entity_counter(struct tile board[ROWS][COLS], enum entity entity_type);
-int update_score(struct tile board[ROWS][COLS], 
-    struct game_status status, int row, int col);
-int calc_max_points_remaining(struct tile board[ROWS][COLS], 
-    struct game_status status);
-double calc_completion_percent(struct tile board[ROWS][COLS], 
-    struct constants constants);
-void check_exit_condition(struct tile board[ROWS][COLS], 
-    struct game_status status);
-void open_exits(struct tile board[ROWS][COLS]);
-
-void print_correct_board(struct tile game_board[ROWS][COLS], 
-    struct tile true_board[ROWS][COLS], 
-    struct game_status status, struct constants constants);
-void print_gravity_direction(struct game_status *status);
-
-void update_command_history(struct game_status *status, char new_command);
-void check_lava_code(struct game_status *status);
-int count_adjacent_lava(struct tile board[ROWS][COLS], int i, int j);
-
-int type_check(struct tile board[ROWS][COLS], int base_row, int base_col);
-void shadow_entire_board(struct tile game_board[ROWS][COLS], 
-    struct tile true_board[ROWS][COLS], struct game_status status);
+volatile sig_atomic_t profile_requested = FALSE;
 
 /*
 ==============================================================================
 ================================= START MAIN =================================
 ==============================================================================
 */
-int main(void) {
-
-    printf("Welcome to CS Caverun!\n\n");
-    printf("--- Game Setup Phase ---\n");
-
-    //set up game and true boards (necessary for illumination) 
-    struct tile game_board[ROWS][COLS];
-    struct tile true_board[ROWS][COLS];
-    initialise_board(game_board);
-    initialise_board(true_board);
-
-    //declare necessary structs
-    struct constants constants;
-    struct game_status status;
-
-    initialise_player_pos(true_board, &constants);
-    add_features(true_board);
-    gameplay(game_board, true_board, &status, constants);
-
-    return 0;
+int main(int argc, char *argv[]) {
+
+    struct options options = {
+        MODE_CONSOLE,
+        {0, NULL, SERVER_DEFAULT_SESSIONS, NULL},
+        {NULL, NULL, 0},
+        {NULL, BENCH_DEFAULT_REPEAT},
+        {0, DIFFERENTIAL_DEFAULT_TURNS},
+        NULL,
+        FALSE,
+        NULL,
+        JOURNAL_KEYFRAME_INTERVAL,
+        NULL,
+        -1,
+        NULL,
+        NULL,
+        FALSE,
+        REALTIME_DEFAULT_TICK_MS,
+        {NULL},
+        0,
+        FALSE
+    };
+    if (!parse_options(argc, argv, &options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (options.mode == MODE_SERVER) {
+        return server_run(&options.server);
+    } else if (options.mode == MODE_BATCH) {
+        return batch_run(&options.batch);
+    } else if (options.mode == MODE_BENCH) {
+        return bench_run(&options.bench);
+    } else if (options.mode == MODE_REPLAY) {
+        return journal_replay(options.replay_path, options.seek_turn, stdout);
+    } else if (options.mode == MODE_WATCH) {
+        return frame_ring_watch(options.frames_path);
+    } else if (options.mode == MODE_SPECTATE) {
+        return broadcast_spectate(options.broadcast_path);
+    } else if (options.mode == MODE_DIFFERENTIAL) {
+        return differential_run(&options.differential);
+    } else if (options.mode == MODE_COOP) {
+        return coop_play(options.coop_paths, options.coop_count,
+            options.tick_ms);
+    }
+    return play_console(&options);
 }
 /*
 ==============================================================================
@@ -293,1038 +155,265 @@ int main(void) {
 
 /*
 ==============================================================================
-============================= START SETUP SECTION ============================
+============================ START CONSOLE SECTION ===========================
 ==============================================================================
 */
 
-//places the player in a valid starting position 
-void initialise_player_pos(struct tile board[ROWS][COLS], 
-    struct constants *constants) {
-
-    int row, col;
-    char valid_starting_pos = FALSE;
-
-    while (valid_starting_pos != TRUE) {
-        printf("Enter the player's starting position: ");
-        scanf("%d %d", &row, &col);
-
-        if (row >= ROWS || row < 0 || 
-            col >= COLS || col < 0) {
-            printf("Position %d %d is invalid!\n", row, col);
-        } else {
-            valid_starting_pos = TRUE;
-        }
-    }
-    board[row][col].entity = PLAYER;
-
-    constants->start_row = row;
-    constants->start_col = col;
-    print_board(board, INITIAL_LIVES);
-}
-
-//adds every possible feature to the game map
-void add_features(struct tile board[ROWS][COLS]) {
-
-    char instruction;
-    printf("Enter map features:\n");
-
-    while (scanf(" %c", &instruction) == 1) {
-        if (instruction == START) {
-            break;
-        } else if (instruction == PLACE_WALL || instruction == PLACE_BOULDER || 
-            instruction == PLACE_GEM || instruction == PLACE_LAVA ||
-            instruction == PLACE_EXIT) {
-            add_single_tile_features(board, instruction);
-        } else if (instruction == PLACE_GROUPED_WALLS) {
-            add_grouped_walls(board);
-        }
-    }
-
-    if (entity_counter(board, GEM) == 0) {
-        open_exits(board);
-    }
-    print_board(board, INITIAL_LIVES);
-}
-
-//adds non-group wall features to the map
-void add_single_tile_features(struct tile board[ROWS][COLS], char instruction) {
-
-    int row = 0;
-    int col = 0;
-
-    //read 2 integers for single-tile features
-    scanf("%d %d", &row, &col);
-
-    if (check_valid_placement(board, row, col)) {
-        if (instruction == PLACE_WALL) {
-            board[row][col].entity = WALL;
-        } else if (instruction == PLACE_BOULDER) {
-            board[row][col].entity = BOULDER;
-        } else if (instruction == PLACE_GEM) {
-            board[row][col].entity = GEM;
-        } else if (instruction == PLACE_LAVA) {
-            board[row][col].has_lava = TRUE;
-        } else if (instruction == PLACE_EXIT) {
-            board[row][col].entity = EXIT_LOCKED;
-        }
-    }
-}
-
-//places walls on each tile in the rectangular bound
-void add_grouped_walls(struct tile board[ROWS][COLS]) {
-
-    int start_row, start_col, end_row, end_col;
-    scanf("%d %d %d %d", &start_row, &start_col, &end_row, &end_col);
-    
-    if (validate_grouped_walls(board, start_row, start_col, end_row, end_col)) {
-        for (int i = start_row; i <= end_row; i++) {
-            for (int j = start_col; j <= end_col; j++) {
-                board[i][j].entity = WALL;
-            }
-        }
-    }
-}
-
-/*
-==============================================================================
-============================ END SETUP SECTION ===============================
-==============================================================================
-*/
-
-/*
-==============================================================================
-========================= START GAMEPLAY SECTION =============================
-==============================================================================
-*/
-
-//handles gameplay loop
-void gameplay(struct tile game_board[ROWS][COLS], struct tile true_board[ROWS]
-    [COLS], struct game_status *status, struct constants constants) {
-
-    initialise_constants_and_game_status(true_board, status, &constants); 
-    char instruction, instruction2;
-
-    while (scanf(" %c", &instruction) == 1) {
-        update_command_history(status, instruction);
-        check_lava_code(status);
-        
-        //must pass turn if instruction is L to not trigger any events
-        if (instruction == LAVA_TRIGGER) {
-        } else if (!isupper(instruction)) {
-            if (instruction == ILLUMINATE) {
-                illuminate_toggle(status);
-                print_correct_board(game_board, true_board, *status, constants);
-            } else if (instruction == SHADOW) {
-                shadow_toggle(status);
-                print_correct_board(game_board, true_board, *status, constants);
-            } else if (instruction == GRAVITY) {
-                print_gravity_direction(status);
-                entities_turns(game_board, true_board, status, constants);
-            } else if (instruction == QUIT || instruction == PRINT_SCORE || 
-                instruction == PRINT_MAP_STATS) {
-                static_instructions(true_board, 
-                    *status, constants, instruction);
-            } else {
-                move_player_single(true_board, status, instruction);
-                entities_turns(game_board, true_board, status, constants);
+//reads the command line, returns FALSE if it doesn't make sense
+int parse_options(int argc, char *argv[], struct options *options) {
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+            options->server.port = atoi(argv[++i]);
+            options->mode = MODE_SERVER;
+        } else if (strcmp(argv[i], "--server-unix") == 0 && i + 1 < argc) {
+            options->server.unix_path = argv[++i];
+            options->mode = MODE_SERVER;
+        } else if (strcmp(argv[i], "--max-sessions") == 0 && i + 1 < argc) {
+            options->server.max_sessions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            options->server.level_path = argv[++i];
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            options->batch.input = argv[++i];
+            options->mode = MODE_BATCH;
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            options->batch.output = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options->batch.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            options->bench.directory = argv[++i];
+            options->mode = MODE_BENCH;
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            options->bench.repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--differential") == 0 && i + 1 < argc) {
+            options->differential.seeds = atoi(argv[++i]);
+            options->mode = MODE_DIFFERENTIAL;
+        } else if (strcmp(argv[i], "--turns") == 0 && i + 1 < argc) {
+            options->differential.turns = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--settle") == 0) {
+            session_rules.settle = TRUE;
+        } else if (strcmp(argv[i], "--shadowcast") == 0) {
+            session_rules.shadowcast = TRUE;
+        } else if (strcmp(argv[i], "--shadow-check") == 0) {
+            session_rules.shadow_check = TRUE;
+        } else if (strcmp(argv[i], "--render-every") == 0 && i + 1 < argc) {
+            session_rules.render_every = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--render-ms") == 0 && i + 1 < argc) {
+            session_rules.render_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--render-events") == 0) {
+            session_rules.render_events = TRUE;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options->trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            options->frames_path = argv[++i];
+        } else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc) {
+            options->frames_path = argv[++i];
+            options->mode = MODE_WATCH;
+        } else if (strcmp(argv[i], "--broadcast") == 0 && i + 1 < argc) {
+            options->broadcast_path = argv[++i];
+        } else if (strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+            options->broadcast_path = argv[++i];
+            options->mode = MODE_SPECTATE;
+        } else if (strcmp(argv[i], "--realtime") == 0) {
+            options->realtime = TRUE;
+        } else if (strcmp(argv[i], "--coop") == 0 && i + 1 < argc) {
+            if (options->coop_count == COOP_MAX_PLAYERS - 1) {
+                return FALSE;
             }
+            options->coop_paths[options->coop_count++] = argv[++i];
+            options->mode = MODE_COOP;
+        } else if (strcmp(argv[i], "--tick") == 0 && i + 1 < argc) {
+            options->tick_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bulk-setup") == 0) {
+            options->bulk_setup = TRUE;
+        } else if (strcmp(argv[i], "--pipeline") == 0) {
+            options->pipeline = TRUE;
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            options->journal_path = argv[++i];
+        } else if (strcmp(argv[i], "--keyframes") == 0 && i + 1 < argc) {
+            options->keyframe_interval = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options->replay_path = argv[++i];
+            options->mode = MODE_REPLAY;
+        } else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+            options->seek_turn = atoi(argv[++i]);
         } else {
-            scanf(" %c", &instruction2);
-            if (status->can_dash) {
-                move_player_dash(true_board, status, instruction, instruction2);
-                entities_turns(game_board, true_board, status, constants);
-            } else {
-                printf("You're out of breath! Skipping dash move...\n");
-                status->can_dash = TRUE; 
-                print_correct_board(game_board, true_board, *status, constants);
-            }
+            return FALSE;
         }
     }
-}
-
-//handles all static instructions
-void static_instructions(struct tile board[ROWS][COLS], 
-    struct game_status status, struct constants constants, char instruction) {
-
-    if (instruction == QUIT) {
-        printf("--- Quitting Game ---\n");
-        exit(0);
-    } else if (instruction == PRINT_SCORE) {
-        printf("You have %d point(s)!\n", status.score);
-    } else if (instruction == PRINT_MAP_STATS) {
-        int maximum_points_remaining = calc_max_points_remaining(board, status);
-        double completion_percent = calc_completion_percent(board, constants);
-
-        print_map_statistics(entity_counter(board, DIRT), 
-        entity_counter(board, GEM), entity_counter(board, BOULDER), 
-        completion_percent, maximum_points_remaining);
-    }
-}
-
-//moves player by a single tile
-void move_player_single(struct tile board[ROWS][COLS], 
-    struct game_status *status, char instruction) {
-
-    int new_row = status->player_row + D_ROW[(int) instruction];
-    int new_col = status->player_col + D_COL[(int) instruction];
-
-    if (valid_move(board, new_row, new_col)) {
-        status->score += update_score(board, *status, new_row, new_col);
-        //makes the current tile empty
-        board[status->player_row][status->player_col].entity = EMPTY; 
-        status->player_row = new_row;
-        status->player_col = new_col;
-        //if player is on exit tile, exits the game
-        check_exit_condition(board, *status);
-        //makes the new tile the player
-        board[status->player_row][status->player_col].entity = PLAYER;
-    }
-    status->can_dash = TRUE;
-}
-
-//moves player by multiple tiles if dash is valid
-void move_player_dash(struct tile board[ROWS][COLS], 
-    struct game_status *status, char instruction, char instruction2) {
-    
-    //immediately ensures the next action cannot be a dash
-    status->can_dash = FALSE; 
-    
-    //maps first movement instruction to new board location
-    int new_row1 = status->player_row + D_ROW[(int) instruction];
-    int new_col1 = status->player_col + D_COL[(int) instruction];
-    if (!valid_move(board, new_row1, new_col1)) {
-        return;  
-    }
-    //apply first move
-    dash_move(board, status, new_row1, new_col1);
-
-    //maps second movement instruction to new board location
-    int new_row2 = status->player_row + D_ROW[(int) instruction2];
-    int new_col2 = status->player_col + D_COL[(int) instruction2];
-    if (!valid_move(board, new_row2, new_col2)) {
-        board[status->player_row][status->player_col].entity = PLAYER; 
-        return;
-    }
-    //apply second move
-    dash_move(board, status, new_row2, new_col2);
-    board[status->player_row][status->player_col].entity = PLAYER;
-}
-
-//applies the move once it's valid
-void dash_move(struct tile board[ROWS][COLS], 
-    struct game_status *status, int new_row, int new_col) {
-
-    status->score += update_score(board, *status, new_row, new_col);
-    board[status->player_row][status->player_col].entity = EMPTY; 
-    status->player_row = new_row;
-    status->player_col = new_col;
-
-    check_exit_condition(board, *status);
-}
-
-//control movement and logic of all boulder and lava entities
-void entities_turns(struct tile game_board[ROWS][COLS],
-    struct tile true_board[ROWS][COLS], 
-    struct game_status *status, struct constants constants) {
-
-    boulder_turn(true_board, status, constants);
-    if (status->boulder_hit) {
-        player_hit(game_board, true_board, status, constants);
-    }
-
-    lava_turn(true_board, status);
-    if (status->lava_hit) {
-        player_hit(game_board, true_board, status, constants);
+    return options->server.max_sessions > 0 && options->bench.repeat >= 0 &&
+        options->keyframe_interval > 0 && session_rules.render_every >= 0 &&
+        options->differential.seeds >= 0 && options->differential.turns > 0 &&
+        session_rules.render_ms >= 0 && options->tick_ms > 0;
+}
+
+//explains the command line
+void print_usage(const char *program) {
+
+    fprintf(stderr, "Usage: %s [--pipeline] [--frames RING] "
+        "[--broadcast SOCKET] [--trace FILE]\n"
+        "           [--journal FILE [--keyframes N]] "
+        "[--realtime [--tick MS]] [--bulk-setup]\n", program);
+    fprintf(stderr, "       %s --server PORT | --server-unix PATH "
+        "[--max-sessions N]\n"
+        "           [--level FILE]\n", program);
+    fprintf(stderr, "       %s --batch DIRECTORY|MANIFEST [--output FILE] "
+        "[--threads N]\n", program);
+    fprintf(stderr, "       %s --bench DIRECTORY [--repeat N]\n", program);
+    fprintf(stderr, "       %s --differential SEEDS [--turns N]\n", program);
+    fprintf(stderr, "       %s --replay JOURNAL [--seek TURN]\n", program);
+    fprintf(stderr, "       %s --watch RING\n", program);
+    fprintf(stderr, "       %s --spectate SOCKET\n", program);
+    fprintf(stderr, "       %s --coop PLAYER [--coop PLAYER]... "
+        "[--tick MS]\n", program);
+    fprintf(stderr, "--settle in any mode makes boulders fall all the way "
+        "to rest every turn\n");
+    fprintf(stderr, "--shadowcast in any mode works out shadows in one "
+        "sweep, --shadow-check\nreports to stderr where that disagrees "
+        "with the ray per tile\n");
+    fprintf(stderr, "--render-every N, --render-ms T and --render-events in "
+        "any mode print fewer boards\n");
+}
+
+//plays one game on stdin and stdout, optionally tracing and journalling
+//every turn
+int play_console(struct options *options) {
+
+    static struct session session;
+    static struct journal journal;
+    static struct pipeline pipeline;
+    static struct frame_ring frames;
+    static struct broadcast broadcast;
+    static struct occupancy_index occupancy;
+
+#ifdef CAVERUN_PROFILE
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_profile_signal;
+    sigaction(SIGUSR1, &action, NULL);
+    profile_active = TRUE;
+#endif
+
+    if (options->trace_path != NULL && !trace_open(options->trace_path)) {
+        return 1;
+    }
+    if (options->journal_path != NULL && !journal_open(&journal, 
+        options->journal_path, options->keyframe_interval, 
+        session_rules.settle)) {
+        return 1;
+    }
+
+    if (options->frames_path != NULL && 
+        !frame_ring_open(&frames, options->frames_path)) {
+        return 1;
+    }
+    if (options->broadcast_path != NULL && 
+        !broadcast_open(&broadcast, options->broadcast_path)) {
+        return 1;
+    }
+    if (options->pipeline && !pipeline_start(&pipeline, stdout)) {
+        return 1;
+    }
+    session_begin(&session, options->pipeline ? 
+        pipeline_stream(&pipeline) : stdout);
+    if (options->journal_path != NULL) {
+        session.journal = &journal;
+    }
+    if (options->pipeline) {
+        session.pipeline = &pipeline;
+    }
+    if (options->frames_path != NULL) {
+        session.frames = &frames;
+    }
+    if (options->broadcast_path != NULL) {
+        session.broadcast = &broadcast;
+    }
+    if (options->bulk_setup) {
+        session.occupancy = &occupancy;
+    }
+    if (options->realtime) {
+        realtime_play(&session, options->tick_ms);
     } else {
-        print_correct_board(game_board, true_board, *status, constants);
+        read_console(&session);
     }
-}
-
-//boulder movement based on direction of gravity 
-void boulder_turn(struct tile board[ROWS][COLS], 
-    struct game_status *status, struct constants constants) {
-
-    if (status->gravity == GRAVITY_UP) {
-        for (int i = 0; i < LAST_ROW; i++) {
-            for (int j = 0; j < COLS; j++) {
-                boulder_move(board, status, constants, 1, 0, i, j);
-            }
-        }
-    } else if (status->gravity == GRAVITY_DOWN) {
-        for (int i = LAST_ROW; i > 0; i--) {
-            for (int j = 0; j < COLS; j++) {
-                boulder_move(board, status, constants, -1, 0, i, j);
-            }
-        }
-    } else if (status->gravity == GRAVITY_LEFT) {
-        for (int j = 0; j < LAST_COL; j++) {
-            for (int i = 0; i < ROWS; i++) {
-                boulder_move(board, status, constants, 0, 1, i, j);
-            }
-        }
-    } else if (status->gravity == GRAVITY_RIGHT) {
-        for (int j = LAST_COL; j > 0; j--) {
-            for (int i = 0; i < ROWS; i++) {
-                boulder_move(board, status, constants, 0, -1, i, j);
-            }
-        }
+    session_finish(&session);
+    if (session.pipeline != NULL) {
+        pipeline_stop(&pipeline);
     }
-}
-
-//physically moves the boulders
-void boulder_move(struct tile board[ROWS][COLS], struct game_status *status,
-    struct constants constants, int r_offset, int c_offset, int i, int j) {
-
-    ///boulder hits player and spawn is currently occupied
-    if (board[i][j].entity == PLAYER && 
-        board[i + r_offset][j + c_offset].entity == BOULDER && 
-        board[constants.start_row]
-        [constants.start_col].entity != EMPTY) {
-        boulder_spawn_check(board, *status, 
-            constants, r_offset, c_offset, i, j);
-        status->boulder_hit = TRUE;
+    if (session.frames != NULL) {
+        frame_ring_close(&frames);
     }
-    //boulder moves down into space
-    else if (board[i][j].entity == EMPTY && 
-        board[i + r_offset][j + c_offset].entity == BOULDER) {
-        board[i][j].entity = BOULDER;
-        board[i + r_offset][j + c_offset].entity = EMPTY;
+    if (session.broadcast != NULL) {
+        broadcast_close(&broadcast);
     }
-    //boulder hits player on 1 life
-    if (board[i][j].entity == PLAYER && 
-        board[i + r_offset][j + c_offset].entity == BOULDER && 
-        status->lives == 1) {
-        board[i + r_offset][j + c_offset].entity = EMPTY;
-        status->boulder_hit = TRUE;
-    } 
-    //boulder hits player on 2+ lives
-    else if (board[i][j].entity == PLAYER && 
-        board[i + r_offset][j + c_offset].entity == BOULDER && 
-        status->lives > 1) {
-        board[i][j].entity = BOULDER;
-        board[i + r_offset][j + c_offset].entity = EMPTY;
-        status->boulder_hit = TRUE;
-    }  
-}
-
-//checks whether that the boulder that hits the player will be at spawn
-//after hit
-void boulder_spawn_check(struct tile board[ROWS][COLS], 
-    struct game_status status, struct constants constants, 
-    int r_offset, int c_offset, int i, int j) {
-
-    //is spawn is occupied by a boulder?
-    if (board[constants.start_row][constants.start_col].entity == BOULDER) {
-        //if so, is it the same boulder that is going to hit the player?
-        if (i + r_offset == constants.start_row && 
-            j + c_offset == constants.start_col) {
-            board[i + r_offset][j + c_offset].entity = EMPTY;
-            board[i][j].entity = BOULDER;
-        } else {
-            board[i + r_offset][j + c_offset].entity = EMPTY;
-        }
-    } else {
-        board[i + r_offset][j + c_offset].entity = EMPTY;
-    }
-}
-
-
-//handles lava movement and damage
-void lava_turn(struct tile board[ROWS][COLS], struct game_status *status) {
-
-    if (status->lava_mode == GAME_OF_LAVA) {
-        game_of_lava(board);
-    } else if (status->lava_mode == LAVA_SEEDS) {
-        lava_seeds(board);
+    trace_close();
+    int status = 0;
+    if (session.journal != NULL && !journal_close(&journal)) {
+        status = 1;
     }
 
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            if (board[i][j].entity == PLAYER && board[i][j].has_lava) {
-                board[i][j].entity = EMPTY;
-                status->lava_hit = TRUE;
-            }
-        }
-    }
+#ifdef CAVERUN_PROFILE
+    fflush(stdout);
+    print_profile(stderr);
+#endif
+    return status;
 }
 
-//handles the logic for lava birth, survival and death in game of lava
-void game_of_lava(struct tile board[ROWS][COLS]) {
+//plays statements from stdin as they come until the game or input ends
+void read_console(struct session *session) {
 
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            int adjacent_lava_count = count_adjacent_lava(board, i, j);
-            if (!board[i][j].has_lava && adjacent_lava_count == 
-                LAVA_GAME_BIRTH_COUNT) {
-                board[i][j].next_turn_lava = TRUE;
-            } else if (board[i][j].has_lava && 
-                (adjacent_lava_count == LAVA_SURVIVE_MIN || 
-                adjacent_lava_count == LAVA_SURVIVE_MAX)) {
-                board[i][j].next_turn_lava = TRUE;
-            } else if (board[i][j].has_lava && 
-                (adjacent_lava_count < LAVA_SURVIVE_MIN || 
-                adjacent_lava_count > LAVA_SURVIVE_MAX)) {
-                board[i][j].next_turn_lava = FALSE;
-            }
-        }
-    }
+    static char input[CONSOLE_INPUT_SIZE];
+    int input_length = 0;
+    int at_eof = FALSE;
 
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            board[i][j].has_lava = board[i][j].next_turn_lava;
-            board[i][j].next_turn_lava = FALSE;
-        }
-    }
-}
-
-//handles the logic for lava birth, survival and death in lava seeds
-void lava_seeds(struct tile board[ROWS][COLS]) {
-
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            int adjacent_lava_count = count_adjacent_lava(board, i , j);
-            if (!board[i][j].has_lava && adjacent_lava_count == 
-                LAVA_SEED_BIRTH_COUNT) {
-                board[i][j].next_turn_lava = TRUE;
-            } else {
-                board[i][j].next_turn_lava = FALSE;
-            }
-        }
-    }
-
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            board[i][j].has_lava = board[i][j].next_turn_lava;
-            board[i][j].next_turn_lava = FALSE;
-        }
-    }
-}
-
-//handles consequences of player being hit by boulder of lava
-void player_hit(struct tile game_board[ROWS][COLS],  
-    struct tile true_board[ROWS][COLS], struct game_status *status, 
-    struct constants constants) {
-
-    (status->lives)--;
-    if (status->lives == 0) {
-        zero_life_ending_sequence(game_board, true_board, *status, constants);
-    } else {
-        //respawn point is clear
-        if (true_board[constants.start_row]
-            [constants.start_col].entity == EMPTY &&
-            true_board[constants.start_row]
-            [constants.start_col].has_lava == FALSE) {
-            respawn_sequence(game_board, true_board, status, constants);
-        } 
-        else if (status->lava_mode == LAVA_NONE) {
-            printf("Respawn blocked! Game over. Final score: %d points.\n", 
-                status->score);
-            respawn_blocked_ending(game_board, true_board, status, constants);
+    while (!at_eof && session->phase != PHASE_OVER) {
+        //prompts have no newline, so they must be out before waiting
+        if (session->pipeline != NULL) {
+            pipeline_publish(session->pipeline, NULL, 0);
         } else {
-            printf("Respawn blocked! You're toast! Final score: %d points.\n", 
-                status->score);
-            respawn_blocked_ending(game_board, true_board, status, constants);
+            fflush(stdout);
         }
-    }
-}
-
-//ending sequence for if the player runs out of lives
-void zero_life_ending_sequence(struct tile game_board[ROWS][COLS],
-    struct tile true_board[ROWS][COLS], 
-    struct game_status status, struct constants constants) {
-    
-    true_board[status.player_row][status.player_col].entity = PLAYER;
-    printf("Game Lost! You scored %d points!\n", status.score);
-    print_correct_board(game_board, true_board, status, constants);
-    exit(0);
-}
-
-//respawn sequence for when spawn isn't obstructed
-void respawn_sequence(struct tile game_board[ROWS][COLS],
-    struct tile true_board[ROWS][COLS], 
-    struct game_status *status, struct constants constants) {
-    
-    printf("Respawning!\n");
-
-    true_board[constants.start_row][constants.start_col].entity = PLAYER;
-    status->player_row = constants.start_row;
-    status->player_col = constants.start_col;
-
-    if (status->boulder_hit) {
-        status->boulder_hit = FALSE;
-    } else if (status->lava_hit) {
-        status->lava_hit = FALSE;
-        print_correct_board(game_board, true_board, *status, constants);
-    }
-}
-
-//ending sequence for when spawn is obstructed
-void respawn_blocked_ending(struct tile game_board[ROWS][COLS],
-    struct tile true_board[ROWS][COLS], 
-    struct game_status *status, struct constants constants) {
-    
-    status->shadow_entire_board = TRUE;
-    true_board[status->player_row][status->player_col].entity = PLAYER;
-    print_correct_board(game_board, true_board, *status, constants);
-    exit(0);
-}
-
-//toggles the state of the illumination flag
-void illuminate_toggle(struct game_status *status) {
-
-    scanf("%d", &status->illumination_radius);
-
-    if (status->illumination_radius <= 0) {
-        status->illumination = FALSE;
-        printf("Illumination Mode: Deactivated\n");
-    } else {
-        status->illumination = TRUE;
-        printf("Illumination Mode: Activated\n");
-    }
-}
-
-//toggles the state of the shadowed flag
-void shadow_toggle(struct game_status *status) {
-
-    if (status->shadowed == FALSE) {
-        printf("Shadow Mode: Activated\n");
-        status->shadowed = TRUE;
-    } else {
-        printf("Shadow Mode: Deactivated\n");
-        status->shadowed = FALSE;
-    }
-}
-
-//maps the true board to the game board, with hidden tiles based on radius
-void illuminate(struct tile game_board[ROWS][COLS], 
-    struct tile true_board[ROWS][COLS], struct game_status status) {
-
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            game_board[i][j].has_lava = true_board[i][j].has_lava;
-            double distance = 
-                sqrt((i - status.player_row) * (i - status.player_row) + 
-                (j - status.player_col) * (j - status.player_col));
-            if (distance <= status.illumination_radius) {
-                game_board[i][j].entity = true_board[i][j].entity;
-            } else {
-                game_board[i][j].entity = HIDDEN;
-            }
-        }
-    }
-}
-
-//maps the true board to the game board, with hidden tiles based on shadows
-void shadow(struct tile game_board[ROWS][COLS], 
-    struct tile true_board[ROWS][COLS], struct game_status status) {
-
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            int hide = 0;
-            game_board[i][j].has_lava = true_board[i][j].has_lava;
-            if (true_board[i][j].entity != PLAYER) {
-                hide = check_hidden(true_board, status, i, j);
-            }
-            if (!hide) {
-                game_board[i][j].entity = true_board[i][j].entity;
-            } else {
-                game_board[i][j].entity = HIDDEN;
-            }
-        }
-    }
-}
-
-//checks each tile and whether it should be hidden using rays
-int check_hidden(struct tile board[ROWS][COLS], 
-    struct game_status status, int i, int j) {
-
-    int start_x = status.player_row;
-    int start_y = status.player_col;
-    int gradient_x = i - start_x;
-    int gradient_y = j - start_y;
-    int corner_blocked_above = FALSE;
-    int corner_blocked_below = FALSE;
-
-    for (double lambda = 0; lambda < 1; lambda += SHADOW_RAY_STEP) {
-        double raw_row = start_x + lambda * gradient_x;
-        double raw_col = start_y + lambda * gradient_y;
-        int current_row = (int)(round(raw_row));
-        int current_col = (int)(round(raw_col));
-
-        //stop before reaching the actual tile as to not give false positives
-        if (raw_row >= i - 0.5 && raw_row <= i + 0.5 &&
-            raw_col >= j - 0.5 && raw_col <= j + 0.5) {
-            break;
-        }
-        //corner check
-        if (fabs(fmod(raw_row, 1.0) - 0.5) < EPSILON &&
-            fabs(fmod(raw_col, 1.0) - 0.5) < EPSILON) {
-            corner_blocked_above |= above_corner_check(board, 
-                raw_row, raw_col, gradient_x, gradient_y);
-            corner_blocked_below |= below_corner_check(board, 
-                raw_row, raw_col, gradient_x , gradient_y);
-        } else {
-            char type = board[current_row][current_col].entity;
-            if (type == WALL || type == BOULDER || type == GEM) {
-                return TRUE;
-            }
-        }
-    }
-
-    if (corner_blocked_above && corner_blocked_below) {
-        return TRUE;
-    } else {
-        return FALSE; 
-    }
-}
-
-//checks whether one of the tiles directly above the corner causes a blocked ray
-int above_corner_check(struct tile board[ROWS][COLS], 
-    double row, double col, int gradient_x, int gradient_y) {
-
-    int base_row = (int)(floor(row));
-    int base_col;
-
-    /*
-    this check determines whether to check the left or right side of the
-    corner since at the very last corner, you don't want to check the actual
-    tile itself and give a false positive
-    */
-    if (gradient_x * gradient_y > 0) {
-        base_col = (int)(ceil(col));
-    } else {
-        base_col = (int)(floor(col));
-    }
-    return (type_check(board, base_row, base_col));
-}
-
-//checks whether one of the tiles directly below the corner causes a blocked ray
-int below_corner_check(struct tile board[ROWS][COLS], 
-    double row, double col, int gradient_x, int gradient_y) {
-
-    int base_row = (int)(ceil(row));
-    int base_col;
-
-    /*
-    this check determines whether to check the left or right side of the
-    corner since at the very last corner, you don't want to check the actual
-    tile itself and give a false positive
-    */
-    if (gradient_x * gradient_y > 0) {
-        base_col = (int)(floor(col));
-    } else {
-        base_col = (int)(ceil(col));
-    }
-    return (type_check(board, base_row, base_col));
-}
-
-/*
-==============================================================================
-=========================== END GAMEPLAY SECTION =============================
-==============================================================================
-*/
-
-/*
-==============================================================================
-=========================== START HELPER SECTION =============================
-==============================================================================
-*/
-
-//initialises every constant and variable in the structs
-void initialise_constants_and_game_status(struct tile true_board[ROWS][COLS],
-    struct game_status *status, struct constants *constants) {
-
-    printf("--- Gameplay Phase ---\n"); 
-
-    status->player_row = constants->start_row;
-    status->player_col = constants->start_col; 
-    constants->init_dirt = entity_counter(true_board, DIRT);
-    constants->init_gem = entity_counter(true_board, GEM);
-
-    status->score = 0;
-    status->can_dash = TRUE;
-    status->boulder_hit = FALSE;
-    status->lava_hit = FALSE;
-    status->lives = INITIAL_LIVES;
-
-    status->illumination = FALSE;
-    status->illumination_radius = 0;
-    status->shadowed = FALSE;
-    status->shadow_entire_board = FALSE;
-    status->gravity = GRAVITY_DOWN;
-    status->lava_mode = LAVA_NONE;
-
-    for (int i = 0; i < CMD_HISTORY_LENGTH; i++) {
-        status->cmd_history[i] = 0;
-    }
-}
-
-//determines whether a tile placement is valid
-int check_valid_placement(struct tile board[ROWS][COLS], int row, int col) {
-
-    int valid_placement = TRUE;
-
-    if (row < 0 || row >= ROWS || 
-        col < 0 || col >= COLS) {
-        printf("Invalid location: position is not on map!\n");
-        valid_placement = FALSE;
-    } else if (board[row][col].entity != DIRT) {
-        printf("Invalid location: tile is occupied!\n");
-        valid_placement = FALSE;
-    } 
-    return valid_placement;
-}
-
-//determines whether any tile in the rectangular bound is invalid to place on
-int validate_grouped_walls(struct tile board[ROWS][COLS], 
-    int start_row, int start_col, int end_row, int end_col) {
-
-    //validate map rectangle bounds
-    if (start_row < 0 || start_row >= ROWS || 
-        start_col < 0 || start_col >= COLS ||
-        end_row < 0 || end_row >= ROWS || 
-        end_col < 0 || end_col >= COLS) {
-        printf("Invalid location: feature cannot be placed here!\n");
-        return FALSE;
-    } 
-    //validates tile occupation i.e. all tiles need to be free
-    int is_occupied = FALSE;
-    for (int i = start_row; i <= end_row; i++) {
-        for (int j = start_col; j <= end_col; j++) {
-            if (board[i][j].entity != DIRT) {
-                is_occupied = TRUE;
-                //saves unnecessary checking once one invalid tile is found
-                break;
-            }
-        }
-    }
-
-    if (is_occupied) {
-        printf("Invalid location: feature cannot be placed here!\n");
-        return FALSE;
-    } else {
-        return TRUE;
-    }            
-}
-
-//checks whether movement will arrive at a valid destination
-int valid_move(struct tile board[ROWS][COLS], int new_row, int new_col) {
-
-    return (new_row >= 0 && new_row < ROWS &&
-        new_col >= 0 && new_col < COLS &&
-        (board[new_row][new_col].entity == EMPTY ||
-        board[new_row][new_col].entity == DIRT ||
-        board[new_row][new_col].entity == GEM ||
-        board[new_row][new_col].entity == EXIT_UNLOCKED));
-}
-
-//counts how many type of a certain entity are currently on the board
-int entity_counter(struct tile board[ROWS][COLS], enum entity entity_type) {
-    int counter = 0; 
-
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            if (board[i][j].entity == entity_type) {
-                counter++;
-            }
+        if (session->broadcast != NULL) {
+            broadcast_poll(session->broadcast);
         }
-    }
-    return counter;
-}
-
-//updates the score based on dirt and gem collection
-int update_score(struct tile board[ROWS][COLS], 
-    struct game_status status, int row, int col) {
-        
-    if (board[row][col].entity == DIRT) {
-        if (status.lava_mode != LAVA_NONE) {
-            return POINTS_DIRT_LAVA;
-        } else {
-            return POINTS_DIRT_NORMAL;
+        ssize_t count = read(STDIN_FILENO, input + input_length,
+            CONSOLE_INPUT_SIZE - input_length);
+        //a read interrupted by a signal, e.g. SIGUSR1, is just tried again
+        if (count > 0) {
+            input_length += count;
+        } else if (count == 0 || errno != EINTR) {
+            at_eof = TRUE;
         }
-    } else if (board[row][col].entity == GEM) {
-        board[row][col].entity = EMPTY;
-        if (status.lava_mode != LAVA_NONE) {
-            return POINTS_GEM_LAVA;
-        } else {
-            return POINTS_GEM_NORMAL;
+        if (profile_requested) {
+            profile_requested = FALSE;
+            print_profile(stderr);
         }
-    }
-    return 0;
-}
-
-//calculates the maximum remaining points depending on game mode
-int calc_max_points_remaining(struct tile board[ROWS][COLS], 
-    struct game_status status) {
-    
-    int maximum_points_remaining;
-    if (status.lava_mode != LAVA_NONE) {
-        maximum_points_remaining = (entity_counter(board, DIRT) * 
-        POINTS_DIRT_LAVA) + (entity_counter(board, GEM) * POINTS_GEM_LAVA);
-    } else {
-        maximum_points_remaining = entity_counter(board, DIRT) * 
-        POINTS_DIRT_NORMAL + 
-        (entity_counter(board, GEM) * POINTS_GEM_NORMAL);
-    }
-    return maximum_points_remaining;
-}
-
-//calculates how much of the map the player has explored
-double calc_completion_percent(struct tile board[ROWS][COLS], 
-    struct constants constants) {
-
-    double completion_percentage = 100.0 * 
-    (1.0 - (double)(entity_counter(board, DIRT) + entity_counter(board, GEM)) /
-    (constants.init_dirt + constants.init_gem));
-
-    return completion_percentage;
-}
-
-//determines whether to open the exits based on how many gems remaining 
-void check_exit_condition(struct tile board[ROWS][COLS], 
-    struct game_status status) {
-
-    if (entity_counter(board, GEM) == 0) {
-        open_exits(board);
-    }
-
-    if (board[status.player_row][status.player_col].entity == EXIT_UNLOCKED) {
-        board[status.player_row][status.player_col].entity = PLAYER;
-        print_board(board, status.lives);
-        printf("You Win! Final Score: %d point(s)!\n", status.score);
-        exit(0);
-    }
-}
-
-//opens all exits on the map
-void open_exits(struct tile board[ROWS][COLS]) {
 
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            if (board[i][j].entity == EXIT_LOCKED) {
-                board[i][j].entity = EXIT_UNLOCKED;
-            }
+        int used = 0;
+        int step;
+        while ((step = session_step(session, input + used, 
+            input_length - used, at_eof)) > 0) {
+            used += step;
+            trace_flush_if_needed();
         }
-    }
-}
-
-//prints either the game or true board depending on illumination mode
-void print_correct_board(struct tile game_board[ROWS][COLS], 
-    struct tile true_board[ROWS][COLS], 
-    struct game_status status, struct constants constants) {
-    
-    if (status.shadow_entire_board && status.shadowed) {
-        shadow_entire_board(game_board, true_board, status);
-        print_board(game_board, status.lives);
-    } else if (status.shadowed) {
-        shadow(game_board, true_board, status);
-        print_board(game_board, status.lives);
-    } else if (status.illumination) {
-        illuminate(game_board, true_board, status);
-        print_board(game_board, status.lives);
-    } else {
-        print_board(true_board, status.lives);
-    } 
-}
-
-//prints messages after gravity direction is changed
-void print_gravity_direction(struct game_status *status) {
-
-    scanf(" %c", &status->gravity);
-    if (status->gravity == GRAVITY_UP) {
-        printf("Gravity now pulls UP!\n");
-    } else if (status->gravity == GRAVITY_DOWN) {
-        printf("Gravity now pulls DOWN!\n");
-    } else if (status->gravity == GRAVITY_LEFT) {
-        printf("Gravity now pulls LEFT!\n");
-    } else if (status->gravity == GRAVITY_RIGHT) {
-        printf("Gravity now pulls RIGHT!\n");
-    }
-}
-
-//intakes new commands to check whether lava mode should be activated
-void update_command_history(struct game_status *status, char new_command) {
-
-    for (int i = 0; i < CMD_HISTORY_LENGTH - 1; i++) {
-        status->cmd_history[i] = status->cmd_history[i + 1];
-    }
-    status->cmd_history[CMD_HISTORY_LENGTH - 1] = new_command;
-}
-
-//checks whether the command history matches a lava code
-void check_lava_code(struct game_status *status) {
-
-    if (status->cmd_history[0] == UP_SINGLE && 
-        status->cmd_history[1] == RIGHT_SINGLE &&
-        status->cmd_history[2] == DOWN_SINGLE && 
-        status->cmd_history[3] == LEFT_SINGLE &&
-        status->cmd_history[4] == LAVA_TRIGGER) {
-        if (status->lava_mode != GAME_OF_LAVA) {
-            printf("Game Of Lava: Activated\n");
+        //a statement longer than the whole buffer is played as it is
+        if (used == 0 && input_length == CONSOLE_INPUT_SIZE) {
+            used = session_step(session, input, input_length, TRUE);
         }
-        status->lava_mode = GAME_OF_LAVA;
-    } else if (status->cmd_history[0] == UP_SINGLE && 
-        status->cmd_history[1] == LEFT_SINGLE &&
-        status->cmd_history[2] == DOWN_SINGLE && 
-        status->cmd_history[3] == RIGHT_SINGLE &&
-        status->cmd_history[4] == LAVA_TRIGGER) {
-        if (status->lava_mode != LAVA_SEEDS) {
-            printf("Lava Seeds: Activated\n");
-        }
-        status->lava_mode = LAVA_SEEDS;
+        memmove(input, input + used, input_length - used);
+        input_length -= used;
     }
 }
 
-//counts all 8 tiles around a tile and how many of them are lava
-int count_adjacent_lava(struct tile board[ROWS][COLS], int i, int j) {
-
-    int adjacent_lava_counter = 0;
-
-    //modulus used for wraparound tiles in the first/last row/column
-    if (board[(10 + i - 1) % ROWS][(10 + j - 1) % COLS].has_lava) {
-        adjacent_lava_counter++;
-    } 
-    if (board[(10 + i - 1) % ROWS][j].has_lava) {
-        adjacent_lava_counter++;
-    } 
-    if (board[(10 + i - 1) % ROWS][(j + 1) % COLS].has_lava) {
-        adjacent_lava_counter++;
-    } 
-    if (board[i][(10 + j - 1) % COLS].has_lava) {
-        adjacent_lava_counter++;
-    } 
-    if (board[i][(j + 1) % COLS].has_lava) {
-        adjacent_lava_counter++;
-    } 
-    if (board[(i + 1) % ROWS][(10 + j - 1) % COLS].has_lava) {
-        adjacent_lava_counter++;
-    } 
-    if (board[(i + 1) % ROWS][j].has_lava) {
-        adjacent_lava_counter++;
-    } 
-    if (board[(i + 1) % ROWS][(j + 1) % COLS].has_lava) {
-        adjacent_lava_counter++;
-    } 
-    return adjacent_lava_counter;
-}
-
-//helper for corner check to see whether corner collides with opaque object
-int type_check(struct tile board[ROWS][COLS], int base_row, int base_col) {
-    
-    char type = board[base_row][base_col].entity;
-    if (type == WALL || type == BOULDER || type == GEM) {
-        return TRUE; 
-    } else {
-        return FALSE;
-    }
-}
+//asks the console loop to print the profile once it wakes up
+void handle_profile_signal(int signal_number) {
 
-//shadows the entire board when player is hit by boulder on respawn point
-void shadow_entire_board(struct tile game_board[ROWS][COLS], 
-    struct tile true_board[ROWS][COLS], struct game_status status) {
-    
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            game_board[i][j].has_lava = true_board[i][j].has_lava;
-            if (i != status.player_row || j != status.player_col) {
-                game_board[i][j].entity = HIDDEN;
-            }
-        }
-    }
+    (void) signal_number;
+    profile_requested = TRUE;
 }
 
 /*
 ==============================================================================
-============================ END HELPER SECTION ==============================
+============================= END CONSOLE SECTION ============================
 ==============================================================================
 */
-
-// ===========================================================================
-// Definitions of Provided Functions
-// ===========================================================================
-
-//given a 2D board array, initialise all tile entities to DIRT.
-void initialise_board(struct tile board[ROWS][COLS]) {
-
-    for (int row = 0; row < ROWS; row++) {
-        for (int col = 0; col < COLS; col++) {
-            board[row][col].entity = DIRT;
-            board[row][col].has_lava = FALSE;
-            board[row][col].next_turn_lava = FALSE;
-        }
-    }
-}
-
-//prints the game board, showing the player's position and lives remaining
-void print_board(struct tile board[ROWS][COLS], int lives_remaining) {
-
-    print_board_line();
-    print_board_header(lives_remaining);
-    print_board_line();
-
-    for (int row = 0; row < ROWS; row++) {
-        for (int col = 0; col < COLS; col++) {
-            printf("|");
-            if (board[row][col].entity == PLAYER) {
-                printf("^_^");
-            } else if (board[row][col].has_lava) {
-                printf("^^^");
-            } else if (board[row][col].entity == EMPTY) {
-                printf("   ");
-            } else if (board[row][col].entity == DIRT) {
-                printf(" . ");
-            } else if (board[row][col].entity == WALL) {
-                printf("|||");
-            } else if (board[row][col].entity == BOULDER) {
-                printf("(O)");
-            } else if (board[row][col].entity == GEM) {
-                printf("*^*");
-            } else if (board[row][col].entity == EXIT_LOCKED) {
-                printf("[X]");
-            } else if (board[row][col].entity == EXIT_UNLOCKED) {
-                printf("[ ]");
-            } else if (board[row][col].entity == HIDDEN) {
-                printf(" X ");
-            } else {
-                printf("   ");
-            }
-        }
-        printf("|\n");
-        print_board_line();
-    }
-    printf("\n");
-    return;
-}
-
-//helper function for print_board(). You will not need to call this.
-void print_board_header(int lives) {
-    printf("| Lives: %d    C A V E R U N             |\n", lives);
-}
-
-//helper function for print_board(). You will not need to call this.
-void print_board_line(void) {
-    printf("+");
-    for (int col = 0; col < COLS; col++) {
-        printf("---+");
-    }
-    printf("\n");
-}
-
-//prints game statistics: tile types, completion %, and points remaining.
-void print_map_statistics(
-    int number_of_dirt_tiles,
-    int number_of_gem_tiles,
-    int number_of_boulder_tiles,
-    double completion_percentage,
-    int maximum_points_remaining
-) {
-    printf("========= Map Statistics =========\n");
-    printf("Tiles Remaining by Type:\n");
-    printf("  - DIRT:      %d\n", number_of_dirt_tiles);
-    printf("  - GEMS:      %d\n", number_of_gem_tiles);
-    printf("  - BOULDERS:  %d\n", number_of_boulder_tiles);
-    printf("Completion Status:\n");
-    printf("  - Collectible Completion: %.1f%%\n", completion_percentage);
-    printf("  - Maximum Points Remaining: %d\n", maximum_points_remaining);
-    printf("==================================\n");
-}
@@ -0,0 +1,427 @@
+// caverun.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <The CS Caverun engine, the rules of the game without any I/O>
+
+/*
+Overview: The engine holds everything needed to play a game of Caverun in a
+single struct game_state. Setup functions place the player and map features,
+engine_step plays one command and returns a set of EVENT_ flags describing
+what happened, and the query functions report the score and map statistics.
+Nothing in the engine reads input, prints output, allocates or exits, so a
+front-end decides how to present each event and many games can be stepped
+side by side in one process.
+*/
+
+#ifndef CAVERUN_H
+#define CAVERUN_H
+
+#include <stdint.h>
+
+//provided constants, the board size can be overridden by the build
+
+#ifndef COLS
+#define COLS 10
+#endif
+#ifndef ROWS
+#define ROWS 10
+#endif
+#define INVALID_ROW (-1)
+#define INVALID_COL (-1)
+#define INITIAL_LIVES 3
+
+#define FALSE                 0
+#define TRUE                  1
+
+#define LAST_ROW              (ROWS - 1)
+#define LAST_COL              (COLS - 1)
+
+#define UP_SINGLE            'w'
+#define DOWN_SINGLE          's'
+#define LEFT_SINGLE          'a'
+#define RIGHT_SINGLE         'd'
+#define UP_DASH              'W'
+#define DOWN_DASH            'S'
+#define LEFT_DASH            'A'
+#define RIGHT_DASH           'D'
+
+#define ILLUMINATE           'i'
+#define SHADOW               'u'
+#define GRAVITY              'g'
+#define QUIT                 'q'
+#define PRINT_SCORE          'p'
+#define PRINT_MAP_STATS      'm'
+#define LAVA_TRIGGER         'L'
+#define HINT                 'h'
+#define PRINT_PROFILE        't'
+
+#define START                's'
+#define PLACE_WALL           'w'
+#define PLACE_BOULDER        'b'
+#define PLACE_GEM            'g'
+#define PLACE_LAVA           'l'
+#define PLACE_EXIT           'e'
+#define PLACE_GROUPED_WALLS  'W'
+
+#define POINTS_DIRT_NORMAL    1
+#define POINTS_DIRT_LAVA      10
+#define POINTS_GEM_NORMAL     20
+#define POINTS_GEM_LAVA       200
+
+#define GRAVITY_UP           'w'
+#define GRAVITY_DOWN         's'
+#define GRAVITY_LEFT         'a'
+#define GRAVITY_RIGHT        'd'
+
+#define ASCII_LIMIT           128
+#define CMD_HISTORY_LENGTH    5
+#define LAVA_GAME_BIRTH_COUNT 3
+#define LAVA_SURVIVE_MIN      2
+#define LAVA_SURVIVE_MAX      3
+#define LAVA_SEED_BIRTH_COUNT 2
+
+#define EPSILON               0.001
+#define SHADOW_RAY_STEP       0.0001
+
+#define ENTITY_TYPES          (PLAYER + 1)
+#define LAVA_MODES            (LAVA_SEEDS + 1)
+#define ZOBRIST_SEED          0x9E3779B97F4A7C15ULL
+
+#define HINT_MAX_DEPTH        12
+
+#define VISIBILITY_PARALLEL_TILES 256
+
+#define PLACEMENT_RESULTS     (PLACEMENT_OCCUPIED + 1)
+
+#define LAVA_BLOCK_DEPTH      8
+#define LAVA_BAND_ROWS        32
+#define LAVA_WORDS            ((COLS + 63) / 64)
+
+//the row or column before and after one, wrapping around the edge of the
+//board without a %
+#define WRAP_BACK(index, size)  ((index) == 0 ? (size) - 1 : (index) - 1)
+#define WRAP_NEXT(index, size)  ((index) == (size) - 1 ? 0 : (index) + 1)
+
+#define NS_PER_SEC            1000000000LL
+#define NS_PER_MS             1000000LL
+
+//events reported by engine_step, several can happen in one step
+#define EVENT_NONE              0
+#define EVENT_TURN              (1 << 0)
+#define EVENT_RENDER            (1 << 1)
+#define EVENT_GAME_OF_LAVA      (1 << 2)
+#define EVENT_LAVA_SEEDS        (1 << 3)
+#define EVENT_ILLUMINATION_ON   (1 << 4)
+#define EVENT_ILLUMINATION_OFF  (1 << 5)
+#define EVENT_SHADOW_ON         (1 << 6)
+#define EVENT_SHADOW_OFF        (1 << 7)
+#define EVENT_GRAVITY           (1 << 8)
+#define EVENT_OUT_OF_BREATH     (1 << 9)
+#define EVENT_BOULDER_RESPAWN   (1 << 10)
+#define EVENT_LAVA_RESPAWN      (1 << 11)
+#define EVENT_WIN               (1 << 12)
+#define EVENT_LOST              (1 << 13)
+#define EVENT_RESPAWN_BLOCKED   (1 << 14)
+#define EVENT_QUIT              (1 << 15)
+#define EVENT_GAME_OVER         (1 << 16)
+
+//provided Enums
+//enum for features on the game board
+enum entity {
+    EMPTY,
+    DIRT,
+    WALL,
+    BOULDER,
+    GEM,
+    EXIT_LOCKED,
+    EXIT_UNLOCKED,
+    HIDDEN,
+    PLAYER
+};
+
+enum lava_mode {
+    LAVA_NONE,
+    GAME_OF_LAVA,
+    LAVA_SEEDS
+};
+
+//what happens to the player after being hit by a boulder or lava
+enum hit_result {
+    HIT_RESPAWN,
+    HIT_NO_LIVES,
+    HIT_RESPAWN_BLOCKED
+};
+
+//result of trying to place the player or a feature during setup
+enum placement {
+    PLACEMENT_OK,
+    PLACEMENT_OFF_MAP,
+    PLACEMENT_OCCUPIED
+};
+
+//represents a tile/cell on the game board
+struct tile {
+    enum entity entity;
+    int has_lava;
+    int next_turn_lava;
+};
+
+struct constants {
+    int start_row;
+    int start_col;
+    int init_dirt;
+    int init_gem;
+    int settle;
+    int shadowcast;
+    int reference;
+};
+
+struct game_status {
+    int player_row;
+    int player_col;
+    int score;
+    int lives;
+    int can_dash;
+    int boulder_hit;
+    int lava_hit;
+    int game_won;
+    int game_over;
+    int illumination;
+    int illumination_radius;
+    int shadowed;
+    int shadow_entire_board;
+    char gravity;
+    enum lava_mode lava_mode;
+    char cmd_history[CMD_HISTORY_LENGTH];
+    uint64_t entity_hash;
+    uint64_t lava_hash;
+};
+
+//everything one game needs, copying it copies the whole game
+struct game_state {
+    struct tile board[ROWS][COLS];
+    struct game_status status;
+    struct constants constants;
+};
+
+//one gameplay command, e.g. 'd', 'D' 's', 'g' 'w' or 'i' 3
+struct command {
+    char instruction;
+    char instruction2;
+    int radius;
+};
+
+struct map_statistics {
+    int dirt;
+    int gems;
+    int boulders;
+    double completion_percentage;
+    int maximum_points_remaining;
+};
+
+//random keys for zobrist hashing, one per (tile, value) pair and per flag
+struct zobrist_keys {
+    uint64_t entity[ROWS][COLS][ENTITY_TYPES];
+    uint64_t lava[ROWS][COLS];
+    uint64_t player[ROWS][COLS];
+    uint64_t gravity[ASCII_LIMIT];
+    uint64_t lava_mode[LAVA_MODES];
+    uint64_t lives[INITIAL_LIVES + 1];
+    uint64_t can_dash;
+};
+
+//best line found by engine_hint and how the search went
+struct hint_result {
+    struct command line[HINT_MAX_DEPTH];
+    int length;
+    struct game_status line_end;
+    int depth;
+    long long nodes;
+    double seconds;
+    int thread_count;
+};
+
+//the next LAVA_BLOCK_DEPTH generations of lava as bit planes, plane 0
+//being the lava they were worked out from, see caverun_lava.c
+struct lava_ahead {
+    uint64_t planes[LAVA_BLOCK_DEPTH + 1][ROWS][LAVA_WORDS];
+    uint64_t hashes[LAVA_BLOCK_DEPTH + 1];
+    int generations;
+    enum lava_mode mode;
+};
+
+//the tiles that aren't dirt as a two dimensional Fenwick tree that adds to
+//whole rectangles, counted from 1, see caverun_occupancy.c
+struct occupancy_index {
+    long long tree[4][ROWS + 1][COLS + 1];
+};
+
+//one feature for engine_place_features, only grouped walls use the end
+struct placement_request {
+    char instruction;
+    int start_row;
+    int start_col;
+    int end_row;
+    int end_col;
+    enum placement result;
+};
+
+//how many of a batch of placements ended each way
+struct placement_summary {
+    int requests;
+    int results[PLACEMENT_RESULTS];
+};
+
+extern struct zobrist_keys zobrist;
+extern _Thread_local struct lava_ahead *lava_ahead_active;
+
+//engine API
+void engine_initialise(struct game_state *state);
+void engine_settle_boulders(struct game_state *state, int enabled);
+void engine_shadowcast(struct game_state *state, int enabled);
+void engine_reference(struct game_state *state, int enabled);
+enum placement engine_place_player(struct game_state *state, int row, int col);
+enum placement engine_place_feature(struct game_state *state,
+    char instruction, int row, int col);
+enum placement engine_place_grouped_walls(struct game_state *state,
+    int start_row, int start_col, int end_row, int end_col);
+void engine_place_features(struct game_state *state,
+    struct occupancy_index *index, struct placement_request requests[],
+    int count, struct placement_summary *summary);
+void engine_start(struct game_state *state);
+int engine_step(struct game_state *state, struct command command);
+int engine_tick(struct game_state *state);
+int engine_score(struct game_state *state);
+void engine_map_statistics(struct game_state *state,
+    struct map_statistics *statistics);
+int engine_lava_cells(struct game_state *state);
+uint64_t engine_hash(struct game_state *state);
+void engine_hint(struct game_state *state, struct hint_result *result);
+
+//provided Function Prototypes
+void initialise_board(struct tile board[ROWS][COLS]);
+
+//gameplay function prototypes
+void move_player_single(struct tile board[ROWS][COLS],
+    struct game_status *status, char instruction);
+void move_player_dash(struct tile board[ROWS][COLS],
+    struct game_status *status, char instruction, char instruction2);
+void dash_move(struct tile board[ROWS][COLS],
+    struct game_status *status, int new_row, int new_col);
+
+int end_of_move(struct game_state *state);
+int entities_turns(struct game_state *state);
+void boulder_turn(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants);
+void boulder_turn_scalar(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants);
+void boulder_turn_bits(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants);
+void boulder_move(struct tile board[ROWS][COLS], struct game_status *status,
+    struct constants constants, int r_offset, int c_offset, int i, int j);
+void boulder_settle(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants);
+void boulder_settle_line(struct tile board[ROWS][COLS],
+    struct game_status *status, int row, int col, int r_offset, int c_offset);
+void boulder_settle_hit(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    int r_offset, int c_offset);
+void boulder_spawn_check(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    int r_offset, int c_offset, int i, int j);
+
+void lava_turn(struct tile board[ROWS][COLS], struct game_status *status);
+void lava_turn_scalar(struct tile board[ROWS][COLS],
+    struct game_status *status);
+void lava_turn_blocked(struct tile board[ROWS][COLS],
+    struct game_status *status, struct lava_ahead *ahead);
+void lava_generation(struct tile board[ROWS][COLS],
+    struct game_status *status);
+void lava_ahead_step(struct tile board[ROWS][COLS],
+    struct game_status *status, struct lava_ahead *ahead);
+void game_of_lava(struct tile board[ROWS][COLS], struct game_status *status);
+void lava_seeds(struct tile board[ROWS][COLS], struct game_status *status);
+
+int player_hit(struct game_state *state, int respawn_event);
+enum hit_result resolve_player_hit(struct tile true_board[ROWS][COLS],
+    struct game_status *status, struct constants constants);
+
+int illuminate_toggle(struct game_status *status, int radius);
+int shadow_toggle(struct game_status *status);
+void illuminate(struct tile game_board[ROWS][COLS],
+    struct tile true_board[ROWS][COLS], struct game_status status);
+void illuminate_scalar(struct tile game_board[ROWS][COLS],
+    struct tile true_board[ROWS][COLS], struct game_status status);
+void shadow(struct tile game_board[ROWS][COLS],
+    struct tile true_board[ROWS][COLS], struct game_status status);
+int shadow_rows(struct tile game_board[ROWS][COLS],
+    struct tile true_board[ROWS][COLS], struct game_status status,
+    int first_row, int last_row);
+int shadow_parallel(struct tile game_board[ROWS][COLS],
+    struct tile true_board[ROWS][COLS], struct game_status status);
+int check_hidden(struct tile board[ROWS][COLS],
+    struct game_status status, int i, int j);
+void shadowcast(struct tile game_board[ROWS][COLS],
+    struct tile true_board[ROWS][COLS], struct game_status status);
+void shadowcast_visible(struct tile board[ROWS][COLS],
+    struct game_status status, char visible[ROWS][COLS]);
+int shadow_conformance(struct tile board[ROWS][COLS],
+    struct game_status status, char disagree[ROWS][COLS]);
+int above_corner_check(struct tile board[ROWS][COLS],
+    double row, double col, int gradient_x, int gradient_y);
+int below_corner_check(struct tile board[ROWS][COLS],
+    double row, double col, int gradient_x, int gradient_y);
+
+//helper functions
+void initialise_constants_and_game_status(struct tile true_board[ROWS][COLS],
+    struct game_status *status, struct constants *constants);
+
+enum placement check_valid_placement(struct tile board[ROWS][COLS],
+    int row, int col);
+enum placement validate_grouped_walls(struct tile board[ROWS][COLS],
+    int start_row, int start_col, int end_row, int end_col);
+int valid_move(struct tile board[ROWS][COLS], int new_row, int new_col);
+
+int entity_counter(struct tile board[ROWS][COLS], enum entity entity_type);
+int update_score(struct tile board[ROWS][COLS],
+    struct game_status *status, int row, int col);
+int calc_max_points_remaining(struct tile board[ROWS][COLS],
+    struct game_status status);
+double calc_completion_percent(struct tile board[ROWS][COLS],
+    struct constants constants);
+void check_exit_condition(struct tile board[ROWS][COLS],
+    struct game_status *status);
+void open_exits(struct tile board[ROWS][COLS], struct game_status *status);
+
+void update_command_history(struct game_status *status, char new_command);
+int check_lava_code(struct game_status *status);
+int count_adjacent_lava(struct tile board[ROWS][COLS], int i, int j);
+
+int type_check(struct tile board[ROWS][COLS], int base_row, int base_col);
+void shadow_entire_board(struct tile game_board[ROWS][COLS],
+    struct tile true_board[ROWS][COLS], struct game_status status);
+int compute_visible_board(struct tile game_board[ROWS][COLS],
+    struct game_state *state);
+
+//occupancy index function prototypes
+void occupancy_build(struct occupancy_index *index,
+    struct tile board[ROWS][COLS]);
+long long occupancy_count(struct occupancy_index *index, int start_row,
+    int start_col, int end_row, int end_col);
+void occupancy_fill(struct occupancy_index *index, int start_row,
+    int start_col, int end_row, int end_col, long long delta);
+
+//state hashing function prototypes
+void initialise_zobrist_keys(void);
+uint64_t splitmix64(uint64_t *seed);
+void compute_board_hash(struct tile board[ROWS][COLS],
+    struct game_status *status);
+void set_entity(struct tile board[ROWS][COLS], struct game_status *status,
+    int row, int col, enum entity entity);
+void set_lava(struct tile board[ROWS][COLS], struct game_status *status,
+    int row, int col, int has_lava);
+uint64_t game_state_hash(struct game_status *status);
+
+long long monotonic_ns(void);
+
+#endif
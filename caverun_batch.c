@@ -0,0 +1,461 @@
+// caverun_batch.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Re-simulates recorded games in parallel>
+
+/*
+Overview: The recordings are dealt out to the threads in equal contiguous
+blocks. A thread takes recordings from the front of its own block, and once
+that is empty it steals the back half of another thread's block, so a thread
+stuck with long games never leaves the others idle. Each thread owns one
+session and one file buffer that are reused for every recording it plays, so
+nothing is allocated per game once the buffer has grown to the largest
+recording.
+
+Every recording is played by a quiet session from caverun_session.c, the
+same code the console runs, so the results always match what the player saw.
+Results are kept in recording order and written once at the end as
+"recording outcome score lives turns", where turns counts gameplay commands.
+*/
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "caverun.h"
+#include "caverun_batch.h"
+#include "caverun_session.h"
+
+#define BATCH_PATH_LENGTH     4096
+#define BATCH_FILE_BUFFER     4096
+#define BATCH_OUTPUT_BUFFER   (1 << 16)
+
+enum batch_outcome {
+    OUTCOME_UNREADABLE,
+    OUTCOME_NO_GAME,
+    OUTCOME_UNFINISHED,
+    OUTCOME_WON,
+    OUTCOME_LOST,
+    OUTCOME_QUIT
+};
+
+struct batch_result {
+    enum batch_outcome outcome;
+    int score;
+    int lives;
+    int turns;
+};
+
+struct batch;
+
+//one thread of the pool, its block of recordings is [next, end)
+struct batch_worker {
+    pthread_t thread;
+    struct batch *batch;
+    int index;
+    pthread_mutex_t lock;
+    int next;
+    int end;
+    struct session session;
+    char *buffer;
+    long capacity;
+    int played;
+    long long steals;
+};
+
+struct batch {
+    char **paths;
+    int path_count;
+    struct batch_result *results;
+    struct batch_worker *workers;
+    int thread_count;
+};
+
+const char *BATCH_OUTCOME_NAMES[] = {
+    "unreadable", "no-game", "unfinished", "won", "lost", "quit"
+};
+
+int batch_load_directory(struct batch *batch, const char *directory);
+int batch_load_manifest(struct batch *batch, const char *manifest);
+int batch_add_path(struct batch *batch, const char *path, int *capacity);
+int batch_compare_paths(const void *a, const void *b);
+void *batch_worker_run(void *arg);
+int batch_take(struct batch_worker *worker);
+int batch_steal(struct batch_worker *worker);
+void batch_play(struct batch_worker *worker, int recording);
+int batch_read_file(struct batch_worker *worker, const char *path);
+int batch_write_results(struct batch *batch, const char *output);
+int batch_thread_count(int requested);
+
+/*
+==============================================================================
+============================= START BATCH SECTION ============================
+==============================================================================
+*/
+
+//simulates every recording and writes the results, returns the exit status
+int batch_run(struct batch_options *options) {
+
+    static struct batch batch;
+    struct stat input_stat;
+    if (stat(options->input, &input_stat) < 0) {
+        perror(options->input);
+        return 1;
+    }
+    int loaded = S_ISDIR(input_stat.st_mode) ? 
+        batch_load_directory(&batch, options->input) :
+        batch_load_manifest(&batch, options->input);
+    if (!loaded) {
+        return 1;
+    }
+
+    batch.thread_count = batch_thread_count(options->threads);
+    batch.results = calloc(batch.path_count + 1, sizeof(struct batch_result));
+    batch.workers = calloc(batch.thread_count, sizeof(struct batch_worker));
+    if (batch.results == NULL || batch.workers == NULL) {
+        fprintf(stderr, "Could not allocate the batch\n");
+        return 1;
+    }
+
+    //each thread starts with an equal contiguous block of recordings
+    long long start_ns = monotonic_ns();
+    for (int i = 0; i < batch.thread_count; i++) {
+        struct batch_worker *worker = &batch.workers[i];
+        worker->batch = &batch;
+        worker->index = i;
+        worker->next = (int)((long long) batch.path_count * i / 
+            batch.thread_count);
+        worker->end = (int)((long long) batch.path_count * (i + 1) / 
+            batch.thread_count);
+        pthread_mutex_init(&worker->lock, NULL);
+    }
+    int started = 1;
+    for (int i = 1; i < batch.thread_count; i++) {
+        if (pthread_create(&batch.workers[i].thread, NULL,
+            batch_worker_run, &batch.workers[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+    //blocks of threads that failed to start are stolen by the rest
+    batch_worker_run(&batch.workers[0]);
+    for (int i = 1; i < started; i++) {
+        pthread_join(batch.workers[i].thread, NULL);
+    }
+    double seconds = (double)(monotonic_ns() - start_ns) / NS_PER_SEC;
+
+    if (!batch_write_results(&batch, options->output)) {
+        return 1;
+    }
+
+    long long turns = 0;
+    long long steals = 0;
+    for (int i = 0; i < batch.path_count; i++) {
+        turns += batch.results[i].turns;
+    }
+    for (int i = 0; i < batch.thread_count; i++) {
+        steals += batch.workers[i].steals;
+    }
+    fprintf(stderr, "Simulated %d recording(s), %lld turn(s) in %.3fs on %d "
+        "thread(s): %.0f recordings/sec, %.0f turns/sec, %lld steal(s)\n",
+        batch.path_count, turns, seconds, started,
+        seconds > 0 ? batch.path_count / seconds : 0.0,
+        seconds > 0 ? turns / seconds : 0.0, steals);
+    return 0;
+}
+
+//plays recordings until there are none left to take or steal
+void *batch_worker_run(void *arg) {
+
+    struct batch_worker *worker = arg;
+    while (TRUE) {
+        int recording = batch_take(worker);
+        if (recording >= 0) {
+            batch_play(worker, recording);
+        } else if (!batch_steal(worker)) {
+            return NULL;
+        }
+    }
+}
+
+//takes the next recording from the front of a thread's own block
+int batch_take(struct batch_worker *worker) {
+
+    int recording = -1;
+    pthread_mutex_lock(&worker->lock);
+    if (worker->next < worker->end) {
+        recording = worker->next;
+        worker->next++;
+    }
+    pthread_mutex_unlock(&worker->lock);
+    return recording;
+}
+
+//moves the back half of another thread's block into this thread's block,
+//returns FALSE once every block is empty
+int batch_steal(struct batch_worker *worker) {
+
+    struct batch *batch = worker->batch;
+    for (int i = 1; i < batch->thread_count; i++) {
+        struct batch_worker *victim = 
+            &batch->workers[(worker->index + i) % batch->thread_count];
+
+        pthread_mutex_lock(&victim->lock);
+        int remaining = victim->end - victim->next;
+        int start = victim->end - (remaining + 1) / 2;
+        int end = victim->end;
+        if (remaining > 0) {
+            victim->end = start;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (remaining > 0) {
+            pthread_mutex_lock(&worker->lock);
+            worker->next = start;
+            worker->end = end;
+            pthread_mutex_unlock(&worker->lock);
+            worker->steals++;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+//replays one recording from start to finish and keeps its result
+void batch_play(struct batch_worker *worker, int recording) {
+
+    struct batch_result *result = &worker->batch->results[recording];
+    struct session *session = &worker->session;
+    worker->played++;
+
+    int length = batch_read_file(worker, worker->batch->paths[recording]);
+    if (length < 0) {
+        result->outcome = OUTCOME_UNREADABLE;
+        return;
+    }
+
+    //the whole recording is already here, so the end of it is the end of
+    //the input exactly as it was for the console
+    session_begin(session, NULL);
+    int used = 0;
+    int step;
+    while (session->phase != PHASE_OVER && (step = session_step(session, 
+        worker->buffer + used, length - used, TRUE)) > 0) {
+        used += step;
+    }
+    int started = session->phase != PHASE_PLAYER_POSITION;
+    session_finish(session);
+
+    struct game_status *status = &session->state.status;
+    result->turns = session->turns;
+    result->score = started ? status->score : 0;
+    result->lives = started ? status->lives : INITIAL_LIVES;
+    if (!started) {
+        result->outcome = OUTCOME_NO_GAME;
+    } else if (status->game_won) {
+        result->outcome = OUTCOME_WON;
+    } else if (session->last_events & EVENT_QUIT) {
+        result->outcome = OUTCOME_QUIT;
+    } else if (status->game_over) {
+        result->outcome = OUTCOME_LOST;
+    } else {
+        result->outcome = OUTCOME_UNFINISHED;
+    }
+}
+
+//reads a whole file into the thread's buffer, growing it only when a file
+//is bigger than any before it, returns the length or -1
+int batch_read_file(struct batch_worker *worker, const char *path) {
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    long length = 0;
+    while (TRUE) {
+        if (length == worker->capacity) {
+            long capacity = worker->capacity == 0 ? 
+                BATCH_FILE_BUFFER : worker->capacity * 2;
+            char *buffer = realloc(worker->buffer, capacity);
+            if (buffer == NULL || capacity > INT_MAX) {
+                fclose(file);
+                return -1;
+            }
+            worker->buffer = buffer;
+            worker->capacity = capacity;
+        }
+        size_t count = fread(worker->buffer + length, 1, 
+            worker->capacity - length, file);
+        if (count == 0) {
+            break;
+        }
+        length += count;
+    }
+    int failed = ferror(file);
+    fclose(file);
+    return failed ? -1 : (int) length;
+}
+
+//uses one thread per online core unless told otherwise
+int batch_thread_count(int requested) {
+
+    long threads = requested;
+    if (threads <= 0) {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads < 1) {
+        return 1;
+    } else if (threads > BATCH_MAX_THREADS) {
+        return BATCH_MAX_THREADS;
+    }
+    return (int) threads;
+}
+
+/*
+==============================================================================
+============================== END BATCH SECTION =============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+========================= START RECORDING LIST SECTION =======================
+==============================================================================
+*/
+
+//every regular file in a directory, sorted by name
+int batch_load_directory(struct batch *batch, const char *directory) {
+
+    DIR *dir = opendir(directory);
+    if (dir == NULL) {
+        perror(directory);
+        return FALSE;
+    }
+
+    int capacity = 0;
+    char path[BATCH_PATH_LENGTH];
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        struct stat entry_stat;
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        if (entry->d_name[0] == '.' || stat(path, &entry_stat) < 0 || 
+            !S_ISREG(entry_stat.st_mode)) {
+            continue;
+        }
+        if (!batch_add_path(batch, path, &capacity)) {
+            closedir(dir);
+            return FALSE;
+        }
+    }
+    closedir(dir);
+
+    qsort(batch->paths, batch->path_count, sizeof(char *), 
+        batch_compare_paths);
+    return TRUE;
+}
+
+//one recording path per line, blank lines and lines starting with # are
+//skipped and relative paths are relative to the manifest
+int batch_load_manifest(struct batch *batch, const char *manifest) {
+
+    FILE *file = fopen(manifest, "r");
+    if (file == NULL) {
+        perror(manifest);
+        return FALSE;
+    }
+
+    //the directory part of the manifest's own path, including the slash
+    const char *slash = strrchr(manifest, '/');
+    int directory_length = slash == NULL ? 0 : (int)(slash - manifest + 1);
+
+    int capacity = 0;
+    char line[BATCH_PATH_LENGTH];
+    char path[2 * BATCH_PATH_LENGTH];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        if (line[0] == '/') {
+            snprintf(path, sizeof(path), "%s", line);
+        } else {
+            snprintf(path, sizeof(path), "%.*s%s", directory_length, 
+                manifest, line);
+        }
+        if (!batch_add_path(batch, path, &capacity)) {
+            fclose(file);
+            return FALSE;
+        }
+    }
+    fclose(file);
+    return TRUE;
+}
+
+//appends a copy of a path to the list of recordings
+int batch_add_path(struct batch *batch, const char *path, int *capacity) {
+
+    if (batch->path_count == *capacity) {
+        int new_capacity = *capacity == 0 ? 1024 : *capacity * 2;
+        char **paths = realloc(batch->paths, new_capacity * sizeof(char *));
+        if (paths == NULL) {
+            fprintf(stderr, "Too many recordings\n");
+            return FALSE;
+        }
+        batch->paths = paths;
+        *capacity = new_capacity;
+    }
+    batch->paths[batch->path_count] = strdup(path);
+    if (batch->paths[batch->path_count] == NULL) {
+        fprintf(stderr, "Too many recordings\n");
+        return FALSE;
+    }
+    batch->path_count++;
+    return TRUE;
+}
+
+//orders paths alphabetically for qsort
+int batch_compare_paths(const void *a, const void *b) {
+
+    return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+//writes one line per recording in the order they were listed
+int batch_write_results(struct batch *batch, const char *output) {
+
+    FILE *file = output == NULL ? stdout : fopen(output, "w");
+    if (file == NULL) {
+        perror(output);
+        return FALSE;
+    }
+    static char buffer[BATCH_OUTPUT_BUFFER];
+    setvbuf(file, buffer, _IOFBF, sizeof(buffer));
+
+    fprintf(file, "# recording outcome score lives turns\n");
+    for (int i = 0; i < batch->path_count; i++) {
+        struct batch_result *result = &batch->results[i];
+        fprintf(file, "%s %s %d %d %d\n", batch->paths[i],
+            BATCH_OUTCOME_NAMES[result->outcome], result->score, 
+            result->lives, result->turns);
+    }
+    int failed = fflush(file) != 0 || ferror(file);
+    if (file != stdout) {
+        failed = fclose(file) != 0 || failed;
+    }
+    if (failed) {
+        perror(output == NULL ? "stdout" : output);
+    }
+    return !failed;
+}
+
+/*
+==============================================================================
+========================== END RECORDING LIST SECTION ========================
+==============================================================================
+*/
@@ -0,0 +1,26 @@
+// caverun_batch.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Re-simulates recorded games in parallel>
+
+/*
+Overview: A recording is exactly what a player typed into the console game,
+the setup statements followed by the gameplay commands. Batch mode replays a
+whole directory or manifest of recordings across a pool of threads and
+writes one line of results per recording.
+*/
+
+#ifndef CAVERUN_BATCH_H
+#define CAVERUN_BATCH_H
+
+#define BATCH_MAX_THREADS  256
+
+struct batch_options {
+    const char *input;
+    const char *output;
+    int threads;
+};
+
+int batch_run(struct batch_options *options);
+
+#endif
@@ -0,0 +1,269 @@
+// caverun_bench.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Whole-game throughput and correctness over transcripts>
+
+/*
+Overview: Each transcript is read into memory once and then played repeat
+times through a session printing into a memory stream, exactly as the
+console would print to stdout. The first play is compared line by line with
+the recorded output. Hint lines are only compared up to the word "Hint:" or
+"Searched depth", since how deep the search gets depends on the machine. The
+timed plays then give turns per second and bytes of output per turn over
+the whole directory. The exit status is 1 if any transcript differs, so a
+script can gate a change on it.
+*/
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "caverun.h"
+#include "caverun_bench.h"
+#include "caverun_session.h"
+
+#define BENCH_PATH_LENGTH     4096
+#define BENCH_MAX_TRANSCRIPTS 4096
+
+struct bench_transcript {
+    char *input;
+    long input_length;
+    char *expected;
+    long expected_length;
+};
+
+struct bench_totals {
+    long long turns;
+    long long bytes;
+    long long ns;
+    int passed;
+    int failed;
+};
+
+int bench_list_transcripts(const char *directory, char **names);
+int bench_compare_names(const void *a, const void *b);
+int bench_load(const char *directory, const char *name, 
+    struct bench_transcript *transcript);
+char *bench_read_file(const char *path, long *length);
+int bench_play(struct bench_transcript *transcript, char **output, 
+    size_t *output_length);
+long bench_first_difference(const char *actual, long actual_length,
+    const char *expected, long expected_length);
+int bench_is_timing_line(const char *line, long length);
+
+//replays every transcript in a directory, returns the exit status
+int bench_run(struct bench_options *options) {
+
+    static char *names[BENCH_MAX_TRANSCRIPTS];
+    int count = bench_list_transcripts(options->directory, names);
+    if (count < 0) {
+        return 1;
+    } else if (count == 0) {
+        fprintf(stderr, "No transcripts (NAME.in with NAME.out) in %s\n",
+            options->directory);
+        return 1;
+    }
+
+    struct bench_totals totals = {0, 0, 0, 0, 0};
+    for (int i = 0; i < count; i++) {
+        struct bench_transcript transcript;
+        if (!bench_load(options->directory, names[i], &transcript)) {
+            printf("FAIL %s: could not be read\n", names[i]);
+            totals.failed++;
+            continue;
+        }
+
+        //the first play is checked, the rest are only timed
+        char *output = NULL;
+        size_t output_length = 0;
+        int turns = bench_play(&transcript, &output, &output_length);
+        long difference = bench_first_difference(output, output_length, 
+            transcript.expected, transcript.expected_length);
+        if (difference >= 0) {
+            printf("FAIL %s: output differs from byte %ld\n", names[i], 
+                difference);
+            totals.failed++;
+        } else {
+            printf("PASS %s (%d turn(s), %zu byte(s))\n", names[i], turns,
+                output_length);
+            totals.passed++;
+        }
+        free(output);
+
+        long long start_ns = monotonic_ns();
+        for (int run = 0; run < options->repeat; run++) {
+            totals.turns += bench_play(&transcript, &output, &output_length);
+            totals.bytes += output_length;
+            free(output);
+        }
+        totals.ns += monotonic_ns() - start_ns;
+
+        free(transcript.input);
+        free(transcript.expected);
+    }
+
+    double seconds = (double) totals.ns / NS_PER_SEC;
+    printf("Replayed %d transcript(s) x %d: %lld turn(s) in %.3fs, "
+        "%.0f turns/sec, %.1f bytes/turn\n", count, options->repeat,
+        totals.turns, seconds, seconds > 0 ? totals.turns / seconds : 0.0,
+        totals.turns > 0 ? (double) totals.bytes / totals.turns : 0.0);
+    printf("%d passed, %d failed\n", totals.passed, totals.failed);
+    for (int i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    return totals.failed > 0;
+}
+
+//finds every NAME.in, sorted, returns how many or -1
+int bench_list_transcripts(const char *directory, char **names) {
+
+    DIR *dir = opendir(directory);
+    if (dir == NULL) {
+        perror(directory);
+        return -1;
+    }
+
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && count < BENCH_MAX_TRANSCRIPTS) {
+        int length = strlen(entry->d_name);
+        if (length > 3 && strcmp(entry->d_name + length - 3, ".in") == 0) {
+            names[count] = strndup(entry->d_name, length - 3);
+            if (names[count] != NULL) {
+                count++;
+            }
+        }
+    }
+    closedir(dir);
+
+    qsort(names, count, sizeof(char *), bench_compare_names);
+    return count;
+}
+
+//orders names alphabetically for qsort
+int bench_compare_names(const void *a, const void *b) {
+
+    return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+//reads both halves of a transcript
+int bench_load(const char *directory, const char *name, 
+    struct bench_transcript *transcript) {
+
+    char path[BENCH_PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s/%s.in", directory, name);
+    transcript->input = bench_read_file(path, &transcript->input_length);
+    snprintf(path, sizeof(path), "%s/%s.out", directory, name);
+    transcript->expected = bench_read_file(path, 
+        &transcript->expected_length);
+
+    if (transcript->input == NULL || transcript->expected == NULL) {
+        free(transcript->input);
+        free(transcript->expected);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+//reads a whole file into a new buffer
+char *bench_read_file(const char *path, long *length) {
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    char *data = NULL;
+    size_t size = 0;
+    FILE *copy = open_memstream(&data, &size);
+    if (copy == NULL) {
+        fclose(file);
+        return NULL;
+    }
+    char block[BENCH_PATH_LENGTH];
+    size_t count;
+    while ((count = fread(block, 1, sizeof(block), file)) > 0) {
+        fwrite(block, 1, count, copy);
+    }
+    int failed = ferror(file);
+    fclose(file);
+    fclose(copy);
+    if (failed) {
+        free(data);
+        return NULL;
+    }
+    *length = size;
+    return data;
+}
+
+//plays a transcript's input the way the console would, returns the number
+//of turns and hands back everything it printed
+int bench_play(struct bench_transcript *transcript, char **output, 
+    size_t *output_length) {
+
+    static struct session session;
+    *output = NULL;
+    *output_length = 0;
+    FILE *out = open_memstream(output, output_length);
+    if (out == NULL) {
+        return 0;
+    }
+
+    session_begin(&session, out);
+    long used = 0;
+    int step;
+    while (session.phase != PHASE_OVER && (step = session_step(&session, 
+        transcript->input + used, transcript->input_length - used, 
+        TRUE)) > 0) {
+        used += step;
+    }
+    session_finish(&session);
+    fclose(out);
+    return session.turns;
+}
+
+//where the output first differs from the transcript, or -1 if it matches
+long bench_first_difference(const char *actual, long actual_length,
+    const char *expected, long expected_length) {
+
+    long a = 0;
+    long e = 0;
+    while (a < actual_length && e < expected_length) {
+        const char *actual_end = memchr(actual + a, '\n', actual_length - a);
+        const char *expected_end = memchr(expected + e, '\n', 
+            expected_length - e);
+        long actual_line = actual_end == NULL ? 
+            actual_length - a : actual_end - (actual + a) + 1;
+        long expected_line = expected_end == NULL ? 
+            expected_length - e : expected_end - (expected + e) + 1;
+
+        int same = actual_line == expected_line && 
+            memcmp(actual + a, expected + e, actual_line) == 0;
+        if (!same && !(bench_is_timing_line(actual + a, actual_line) &&
+            bench_is_timing_line(expected + e, expected_line))) {
+            return a;
+        }
+        a += actual_line;
+        e += expected_line;
+    }
+    if (a < actual_length || e < expected_length) {
+        return a;
+    }
+    return -1;
+}
+
+//lines from the hint command, which depend on how fast the machine is
+int bench_is_timing_line(const char *line, long length) {
+
+    const char *prefixes[] = {"Hint:", "Searched depth"};
+    for (int i = 0; i < 2; i++) {
+        long prefix_length = strlen(prefixes[i]);
+        if (length >= prefix_length && 
+            strncmp(line, prefixes[i], prefix_length) == 0) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
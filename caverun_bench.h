@@ -0,0 +1,25 @@
+// caverun_bench.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Whole-game throughput and correctness over transcripts>
+
+/*
+Overview: A transcript is a pair of files, NAME.in holding what a player
+typed and NAME.out holding exactly what the console printed back. Bench mode
+replays every transcript in a directory, checks the output still matches and
+reports how fast whole games run, so a change can be judged on both.
+*/
+
+#ifndef CAVERUN_BENCH_H
+#define CAVERUN_BENCH_H
+
+#define BENCH_DEFAULT_REPEAT  20
+
+struct bench_options {
+    const char *directory;
+    int repeat;
+};
+
+int bench_run(struct bench_options *options);
+
+#endif
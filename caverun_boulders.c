@@ -0,0 +1,295 @@
+// caverun_boulders.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Boulder turns computed 64 tiles at a time with bit masks>
+
+/*
+Overview: In a normal boulder turn, boulder_turn visits every tile one line
+at a time, starting from the line gravity pulls towards, and moves a boulder
+into the tile below it when that tile is empty. Within one line no two
+tiles affect each other, so a whole line can be done at once: with a mask
+of the boulders in the line behind and a mask of the empty tiles in the
+target line, (empty & boulders) is every boulder that falls, and a few
+more bit operations move them. Lines are rows when gravity is vertical and
+columns when it is horizontal, so each operation handles up to 64 tiles
+across the line, and lines are still visited in the same order so a stack
+of boulders falls together exactly as before.
+
+The only tile a line can't do with masks is the player's, since a boulder
+landing on the player depends on their lives and on what is at the spawn
+point at that moment. When a boulder is about to fall on the player, the
+tiles before the player in that line are done with masks, then the usual
+boulder_move handles the player with the board brought up to date, then
+the masks carry on. The masks are built from the board at the start of the
+turn and only the tiles that changed are written back, through set_entity
+so the hash stays correct.
+*/
+
+#include <string.h>
+
+#include "caverun.h"
+#include "caverun_profile.h"
+
+#define BOULDER_LINE_MAX      (ROWS > COLS ? ROWS : COLS)
+#define BOULDER_WORDS         ((BOULDER_LINE_MAX + 63) / 64)
+
+//boulder and empty masks of every line, plus which tiles the board itself
+//currently says are boulders so only real changes are written back
+struct boulder_planes {
+    uint64_t boulder[BOULDER_LINE_MAX][BOULDER_WORDS];
+    uint64_t empty[BOULDER_LINE_MAX][BOULDER_WORDS];
+    uint64_t on_board[BOULDER_LINE_MAX][BOULDER_WORDS];
+    int vertical;
+};
+
+void boulder_bits_up(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes);
+void boulder_bits_down(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes);
+void boulder_bits_left(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes);
+void boulder_bits_right(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes);
+void boulder_sweep(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes, int first, int last, int step);
+void boulder_sweep_line(struct boulder_planes *planes, int target,
+    int source, int from_bit, int to_bit);
+void boulder_player_move(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes, int step);
+void boulder_planes_build(struct tile board[ROWS][COLS],
+    struct boulder_planes *planes, int vertical);
+void boulder_planes_store(struct tile board[ROWS][COLS],
+    struct game_status *status, struct boulder_planes *planes);
+void boulder_sync_tile(struct tile board[ROWS][COLS],
+    struct game_status *status, struct boulder_planes *planes,
+    int row, int col);
+void boulder_read_tile(struct tile board[ROWS][COLS],
+    struct boulder_planes *planes, int row, int col);
+uint64_t boulder_range_mask(int word, int from_bit, int to_bit);
+
+//one normal boulder turn, giving exactly the board boulder_turn_scalar would
+void boulder_turn_bits(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants) {
+
+    static _Thread_local struct boulder_planes planes;
+
+    if (status->gravity == GRAVITY_UP) {
+        boulder_bits_up(board, status, constants, &planes);
+    } else if (status->gravity == GRAVITY_DOWN) {
+        boulder_bits_down(board, status, constants, &planes);
+    } else if (status->gravity == GRAVITY_LEFT) {
+        boulder_bits_left(board, status, constants, &planes);
+    } else if (status->gravity == GRAVITY_RIGHT) {
+        boulder_bits_right(board, status, constants, &planes);
+    }
+}
+
+//rows are the lines, boulders fall from row i + 1 into row i
+void boulder_bits_up(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes) {
+
+    boulder_planes_build(board, planes, TRUE);
+    boulder_sweep(board, status, constants, planes, 0, LAST_ROW - 1, 1);
+    boulder_planes_store(board, status, planes);
+}
+
+//rows are the lines, boulders fall from row i - 1 into row i
+void boulder_bits_down(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes) {
+
+    boulder_planes_build(board, planes, TRUE);
+    boulder_sweep(board, status, constants, planes, LAST_ROW, 1, -1);
+    boulder_planes_store(board, status, planes);
+}
+
+//columns are the lines, boulders fall from column j + 1 into column j
+void boulder_bits_left(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes) {
+
+    boulder_planes_build(board, planes, FALSE);
+    boulder_sweep(board, status, constants, planes, 0, LAST_COL - 1, 1);
+    boulder_planes_store(board, status, planes);
+}
+
+//columns are the lines, boulders fall from column j - 1 into column j
+void boulder_bits_right(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes) {
+
+    boulder_planes_build(board, planes, FALSE);
+    boulder_sweep(board, status, constants, planes, LAST_COL, 1, -1);
+    boulder_planes_store(board, status, planes);
+}
+
+//visits the target lines from first to last, the source of each being the
+//next line to be visited, stopping at the player's tile if a boulder is
+//over it
+void boulder_sweep(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes, int first, int last, int step) {
+
+    int player_line = planes->vertical ? status->player_row :
+        status->player_col;
+    int player_bit = planes->vertical ? status->player_col :
+        status->player_row;
+    int bits = planes->vertical ? COLS : ROWS;
+    int player_on_board =
+        board[status->player_row][status->player_col].entity == PLAYER;
+
+    for (int target = first; target != last + step; target += step) {
+        int source = target + step;
+        if (player_on_board && target == player_line &&
+            (planes->boulder[source][player_bit / 64] >>
+            (player_bit % 64) & 1)) {
+            boulder_sweep_line(planes, target, source, 0, player_bit);
+            boulder_player_move(board, status, constants, planes, step);
+            boulder_sweep_line(planes, target, source, player_bit + 1, bits);
+        } else {
+            boulder_sweep_line(planes, target, source, 0, bits);
+        }
+    }
+}
+
+//moves every boulder in the source line that has an empty tile in front
+//of it, for the tiles from_bit up to but not including to_bit
+void boulder_sweep_line(struct boulder_planes *planes, int target,
+    int source, int from_bit, int to_bit) {
+
+    for (int word = from_bit / 64; word < BOULDER_WORDS &&
+        word * 64 < to_bit; word++) {
+        uint64_t falling = planes->empty[target][word] &
+            planes->boulder[source][word] &
+            boulder_range_mask(word, from_bit, to_bit);
+        planes->boulder[target][word] |= falling;
+        planes->empty[target][word] &= ~falling;
+        planes->boulder[source][word] &= ~falling;
+        planes->empty[source][word] |= falling;
+        PROFILE_COUNT(COUNT_BOULDERS_MOVED, __builtin_popcountll(falling));
+    }
+}
+
+//lets boulder_move drop the boulder on the player, with the tiles it looks
+//at brought up to date first and its changes taken back into the masks
+void boulder_player_move(struct tile board[ROWS][COLS],
+    struct game_status *status, struct constants constants,
+    struct boulder_planes *planes, int step) {
+
+    int row = status->player_row;
+    int col = status->player_col;
+    int r_offset = planes->vertical ? step : 0;
+    int c_offset = planes->vertical ? 0 : step;
+
+    boulder_sync_tile(board, status, planes, row + r_offset, col + c_offset);
+    boulder_sync_tile(board, status, planes,
+        constants.start_row, constants.start_col);
+    boulder_move(board, status, constants, r_offset, c_offset, row, col);
+    boulder_read_tile(board, planes, row, col);
+    boulder_read_tile(board, planes, row + r_offset, col + c_offset);
+}
+
+//builds the masks, lines being rows if vertical and columns otherwise
+void boulder_planes_build(struct tile board[ROWS][COLS],
+    struct boulder_planes *planes, int vertical) {
+
+    planes->vertical = vertical;
+    memset(planes->boulder, 0, sizeof(planes->boulder));
+    memset(planes->empty, 0, sizeof(planes->empty));
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            int line = vertical ? i : j;
+            int bit = vertical ? j : i;
+            uint64_t mask = (uint64_t) 1 << (bit % 64);
+            if (board[i][j].entity == BOULDER) {
+                planes->boulder[line][bit / 64] |= mask;
+            } else if (board[i][j].entity == EMPTY) {
+                planes->empty[line][bit / 64] |= mask;
+            }
+        }
+    }
+    memcpy(planes->on_board, planes->boulder, sizeof(planes->boulder));
+}
+
+//writes back every tile that became or stopped being a boulder
+void boulder_planes_store(struct tile board[ROWS][COLS],
+    struct game_status *status, struct boulder_planes *planes) {
+
+    int lines = planes->vertical ? ROWS : COLS;
+    for (int line = 0; line < lines; line++) {
+        for (int word = 0; word < BOULDER_WORDS; word++) {
+            uint64_t changed = planes->boulder[line][word] ^
+                planes->on_board[line][word];
+            while (changed != 0) {
+                int bit = word * 64 + __builtin_ctzll(changed);
+                changed &= changed - 1;
+                int row = planes->vertical ? line : bit;
+                int col = planes->vertical ? bit : line;
+                boulder_sync_tile(board, status, planes, row, col);
+            }
+        }
+    }
+}
+
+//makes the board agree with the masks for one tile
+void boulder_sync_tile(struct tile board[ROWS][COLS],
+    struct game_status *status, struct boulder_planes *planes,
+    int row, int col) {
+
+    int line = planes->vertical ? row : col;
+    int bit = planes->vertical ? col : row;
+    uint64_t mask = (uint64_t) 1 << (bit % 64);
+
+    if (planes->boulder[line][bit / 64] & mask) {
+        if (board[row][col].entity != BOULDER) {
+            set_entity(board, status, row, col, BOULDER);
+        }
+        planes->on_board[line][bit / 64] |= mask;
+    } else if (planes->empty[line][bit / 64] & mask) {
+        if (board[row][col].entity != EMPTY) {
+            set_entity(board, status, row, col, EMPTY);
+        }
+        planes->on_board[line][bit / 64] &= ~mask;
+    }
+}
+
+//makes the masks agree with the board for one tile
+void boulder_read_tile(struct tile board[ROWS][COLS],
+    struct boulder_planes *planes, int row, int col) {
+
+    int line = planes->vertical ? row : col;
+    int bit = planes->vertical ? col : row;
+    uint64_t mask = (uint64_t) 1 << (bit % 64);
+
+    planes->boulder[line][bit / 64] &= ~mask;
+    planes->empty[line][bit / 64] &= ~mask;
+    planes->on_board[line][bit / 64] &= ~mask;
+    if (board[row][col].entity == BOULDER) {
+        planes->boulder[line][bit / 64] |= mask;
+        planes->on_board[line][bit / 64] |= mask;
+    } else if (board[row][col].entity == EMPTY) {
+        planes->empty[line][bit / 64] |= mask;
+    }
+}
+
+//bits of one word that lie in [from_bit, to_bit)
+uint64_t boulder_range_mask(int word, int from_bit, int to_bit) {
+
+    int low = from_bit - word * 64;
+    int high = to_bit - word * 64;
+    uint64_t mask = ~(uint64_t) 0;
+    if (low > 0) {
+        mask = low >= 64 ? 0 : mask << low;
+    }
+    if (high < 64) {
+        mask &= high <= 0 ? 0 : ~(uint64_t) 0 >> (64 - high);
+    }
+    return mask;
+}
@@ -0,0 +1,445 @@
+// caverun_broadcast.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Streams a game's boards to spectators over a local socket>
+
+/*
+Overview: Every number is a zigzag varint. Each message is its length
+followed by the body: a type byte (BROADCAST_KEYFRAME or BROADCAST_DELTA),
+then the turn, lives, score, player row, player column and game flags. A
+keyframe then holds the whole board run-length encoded as (count, tile)
+pairs and a delta holds the number of changed tiles followed by a (gap,
+tile) pair for each, gap being how many tiles were skipped since the last
+change. A tile is one byte, its entity in the low nibble plus
+BROADCAST_TILE_LAVA.
+
+Messages are built once per board and copied into each spectator's buffer,
+then sent with non-blocking writes. Whenever the game is about to wait for
+input, broadcast_poll accepts new spectators and sends what is still
+buffered, so spectators keep up even while nobody is typing.
+broadcast_spectate is a spectator that prints every board it rebuilds.
+*/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "caverun.h"
+#include "caverun_broadcast.h"
+#include "caverun_session.h"
+
+#define BROADCAST_KEYFRAME    'K'
+#define BROADCAST_DELTA       'D'
+#define BROADCAST_TILE_LAVA   (1 << 4)
+#define BROADCAST_PREFIX      3
+#define BROADCAST_LISTEN_BACKLOG 16
+
+//a message being built or decoded
+struct broadcast_message {
+    unsigned char data[BROADCAST_MESSAGE_SIZE];
+    int length;
+};
+
+int broadcast_socket_address(const char *path, struct sockaddr_un *address);
+void broadcast_accept(struct broadcast *broadcast);
+void broadcast_send(struct spectator *spectator);
+void broadcast_queue(struct spectator *spectator, 
+    struct broadcast_message *message, int keyframe);
+void broadcast_drop(struct spectator *spectator);
+void broadcast_encode(struct broadcast_message *message, int type,
+    unsigned char tiles[ROWS][COLS], unsigned char last[ROWS][COLS],
+    struct game_status *status, int turn);
+void message_put_int(struct broadcast_message *message, int value);
+int message_get_int(const unsigned char *data, int length, int *position);
+int spectate_message(const unsigned char *data, int length, 
+    unsigned char tiles[ROWS][COLS], int have_keyframe);
+
+/*
+==============================================================================
+=========================== START BROADCASTING SECTION =======================
+==============================================================================
+*/
+
+//starts listening for spectators on a Unix socket, FALSE if it can't
+int broadcast_open(struct broadcast *broadcast, const char *path) {
+
+    struct sockaddr_un address;
+    if (!broadcast_socket_address(path, &address)) {
+        return FALSE;
+    }
+    unlink(path);
+    broadcast->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | 
+        SOCK_CLOEXEC, 0);
+    if (broadcast->listen_fd < 0 || bind(broadcast->listen_fd, 
+        (struct sockaddr *) &address, sizeof(address)) < 0 ||
+        listen(broadcast->listen_fd, BROADCAST_LISTEN_BACKLOG) < 0) {
+        perror(path);
+        return FALSE;
+    }
+    broadcast->path = path;
+    broadcast->boards = 0;
+    memset(broadcast->last, 0, sizeof(broadcast->last));
+    for (int i = 0; i < BROADCAST_SPECTATORS; i++) {
+        broadcast->spectators[i].fd = -1;
+    }
+    return TRUE;
+}
+
+//sends a board to every spectator, as a keyframe to those who need one
+//and as the changes since the last board to everyone else
+void broadcast_board(struct broadcast *broadcast, 
+    struct tile board[ROWS][COLS], struct game_status *status, int turn) {
+
+    static struct broadcast_message delta;
+    static struct broadcast_message keyframe;
+    unsigned char tiles[ROWS][COLS];
+
+    broadcast_accept(broadcast);
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            tiles[i][j] = board[i][j].entity | 
+                (board[i][j].has_lava ? BROADCAST_TILE_LAVA : 0);
+        }
+    }
+    int everyone_keyframe = broadcast->boards % 
+        BROADCAST_KEYFRAME_INTERVAL == 0;
+    broadcast_encode(&keyframe, BROADCAST_KEYFRAME, tiles, NULL, status, 
+        turn);
+    if (!everyone_keyframe) {
+        broadcast_encode(&delta, BROADCAST_DELTA, tiles, broadcast->last, 
+            status, turn);
+    }
+    memcpy(broadcast->last, tiles, sizeof(tiles));
+    broadcast->boards++;
+
+    for (int i = 0; i < BROADCAST_SPECTATORS; i++) {
+        struct spectator *spectator = &broadcast->spectators[i];
+        if (spectator->fd < 0) {
+            continue;
+        }
+        if (everyone_keyframe || spectator->needs_keyframe) {
+            broadcast_queue(spectator, &keyframe, TRUE);
+        } else {
+            broadcast_queue(spectator, &delta, FALSE);
+        }
+        broadcast_send(spectator);
+    }
+}
+
+//takes in new spectators and sends whatever is still buffered
+void broadcast_poll(struct broadcast *broadcast) {
+
+    broadcast_accept(broadcast);
+    for (int i = 0; i < BROADCAST_SPECTATORS; i++) {
+        if (broadcast->spectators[i].fd >= 0) {
+            broadcast_send(&broadcast->spectators[i]);
+        }
+    }
+}
+
+//sends what it can without waiting and disconnects everyone
+void broadcast_close(struct broadcast *broadcast) {
+
+    for (int i = 0; i < BROADCAST_SPECTATORS; i++) {
+        struct spectator *spectator = &broadcast->spectators[i];
+        if (spectator->fd >= 0) {
+            broadcast_send(spectator);
+            broadcast_drop(spectator);
+        }
+    }
+    close(broadcast->listen_fd);
+    unlink(broadcast->path);
+}
+
+int broadcast_socket_address(const char *path, struct sockaddr_un *address) {
+
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path)) {
+        fprintf(stderr, "Socket path is too long: %s\n", path);
+        return FALSE;
+    }
+    strcpy(address->sun_path, path);
+    return TRUE;
+}
+
+//accepts every waiting spectator, they start at the next board's keyframe
+void broadcast_accept(struct broadcast *broadcast) {
+
+    int fd;
+    while ((fd = accept4(broadcast->listen_fd, NULL, NULL, 
+        SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        struct spectator *spectator = NULL;
+        for (int i = 0; i < BROADCAST_SPECTATORS && spectator == NULL; i++) {
+            if (broadcast->spectators[i].fd < 0) {
+                spectator = &broadcast->spectators[i];
+            }
+        }
+        if (spectator == NULL) {
+            close(fd);
+            continue;
+        }
+        spectator->fd = fd;
+        spectator->needs_keyframe = TRUE;
+        spectator->length = 0;
+        spectator->sent = 0;
+    }
+}
+
+//adds a message to a spectator's buffer, or gives up on deltas until the
+//next keyframe if there isn't room for it
+void broadcast_queue(struct spectator *spectator, 
+    struct broadcast_message *message, int keyframe) {
+
+    if (spectator->sent > 0) {
+        memmove(spectator->buffer, spectator->buffer + spectator->sent, 
+            spectator->length - spectator->sent);
+        spectator->length -= spectator->sent;
+        spectator->sent = 0;
+    }
+    if (spectator->length + message->length > BROADCAST_BUFFER_SIZE) {
+        spectator->needs_keyframe = TRUE;
+        return;
+    }
+    memcpy(spectator->buffer + spectator->length, message->data, 
+        message->length);
+    spectator->length += message->length;
+    if (keyframe) {
+        spectator->needs_keyframe = FALSE;
+    }
+}
+
+//writes as much of the buffer as the socket takes right now
+void broadcast_send(struct spectator *spectator) {
+
+    while (spectator->sent < spectator->length) {
+        ssize_t count = send(spectator->fd, spectator->buffer + 
+            spectator->sent, spectator->length - spectator->sent, 
+            MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else if (count <= 0) {
+            broadcast_drop(spectator);
+            return;
+        }
+        spectator->sent += count;
+    }
+    spectator->length = 0;
+    spectator->sent = 0;
+}
+
+void broadcast_drop(struct spectator *spectator) {
+
+    close(spectator->fd);
+    spectator->fd = -1;
+}
+
+//builds one message, last is only used for deltas
+void broadcast_encode(struct broadcast_message *message, int type,
+    unsigned char tiles[ROWS][COLS], unsigned char last[ROWS][COLS],
+    struct game_status *status, int turn) {
+
+    //the body is built after room for the longest possible length prefix
+    message->length = BROADCAST_PREFIX;
+    message->data[message->length++] = type;
+    message_put_int(message, turn);
+    message_put_int(message, status->lives);
+    message_put_int(message, status->score);
+    message_put_int(message, status->player_row);
+    message_put_int(message, status->player_col);
+    message_put_int(message, status->game_won | status->game_over << 1);
+
+    const unsigned char *cells = &tiles[0][0];
+    if (type == BROADCAST_KEYFRAME) {
+        int cell = 0;
+        while (cell < ROWS * COLS) {
+            int run = 1;
+            while (cell + run < ROWS * COLS &&
+                cells[cell + run] == cells[cell]) {
+                run++;
+            }
+            message_put_int(message, run);
+            message->data[message->length++] = cells[cell];
+            cell += run;
+        }
+    } else {
+        const unsigned char *previous = &last[0][0];
+        int changed = 0;
+        for (int cell = 0; cell < ROWS * COLS; cell++) {
+            changed += cells[cell] != previous[cell];
+        }
+        message_put_int(message, changed);
+        int gap = 0;
+        for (int cell = 0; cell < ROWS * COLS; cell++) {
+            if (cells[cell] == previous[cell]) {
+                gap++;
+            } else {
+                message_put_int(message, gap);
+                message->data[message->length++] = cells[cell];
+                gap = 0;
+            }
+        }
+    }
+
+    //then the length goes right in front of the body
+    int body_length = message->length - BROADCAST_PREFIX;
+    unsigned char length_bytes[BROADCAST_PREFIX];
+    int length_count = 0;
+    unsigned int value = (unsigned int) body_length << 1;
+    while (value >= 0x80) {
+        length_bytes[length_count++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    length_bytes[length_count++] = value;
+    int start = BROADCAST_PREFIX - length_count;
+    memcpy(message->data + start, length_bytes, length_count);
+    memmove(message->data, message->data + start, message->length - start);
+    message->length -= start;
+}
+
+//writes a zigzag varint, 7 bits per byte with the top bit meaning "more"
+void message_put_int(struct broadcast_message *message, int value) {
+
+    unsigned int zigzag = ((unsigned int) value << 1) ^ (unsigned int)
+        (value >> 31);
+    while (zigzag >= 0x80) {
+        message->data[message->length++] = (zigzag & 0x7F) | 0x80;
+        zigzag >>= 7;
+    }
+    message->data[message->length++] = zigzag;
+}
+
+/*
+==============================================================================
+============================ END BROADCASTING SECTION ========================
+==============================================================================
+*/
+
+/*
+==============================================================================
+=========================== START SPECTATING SECTION =========================
+==============================================================================
+*/
+
+//follows a broadcast, printing every board it rebuilds until the game ends
+int broadcast_spectate(const char *path) {
+
+    struct sockaddr_un address;
+    if (!broadcast_socket_address(path, &address)) {
+        return 1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *) &address, 
+        sizeof(address)) < 0) {
+        perror(path);
+        return 1;
+    }
+
+    static unsigned char input[BROADCAST_BUFFER_SIZE];
+    static unsigned char tiles[ROWS][COLS];
+    int input_length = 0;
+    int have_keyframe = FALSE;
+    ssize_t count;
+    while ((count = read(fd, input + input_length, 
+        BROADCAST_BUFFER_SIZE - input_length)) > 0) {
+        input_length += count;
+
+        //plays every whole message, the rest waits for more input
+        int used = 0;
+        while (TRUE) {
+            int position = used;
+            int body_length = message_get_int(input, input_length, &position);
+            if (body_length < 0 || position + body_length > input_length) {
+                break;
+            }
+            if (spectate_message(input + position, body_length, tiles, 
+                have_keyframe)) {
+                have_keyframe = TRUE;
+            }
+            used = position + body_length;
+        }
+        memmove(input, input + used, input_length - used);
+        input_length -= used;
+    }
+    close(fd);
+    return 0;
+}
+
+//applies one message to the board and prints it, returns TRUE once the
+//board is whole, a delta before the first keyframe is skipped
+int spectate_message(const unsigned char *data, int length, 
+    unsigned char tiles[ROWS][COLS], int have_keyframe) {
+
+    static struct tile board[ROWS][COLS];
+    unsigned char *cells = &tiles[0][0];
+    int position = 1;
+    int values[6];
+    for (int i = 0; i < 6; i++) {
+        values[i] = message_get_int(data, length, &position);
+    }
+
+    if (data[0] == BROADCAST_KEYFRAME) {
+        int cell = 0;
+        while (position < length && cell < ROWS * COLS) {
+            int run = message_get_int(data, length, &position);
+            for (int i = 0; i < run && cell < ROWS * COLS; i++) {
+                cells[cell++] = data[position];
+            }
+            position++;
+        }
+    } else if (!have_keyframe) {
+        return FALSE;
+    } else {
+        int changed = message_get_int(data, length, &position);
+        int cell = -1;
+        for (int i = 0; i < changed && position < length; i++) {
+            cell += message_get_int(data, length, &position) + 1;
+            if (cell < ROWS * COLS) {
+                cells[cell] = data[position];
+            }
+            position++;
+        }
+    }
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            board[i][j].entity = tiles[i][j] & 0x0F;
+            board[i][j].has_lava = (tiles[i][j] & BROADCAST_TILE_LAVA) != 0;
+            board[i][j].next_turn_lava = FALSE;
+        }
+    }
+    printf("Turn %d: score %d%s\n", values[0], values[2], 
+        data[0] == BROADCAST_KEYFRAME ? " (keyframe)" : "");
+    print_board(stdout, board, values[1]);
+    fflush(stdout);
+    return TRUE;
+}
+
+//reads a zigzag varint, -1 if the data ends in the middle of it
+int message_get_int(const unsigned char *data, int length, int *position) {
+
+    unsigned int zigzag = 0;
+    int shift = 0;
+    while (*position < length) {
+        int byte = data[(*position)++];
+        zigzag |= (unsigned int) (byte & 0x7F) << shift;
+        shift += 7;
+        if (!(byte & 0x80)) {
+            return (int) (zigzag >> 1) ^ -(int) (zigzag & 1);
+        }
+    }
+    return -1;
+}
+
+/*
+==============================================================================
+============================ END SPECTATING SECTION ==========================
+==============================================================================
+*/
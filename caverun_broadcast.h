@@ -0,0 +1,50 @@
+// caverun_broadcast.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Streams a game's boards to spectators over a local socket>
+
+/*
+Overview: A broadcast listens on a Unix socket while a game is played.
+Every board the game prints is sent to each connected spectator as the
+tiles that changed since the last board, with a keyframe of the whole board
+every BROADCAST_KEYFRAME_INTERVAL boards. Sending never blocks the game: a
+spectator whose socket is full stops getting deltas and picks up again at
+the first keyframe it has room for.
+*/
+
+#ifndef CAVERUN_BROADCAST_H
+#define CAVERUN_BROADCAST_H
+
+#include "caverun.h"
+
+#define BROADCAST_SPECTATORS          64
+#define BROADCAST_KEYFRAME_INTERVAL   32
+#define BROADCAST_MESSAGE_SIZE        (2 * ROWS * COLS + 64)
+#define BROADCAST_BUFFER_SIZE         (8 * BROADCAST_MESSAGE_SIZE)
+
+//one connected spectator and the messages it hasn't taken yet, the buffer
+//only ever holds whole messages so dropping the rest never splits one
+struct spectator {
+    int fd;
+    int needs_keyframe;
+    unsigned char buffer[BROADCAST_BUFFER_SIZE];
+    int length;
+    int sent;
+};
+
+struct broadcast {
+    int listen_fd;
+    const char *path;
+    struct spectator spectators[BROADCAST_SPECTATORS];
+    unsigned char last[ROWS][COLS];
+    int boards;
+};
+
+int broadcast_open(struct broadcast *broadcast, const char *path);
+void broadcast_board(struct broadcast *broadcast, 
+    struct tile board[ROWS][COLS], struct game_status *status, int turn);
+void broadcast_poll(struct broadcast *broadcast);
+void broadcast_close(struct broadcast *broadcast);
+int broadcast_spectate(const char *path);
+
+#endif
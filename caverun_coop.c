@@ -0,0 +1,776 @@
+// caverun_coop.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Several players digging the same cave together>
+
+/*
+Overview: The cave is set up on stdin exactly like the console game, and the
+starting position entered there is player 1's, who then plays on stdin.
+Every other player's input (a file or a FIFO, one per --coop) starts with
+their own starting position and then has their gameplay commands.
+
+Each player's input is read on its own thread, which parses whole commands
+and pushes them onto that player's coop_queue. The queue is a ring with a
+head only the reader moves and a tail only the simulation moves, each on its
+own cache line, so a push or pop is a load, a copy and a release store and
+no thread ever holds a lock. A reader that gets a full ring ahead just
+sleeps a moment and tries again.
+
+The simulation runs on the main thread once per tick. It takes at most one
+command from every player in player order, so the same inputs always play
+out the same way, then boulders and lava take a single turn for the whole
+cave. The engine's own rules are used for all of it: what game_status keeps
+about the player (position, score, lives, dash, lava code history) is kept
+for each player in their coop_player and swapped into the shared status
+while that player moves, is hit by a boulder or respawns. Boulders are
+swept in the same order as boulder_turn_scalar, and a tile with a player on
+it is played for whichever player is standing there.
+
+A player who runs out of lives, can't respawn or quits leaves the cave and
+the others play on. Anyone reaching an open exit wins the game for the team,
+and the game ends when every player is out or every input has ended.
+*/
+
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "caverun_coop.h"
+#include "caverun_session.h"
+
+#define COOP_RETRY_NS         NS_PER_MS
+
+int coop_setup(struct session *session, struct coop_player *first);
+void coop_begin(struct coop_game *game, struct game_state *state,
+    int player_count);
+int coop_start_reader(struct coop_player *player, int fd);
+void *coop_reader(void *arg);
+int coop_read_statement(struct coop_player *player, const char *data,
+    int length, int at_eof);
+void coop_join(struct coop_game *game, int player);
+void coop_tick(struct coop_game *game);
+int coop_inputs_done(struct coop_game *game);
+void coop_boulders(struct coop_game *game);
+void coop_boulder_move(struct coop_game *game, int r_offset, int c_offset,
+    int i, int j);
+int coop_hit(struct coop_game *game, int player, int respawn_event);
+int coop_player_at(struct coop_game *game, int row, int col);
+int coop_gravity_offsets(char gravity, int *r_offset, int *c_offset);
+int coop_team_score(struct coop_game *game);
+void coop_sleep_until(long long due_ns);
+void print_coop_events(struct coop_game *game, int player, int events);
+void print_coop_board(struct coop_game *game);
+
+/*
+==============================================================================
+============================= START CO-OP SECTION ============================
+==============================================================================
+*/
+
+//plays one co-op game, player 1 on stdin and one more player per path,
+//advancing every tick_ms
+int coop_play(const char *paths[], int path_count, int tick_ms) {
+
+    static struct coop_game game;
+    static struct session session;
+    int fds[COOP_MAX_PLAYERS];
+
+    for (int i = 0; i < path_count; i++) {
+        fds[i] = open(paths[i], O_RDONLY);
+        if (fds[i] < 0) {
+            perror(paths[i]);
+            return 1;
+        }
+    }
+
+    session_begin(&session, stdout);
+    if (!coop_setup(&session, &game.players[0])) {
+        return 0;
+    }
+    coop_begin(&game, &session.state, path_count + 1);
+    if (!coop_start_reader(&game.players[0], STDIN_FILENO)) {
+        return 1;
+    }
+    for (int i = 0; i < path_count; i++) {
+        if (!coop_start_reader(&game.players[i + 1], fds[i])) {
+            return 1;
+        }
+    }
+    for (int player = 1; player < game.player_count; player++) {
+        coop_join(&game, player);
+    }
+    print_coop_board(&game);
+
+    long long tick_ns = tick_ms * NS_PER_MS;
+    long long next_tick_ns = monotonic_ns() + tick_ns;
+    while (!game.over && !coop_inputs_done(&game)) {
+        coop_sleep_until(next_tick_ns);
+        coop_tick(&game);
+        fflush(stdout);
+        //ticks due while this one was played are dropped, not caught up
+        next_tick_ns += tick_ns;
+        long long now = monotonic_ns();
+        if (now >= next_tick_ns) {
+            next_tick_ns += ((now - next_tick_ns) / tick_ns + 1) * tick_ns;
+        }
+    }
+    return 0;
+}
+
+//reads the cave's setup from stdin, leaving anything typed after it for
+//player 1's reader, returns FALSE if input ended before there was a player
+int coop_setup(struct session *session, struct coop_player *first) {
+
+    int at_eof = FALSE;
+    first->input_length = 0;
+    while (session->phase != PHASE_GAMEPLAY) {
+        fflush(stdout);
+        int used = 0;
+        int step;
+        while (session->phase != PHASE_GAMEPLAY && (step = session_step(
+            session, first->input + used, first->input_length - used,
+            at_eof)) > 0) {
+            used += step;
+        }
+        memmove(first->input, first->input + used,
+            first->input_length - used);
+        first->input_length -= used;
+        if (session->phase == PHASE_GAMEPLAY) {
+            break;
+        } else if (at_eof) {
+            //the console game starts with whatever was entered
+            int started = session->phase == PHASE_FEATURES;
+            session_finish(session);
+            return started;
+        } else if (first->input_length == COOP_INPUT_SIZE) {
+            first->input_length = 0;
+        }
+
+        ssize_t count = read(STDIN_FILENO, first->input + first->input_length,
+            COOP_INPUT_SIZE - first->input_length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count <= 0) {
+            at_eof = TRUE;
+        } else {
+            first->input_length += count;
+        }
+    }
+    return TRUE;
+}
+
+//makes a co-op game of a started game, the player already on it being
+//player 1 and the others yet to join
+void coop_begin(struct coop_game *game, struct game_state *state,
+    int player_count) {
+
+    game->state = *state;
+    game->player_count = player_count;
+    game->turns = 0;
+    game->won = FALSE;
+    game->over = FALSE;
+    game->lava_ahead.generations = 0;
+
+    for (int i = 0; i < player_count; i++) {
+        struct coop_player *player = &game->players[i];
+        player->row = INVALID_ROW;
+        player->col = INVALID_COL;
+        player->start_row = INVALID_ROW;
+        player->start_col = INVALID_COL;
+        player->score = 0;
+        player->lives = INITIAL_LIVES;
+        player->can_dash = TRUE;
+        player->boulder_hit = FALSE;
+        player->lava_hit = FALSE;
+        player->out = FALSE;
+        memset(player->cmd_history, 0, sizeof(player->cmd_history));
+        atomic_init(&player->joined, FALSE);
+        atomic_init(&player->queue.head, 0);
+        atomic_init(&player->queue.tail, 0);
+        atomic_init(&player->queue.closed, FALSE);
+        if (i > 0) {
+            player->input_length = 0;
+        }
+    }
+    game->players[0].row = state->constants.start_row;
+    game->players[0].col = state->constants.start_col;
+    game->players[0].start_row = state->constants.start_row;
+    game->players[0].start_col = state->constants.start_col;
+    atomic_init(&game->players[0].joined, TRUE);
+}
+
+//starts the thread that reads one player's input, it is never joined since
+//it may be blocked on a terminal after the game is over
+int coop_start_reader(struct coop_player *player, int fd) {
+
+    player->fd = fd;
+    if (pthread_create(&player->reader, NULL, coop_reader, player) != 0) {
+        fprintf(stderr, "Couldn't start a reader thread\n");
+        return FALSE;
+    }
+    pthread_detach(player->reader);
+    return TRUE;
+}
+
+//turns one player's input into commands on their queue until it ends
+void *coop_reader(void *arg) {
+
+    struct coop_player *player = arg;
+    int at_eof = FALSE;
+
+    while (TRUE) {
+        int used = 0;
+        int step;
+        while ((step = coop_read_statement(player, player->input + used,
+            player->input_length - used, at_eof)) > 0) {
+            used += step;
+        }
+        memmove(player->input, player->input + used,
+            player->input_length - used);
+        player->input_length -= used;
+        if (at_eof) {
+            break;
+        } else if (player->input_length == COOP_INPUT_SIZE) {
+            player->input_length = 0;
+        }
+
+        ssize_t count = read(player->fd, player->input + player->input_length,
+            COOP_INPUT_SIZE - player->input_length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count <= 0) {
+            at_eof = TRUE;
+        } else {
+            player->input_length += count;
+        }
+    }
+    atomic_store_explicit(&player->queue.closed, TRUE, memory_order_release);
+    return NULL;
+}
+
+//parses one statement, the starting position or a command, returns how many
+//bytes it used or 0 if more are needed
+int coop_read_statement(struct coop_player *player, const char *data,
+    int length, int at_eof) {
+
+    struct scanner scanner = {data, length, 0, at_eof};
+    if (!skip_whitespace(&scanner)) {
+        return scanner.position;
+    }
+
+    enum scan_result result;
+    if (!atomic_load_explicit(&player->joined, memory_order_relaxed)) {
+        result = scan_int(&scanner, &player->start_row);
+        if (result == SCAN_OK) {
+            result = scan_int(&scanner, &player->start_col);
+        }
+        if (result == SCAN_MORE) {
+            return 0;
+        } else if (result == SCAN_FAIL) {
+            return scanner.position + 1;
+        }
+        atomic_store_explicit(&player->joined, TRUE, memory_order_release);
+        return scanner.position;
+    }
+
+    struct command command = {0, 0, 0};
+    if (scan_char(&scanner, &command.instruction) != SCAN_OK) {
+        return 0;
+    }
+    result = SCAN_OK;
+    if (command.instruction == ILLUMINATE) {
+        result = scan_int(&scanner, &command.radius);
+    } else if (command.instruction == GRAVITY || (isupper((unsigned char)
+        command.instruction) && command.instruction != LAVA_TRIGGER)) {
+        result = scan_char(&scanner, &command.instruction2);
+    }
+    if (result == SCAN_MORE) {
+        return 0;
+    } else if (result == SCAN_OK) {
+        while (!coop_queue_push(&player->queue, command)) {
+            coop_sleep_until(monotonic_ns() + COOP_RETRY_NS);
+        }
+    }
+    return scanner.position;
+}
+
+//puts a player on the cave at the starting position their input began
+//with, once it has arrived
+void coop_join(struct coop_game *game, int player) {
+
+    struct coop_player *joining = &game->players[player];
+    while (!atomic_load_explicit(&joining->joined, memory_order_acquire)) {
+        if (atomic_load_explicit(&joining->queue.closed,
+            memory_order_acquire)) {
+            printf("Player %d never joined!\n", player + 1);
+            joining->out = TRUE;
+            return;
+        }
+        coop_sleep_until(monotonic_ns() + COOP_RETRY_NS);
+    }
+
+    int row = joining->start_row;
+    int col = joining->start_col;
+    if (check_valid_placement(game->state.board, row, col) != PLACEMENT_OK) {
+        printf("Player %d: Position %d %d is invalid!\n", player + 1, row,
+            col);
+        joining->out = TRUE;
+        return;
+    }
+    set_entity(game->state.board, &game->state.status, row, col, PLAYER);
+    joining->row = row;
+    joining->col = col;
+}
+
+//plays one tick: a command from each player in turn, then one turn of
+//boulders and lava for the whole cave
+void coop_tick(struct coop_game *game) {
+
+    int events[COOP_MAX_PLAYERS];
+
+    for (int i = 0; i < game->player_count; i++) {
+        struct command command;
+        if (game->players[i].out ||
+            !coop_queue_pop(&game->players[i].queue, &command)) {
+            continue;
+        }
+        int player_events = coop_move(game, i, command);
+        print_coop_events(game, i, player_events);
+        if (game->won) {
+            game->over = TRUE;
+            return;
+        }
+    }
+
+    coop_entities_turns(game, events);
+    game->turns++;
+    for (int i = 0; i < game->player_count; i++) {
+        print_coop_events(game, i, events[i]);
+    }
+    print_coop_board(game);
+    if (game->over) {
+        printf("Game Lost! The team scored %d points!\n",
+            coop_team_score(game));
+    }
+}
+
+//whether every player still in the cave has run out of commands for good
+int coop_inputs_done(struct coop_game *game) {
+
+    for (int i = 0; i < game->player_count; i++) {
+        struct coop_queue *queue = &game->players[i].queue;
+        //anything pushed before the queue closed is seen once it has
+        if (!game->players[i].out && (!atomic_load_explicit(&queue->closed,
+            memory_order_acquire) || atomic_load_explicit(&queue->head,
+            memory_order_relaxed) != atomic_load_explicit(&queue->tail,
+            memory_order_relaxed))) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+==============================================================================
+============================== END CO-OP SECTION =============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+============================= START RULES SECTION ============================
+==============================================================================
+*/
+
+//swaps a player into the shared game status so the engine plays for them
+void coop_load(struct coop_game *game, int player) {
+
+    struct game_status *status = &game->state.status;
+    struct coop_player *from = &game->players[player];
+
+    status->player_row = from->row;
+    status->player_col = from->col;
+    status->score = from->score;
+    status->lives = from->lives;
+    status->can_dash = from->can_dash;
+    status->boulder_hit = FALSE;
+    status->lava_hit = FALSE;
+    status->game_won = FALSE;
+    status->game_over = FALSE;
+    memcpy(status->cmd_history, from->cmd_history,
+        sizeof(status->cmd_history));
+    game->state.constants.start_row = from->start_row;
+    game->state.constants.start_col = from->start_col;
+}
+
+//keeps what the engine did to the player that was swapped in
+void coop_store(struct coop_game *game, int player) {
+
+    struct game_status *status = &game->state.status;
+    struct coop_player *to = &game->players[player];
+
+    to->row = status->player_row;
+    to->col = status->player_col;
+    to->score = status->score;
+    to->lives = status->lives;
+    to->can_dash = status->can_dash;
+    to->boulder_hit |= status->boulder_hit;
+    to->lava_hit |= status->lava_hit;
+    memcpy(to->cmd_history, status->cmd_history, sizeof(to->cmd_history));
+    if (status->game_won) {
+        game->won = TRUE;
+    }
+}
+
+//plays one player's command without the boulders and lava, which move
+//once for everyone at the end of the tick, illumination, shadows and
+//queries are for the console game and do nothing here
+int coop_move(struct coop_game *game, int player, struct command command) {
+
+    struct game_status *status = &game->state.status;
+    char instruction = command.instruction;
+    int events = EVENT_NONE;
+
+    coop_load(game, player);
+    update_command_history(status, instruction);
+    events |= check_lava_code(status);
+
+    if (instruction == GRAVITY) {
+        status->gravity = command.instruction2;
+        events |= EVENT_GRAVITY;
+    } else if (instruction == QUIT) {
+        events |= EVENT_QUIT;
+    } else if (instruction == UP_SINGLE || instruction == DOWN_SINGLE ||
+        instruction == LEFT_SINGLE || instruction == RIGHT_SINGLE) {
+        move_player_single(game->state.board, status, instruction);
+    } else if (!isupper((unsigned char) instruction) ||
+        instruction == LAVA_TRIGGER) {
+    } else if (status->can_dash) {
+        move_player_dash(game->state.board, status, instruction,
+            command.instruction2);
+    } else {
+        status->can_dash = TRUE;
+        events |= EVENT_OUT_OF_BREATH;
+    }
+    if (status->game_won) {
+        events |= EVENT_WIN | EVENT_GAME_OVER;
+    }
+    coop_store(game, player);
+
+    if (instruction == QUIT) {
+        set_entity(game->state.board, status, game->players[player].row,
+            game->players[player].col, EMPTY);
+        game->players[player].out = TRUE;
+    }
+    return events;
+}
+
+//boulders then lava take one turn, hitting whichever players they reach,
+//each player's hits are reported in their own events
+void coop_entities_turns(struct coop_game *game,
+    int events[COOP_MAX_PLAYERS]) {
+
+    struct tile (*board)[COLS] = game->state.board;
+    struct game_status *status = &game->state.status;
+
+    for (int i = 0; i < game->player_count; i++) {
+        events[i] = EVENT_NONE;
+    }
+    coop_boulders(game);
+    for (int i = 0; i < game->player_count; i++) {
+        if (game->players[i].boulder_hit) {
+            game->players[i].boulder_hit = FALSE;
+            events[i] |= coop_hit(game, i, EVENT_BOULDER_RESPAWN);
+        }
+    }
+
+    lava_ahead_active = &game->lava_ahead;
+    lava_generation(board, status);
+    lava_ahead_active = NULL;
+    for (int i = 0; i < game->player_count; i++) {
+        struct coop_player *player = &game->players[i];
+        if (!player->out &&
+            board[player->row][player->col].entity == PLAYER &&
+            board[player->row][player->col].has_lava) {
+            set_entity(board, status, player->row, player->col, EMPTY);
+            events[i] |= coop_hit(game, i, EVENT_LAVA_RESPAWN);
+        }
+    }
+
+    game->over = TRUE;
+    for (int i = 0; i < game->player_count; i++) {
+        game->over &= game->players[i].out;
+    }
+}
+
+//one boulder turn for the whole cave, with settle or in the same order as
+//boulder_turn_scalar
+void coop_boulders(struct coop_game *game) {
+
+    int r_offset;
+    int c_offset;
+    if (!coop_gravity_offsets(game->state.status.gravity, &r_offset,
+        &c_offset)) {
+        return;
+    }
+
+    if (game->state.constants.settle) {
+        //like boulder_settle, only boulders already resting on a player
+        //hit them, then every line falls with the players in the way
+        for (int i = 0; i < game->player_count; i++) {
+            if (!game->players[i].out) {
+                coop_load(game, i);
+                boulder_settle_hit(game->state.board, &game->state.status,
+                    game->state.constants, r_offset, c_offset);
+                coop_store(game, i);
+            }
+        }
+        for (int i = 0; r_offset != 0 && i < COLS; i++) {
+            boulder_settle_line(game->state.board, &game->state.status,
+                r_offset > 0 ? 0 : LAST_ROW, i, r_offset, 0);
+        }
+        for (int i = 0; c_offset != 0 && i < ROWS; i++) {
+            boulder_settle_line(game->state.board, &game->state.status,
+                i, c_offset > 0 ? 0 : LAST_COL, 0, c_offset);
+        }
+    } else if (r_offset > 0) {
+        for (int i = 0; i < LAST_ROW; i++) {
+            for (int j = 0; j < COLS; j++) {
+                coop_boulder_move(game, 1, 0, i, j);
+            }
+        }
+    } else if (r_offset < 0) {
+        for (int i = LAST_ROW; i > 0; i--) {
+            for (int j = 0; j < COLS; j++) {
+                coop_boulder_move(game, -1, 0, i, j);
+            }
+        }
+    } else if (c_offset > 0) {
+        for (int j = 0; j < LAST_COL; j++) {
+            for (int i = 0; i < ROWS; i++) {
+                coop_boulder_move(game, 0, 1, i, j);
+            }
+        }
+    } else {
+        for (int j = LAST_COL; j > 0; j--) {
+            for (int i = 0; i < ROWS; i++) {
+                coop_boulder_move(game, 0, -1, i, j);
+            }
+        }
+    }
+}
+
+//boulder_move for one tile, played for the player standing on it if any
+void coop_boulder_move(struct coop_game *game, int r_offset, int c_offset,
+    int i, int j) {
+
+    int player = -1;
+    if (game->state.board[i][j].entity == PLAYER) {
+        player = coop_player_at(game, i, j);
+    }
+    if (player >= 0) {
+        coop_load(game, player);
+    }
+    boulder_move(game->state.board, &game->state.status,
+        game->state.constants, r_offset, c_offset, i, j);
+    if (player >= 0) {
+        coop_store(game, player);
+    }
+}
+
+//loses a player a life, a player who can't go on leaves the cave and
+//whatever was under them stays
+int coop_hit(struct coop_game *game, int player, int respawn_event) {
+
+    struct coop_player *hit = &game->players[player];
+    enum entity under = game->state.board[hit->row][hit->col].entity;
+
+    coop_load(game, player);
+    enum hit_result result = resolve_player_hit(game->state.board,
+        &game->state.status, game->state.constants);
+    coop_store(game, player);
+    if (result == HIT_RESPAWN) {
+        return respawn_event;
+    }
+
+    set_entity(game->state.board, &game->state.status, hit->row, hit->col,
+        under == PLAYER ? EMPTY : under);
+    hit->out = TRUE;
+    if (result == HIT_NO_LIVES) {
+        return EVENT_LOST;
+    }
+    return EVENT_RESPAWN_BLOCKED;
+}
+
+//which player is standing on a tile, -1 if none
+int coop_player_at(struct coop_game *game, int row, int col) {
+
+    for (int i = 0; i < game->player_count; i++) {
+        if (!game->players[i].out && game->players[i].row == row &&
+            game->players[i].col == col) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+//the offsets boulder_move looks back up the line with for a gravity,
+//FALSE if it isn't one of the four directions
+int coop_gravity_offsets(char gravity, int *r_offset, int *c_offset) {
+
+    *r_offset = 0;
+    *c_offset = 0;
+    if (gravity == GRAVITY_UP) {
+        *r_offset = 1;
+    } else if (gravity == GRAVITY_DOWN) {
+        *r_offset = -1;
+    } else if (gravity == GRAVITY_LEFT) {
+        *c_offset = 1;
+    } else if (gravity == GRAVITY_RIGHT) {
+        *c_offset = -1;
+    } else {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+//every player's points added together
+int coop_team_score(struct coop_game *game) {
+
+    int score = 0;
+    for (int i = 0; i < game->player_count; i++) {
+        score += game->players[i].score;
+    }
+    return score;
+}
+
+//sleeps until the monotonic clock reaches a time
+void coop_sleep_until(long long due_ns) {
+
+    struct timespec due = {due_ns / NS_PER_SEC, due_ns % NS_PER_SEC};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) ==
+        EINTR) {
+    }
+}
+
+/*
+==============================================================================
+============================== END RULES SECTION =============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+============================ START OUTPUT SECTION ============================
+==============================================================================
+*/
+
+//prints what happened to one player
+void print_coop_events(struct coop_game *game, int player, int events) {
+
+    struct coop_player *who = &game->players[player];
+    int number = player + 1;
+
+    if (events & EVENT_GAME_OF_LAVA) {
+        printf("Game Of Lava: Activated\n");
+    } else if (events & EVENT_LAVA_SEEDS) {
+        printf("Lava Seeds: Activated\n");
+    }
+    if (events & EVENT_GRAVITY) {
+        print_gravity_direction(stdout, &game->state.status);
+    } else if (events & EVENT_OUT_OF_BREATH) {
+        printf("Player %d is out of breath! Skipping dash move...\n", number);
+    } else if (events & EVENT_QUIT) {
+        printf("Player %d has left the cave with %d point(s).\n", number,
+            who->score);
+    }
+
+    if (events & EVENT_WIN) {
+        print_coop_board(game);
+        printf("Player %d reached the exit! Team score: %d point(s)!\n",
+            number, coop_team_score(game));
+    }
+    if (events & (EVENT_BOULDER_RESPAWN | EVENT_LAVA_RESPAWN)) {
+        printf("Player %d: Respawning!\n", number);
+    }
+    if (events & EVENT_LOST) {
+        printf("Player %d is out of lives with %d point(s)!\n", number,
+            who->score);
+    } else if (events & EVENT_RESPAWN_BLOCKED) {
+        printf("Player %d: Respawn blocked! Final score: %d point(s).\n",
+            number, who->score);
+    }
+}
+
+//prints the cave with the team's lives, then where each player is
+void print_coop_board(struct coop_game *game) {
+
+    int lives = 0;
+    for (int i = 0; i < game->player_count; i++) {
+        lives += game->players[i].out ? 0 : game->players[i].lives;
+    }
+    print_board(stdout, game->state.board, lives);
+
+    for (int i = 0; i < game->player_count; i++) {
+        struct coop_player *player = &game->players[i];
+        if (player->out) {
+            printf("Player %d: out, %d point(s)\n", i + 1, player->score);
+        } else {
+            printf("Player %d: %d %d, %d li%s, %d point(s)\n", i + 1,
+                player->row, player->col, player->lives,
+                player->lives == 1 ? "fe" : "ves", player->score);
+        }
+    }
+}
+
+/*
+==============================================================================
+============================= END OUTPUT SECTION =============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+============================= START QUEUE SECTION ============================
+==============================================================================
+*/
+
+//adds a command for the simulation, FALSE if the ring is full, only the
+//player's reader thread may call this
+int coop_queue_push(struct coop_queue *queue, struct command command) {
+
+    unsigned head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head - tail == COOP_QUEUE_SIZE) {
+        return FALSE;
+    }
+    queue->commands[head % COOP_QUEUE_SIZE] = command;
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return TRUE;
+}
+
+//takes the oldest command, FALSE if there isn't one, only the simulation
+//may call this
+int coop_queue_pop(struct coop_queue *queue, struct command *command) {
+
+    unsigned tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (head == tail) {
+        return FALSE;
+    }
+    *command = queue->commands[tail % COOP_QUEUE_SIZE];
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return TRUE;
+}
+
+/*
+==============================================================================
+============================== END QUEUE SECTION =============================
+==============================================================================
+*/
@@ -0,0 +1,81 @@
+// caverun_coop.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Several players digging the same cave together>
+
+/*
+Overview: A co-op game is one cave shared by 2 to COOP_MAX_PLAYERS players,
+each with their own position, starting point, lives, score and dash. Every
+player's commands are read on their own thread and handed to the simulation
+through that player's own single-producer single-consumer queue, so reading
+never takes a lock and never waits on the game. The simulation runs on a
+fixed tick: it takes at most one command from each queue in player order,
+then boulders and lava take one turn for everyone.
+*/
+
+#ifndef CAVERUN_COOP_H
+#define CAVERUN_COOP_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "caverun.h"
+
+#define COOP_MAX_PLAYERS      8
+#define COOP_QUEUE_SIZE       64
+#define COOP_INPUT_SIZE       256
+#define COOP_CACHE_LINE       64
+
+//commands from one reader thread to the simulation, the head is only ever
+//written by the reader and the tail by the simulation
+struct coop_queue {
+    struct command commands[COOP_QUEUE_SIZE];
+    _Alignas(COOP_CACHE_LINE) atomic_uint head;
+    _Alignas(COOP_CACHE_LINE) atomic_uint tail;
+    atomic_int closed;
+};
+
+//one player, what the engine keeps in game_status for a single player is
+//kept here and swapped in while it is their go
+struct coop_player {
+    int row;
+    int col;
+    int start_row;
+    int start_col;
+    int score;
+    int lives;
+    int can_dash;
+    int boulder_hit;
+    int lava_hit;
+    int out;
+    char cmd_history[CMD_HISTORY_LENGTH];
+    int fd;
+    pthread_t reader;
+    atomic_int joined;
+    char input[COOP_INPUT_SIZE];
+    int input_length;
+    struct coop_queue queue;
+};
+
+struct coop_game {
+    struct game_state state;
+    struct coop_player players[COOP_MAX_PLAYERS];
+    int player_count;
+    int turns;
+    int won;
+    int over;
+    struct lava_ahead lava_ahead;
+};
+
+int coop_play(const char *paths[], int path_count, int tick_ms);
+
+void coop_load(struct coop_game *game, int player);
+void coop_store(struct coop_game *game, int player);
+int coop_move(struct coop_game *game, int player, struct command command);
+void coop_entities_turns(struct coop_game *game,
+    int events[COOP_MAX_PLAYERS]);
+
+int coop_queue_push(struct coop_queue *queue, struct command command);
+int coop_queue_pop(struct coop_queue *queue, struct command *command);
+
+#endif
@@ -0,0 +1,491 @@
+// caverun_differential.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <The fast engine checked against the original rules>
+
+/*
+Overview: Each seed makes a scenario: a starting position, a list of map
+features and a list of commands, drawn from a splitmix64 stream so the same
+seed always makes the same game. Moves are the most common commands, with
+dashes, waits, gravity changes, shadow and illumination toggles and whole
+lava codes mixed in so every kernel gets exercised.
+
+The scenario is set up on two games. The reference game has engine_reference on
+and no lava worked out ahead, so it plays boulder_turn_scalar, game_of_lava or
+lava_seeds, a check_hidden ray per tile and illuminate_scalar exactly as the
+rules were first written. The optimised game has every fast path on, with
+shadowcasting on even seeds and the ray shadows shared out between threads (on
+boards big enough for the pool) on odd ones. After each turn the events, the
+player's status, both hashes, every tile of the true board, every tile the
+player can see and the text it is printed as are compared, and the first
+difference is the divergence. The reference game is printed with
+print_board_scalar, a fprintf per tile, and the optimised one with print_board.
+
+A diverging scenario is cut off after the turn it diverged on and then shrunk
+greedily: each command and then each feature is dropped in turn, and kept
+out if the games still diverge without it. What is left is printed as input
+for the console game along with where the two engines first disagreed.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+
+#include "caverun.h"
+#include "caverun_differential.h"
+#include "caverun_session.h"
+
+#define DIFFERENTIAL_MAX_TURNS     1000
+#define DIFFERENTIAL_MAX_FEATURES  40
+#define DIFFERENTIAL_LAVA_CODE     5
+#define DIFFERENTIAL_BOARD_TEXT    ((2 * ROWS + 4) * (4 * COLS + 2) + 64)
+#define DIFFERENTIAL_DETAIL        96
+
+//a command that is no move at all, so only boulders and lava have a turn
+#define DIFFERENTIAL_PASS          '.'
+
+//one generated game
+struct scenario {
+    int shadowcast;
+    int player_row;
+    int player_col;
+    struct placement_request features[DIFFERENTIAL_MAX_FEATURES];
+    int feature_count;
+    struct command commands[DIFFERENTIAL_MAX_TURNS];
+    int command_count;
+};
+
+//where the reference and optimised games first disagreed
+struct divergence {
+    int turn;
+    const char *what;
+    int row;
+    int col;
+    char detail[DIFFERENTIAL_DETAIL];
+};
+
+//both games being played in lockstep
+struct differential_pair {
+    struct game_state reference;
+    struct game_state optimised;
+    struct tile reference_view[ROWS][COLS];
+    struct tile optimised_view[ROWS][COLS];
+    struct lava_ahead ahead;
+    char reference_text[DIFFERENTIAL_BOARD_TEXT];
+    char optimised_text[DIFFERENTIAL_BOARD_TEXT];
+};
+
+void scenario_generate(struct scenario *scenario, uint64_t seed, int turns);
+void scenario_feature(struct placement_request *feature, uint64_t *rng);
+int scenario_commands(struct command commands[], uint64_t *rng);
+int random_below(uint64_t *rng, int limit);
+void scenario_setup(struct game_state *state, struct scenario *scenario,
+    int reference);
+int differential_play(struct differential_pair *pair,
+    struct scenario *scenario, struct divergence *divergence);
+int compare_status(struct game_state *reference,
+    struct game_state *optimised, struct divergence *divergence);
+int compare_boards(struct tile reference[ROWS][COLS],
+    struct tile optimised[ROWS][COLS], const char *what,
+    struct divergence *divergence);
+int compare_rendering(struct differential_pair *pair,
+    struct divergence *divergence);
+void render_board(char *text, struct tile board[ROWS][COLS], int lives,
+    int reference);
+void scenario_minimise(struct differential_pair *pair,
+    struct scenario *scenario, struct divergence *divergence);
+void print_reproducer(FILE *out, struct scenario *scenario,
+    struct divergence *divergence);
+void print_command(FILE *out, struct command command);
+const char *entity_name(enum entity entity);
+
+//plays every seed on both engines, returns 1 if any of them diverged
+int differential_run(struct differential_options *options) {
+
+    static struct differential_pair pair;
+    static struct scenario scenario;
+    int turns = options->turns > DIFFERENTIAL_MAX_TURNS ?
+        DIFFERENTIAL_MAX_TURNS : options->turns;
+    long long played = 0;
+    int diverged = 0;
+
+    for (int seed = 1; seed <= options->seeds; seed++) {
+        struct divergence divergence;
+        scenario_generate(&scenario, seed, turns);
+        played += scenario.command_count;
+        if (!differential_play(&pair, &scenario, &divergence)) {
+            continue;
+        }
+        diverged++;
+        printf("Seed %d diverged at turn %d: %s\n", seed, divergence.turn,
+            divergence.detail);
+        scenario_minimise(&pair, &scenario, &divergence);
+        print_reproducer(stdout, &scenario, &divergence);
+    }
+    printf("%d of %d seed(s) diverged, %lld turn(s) played\n", diverged,
+        options->seeds, played);
+    return diverged > 0;
+}
+
+/*
+==============================================================================
+=========================== START SCENARIO SECTION ===========================
+==============================================================================
+*/
+
+//makes the game for a seed with up to turns commands
+void scenario_generate(struct scenario *scenario, uint64_t seed, int turns) {
+
+    uint64_t rng = seed * ZOBRIST_SEED;
+
+    //half the seeds check shadowcast, the others the (parallel) ray shadows
+    scenario->shadowcast = seed % 2 == 0;
+    scenario->player_row = random_below(&rng, ROWS);
+    scenario->player_col = random_below(&rng, COLS);
+    scenario->feature_count = random_below(&rng, DIFFERENTIAL_MAX_FEATURES);
+    for (int i = 0; i < scenario->feature_count; i++) {
+        scenario_feature(&scenario->features[i], &rng);
+    }
+    scenario->command_count = 0;
+    while (scenario->command_count + DIFFERENTIAL_LAVA_CODE <= turns) {
+        scenario->command_count += scenario_commands(
+            scenario->commands + scenario->command_count, &rng);
+    }
+}
+
+//one random map feature, mostly boulders and lava since they move
+void scenario_feature(struct placement_request *feature, uint64_t *rng) {
+
+    const char kinds[] = {PLACE_BOULDER, PLACE_BOULDER, PLACE_BOULDER,
+        PLACE_LAVA, PLACE_LAVA, PLACE_LAVA, PLACE_WALL, PLACE_GEM,
+        PLACE_EXIT, PLACE_GROUPED_WALLS};
+
+    feature->instruction = kinds[random_below(rng, sizeof(kinds))];
+    feature->start_row = random_below(rng, ROWS);
+    feature->start_col = random_below(rng, COLS);
+    feature->end_row = feature->start_row + random_below(rng, 3);
+    feature->end_col = feature->start_col + random_below(rng, 3);
+}
+
+//writes the next command, or a whole lava code, returns how many
+int scenario_commands(struct command commands[], uint64_t *rng) {
+
+    const char moves[] = {UP_SINGLE, DOWN_SINGLE, LEFT_SINGLE, RIGHT_SINGLE};
+    const char dashes[] = {UP_DASH, DOWN_DASH, LEFT_DASH, RIGHT_DASH};
+    const char lava_codes[2][DIFFERENTIAL_LAVA_CODE] = {
+        {UP_SINGLE, RIGHT_SINGLE, DOWN_SINGLE, LEFT_SINGLE, LAVA_TRIGGER},
+        {UP_SINGLE, LEFT_SINGLE, DOWN_SINGLE, RIGHT_SINGLE, LAVA_TRIGGER}
+    };
+    int roll = random_below(rng, 100);
+    struct command command = {moves[random_below(rng, 4)], 0, 0};
+
+    if (roll < 4) {
+        const char *code = lava_codes[random_below(rng, 2)];
+        for (int i = 0; i < DIFFERENTIAL_LAVA_CODE; i++) {
+            commands[i] = (struct command) {code[i], 0, 0};
+        }
+        return DIFFERENTIAL_LAVA_CODE;
+    } else if (roll < 10) {
+        command.instruction = GRAVITY;
+        command.instruction2 = moves[random_below(rng, 4)];
+    } else if (roll < 14) {
+        command.instruction = SHADOW;
+    } else if (roll < 17) {
+        command.instruction = ILLUMINATE;
+        command.radius = random_below(rng, ROWS);
+    } else if (roll < 30) {
+        command.instruction = DIFFERENTIAL_PASS;
+    } else if (roll < 45) {
+        command.instruction = dashes[random_below(rng, 4)];
+        command.instruction2 = moves[random_below(rng, 4)];
+    }
+    commands[0] = command;
+    return 1;
+}
+
+//a random number from 0 up to but not including limit
+int random_below(uint64_t *rng, int limit) {
+
+    return (int) (splitmix64(rng) % (uint64_t) limit);
+}
+
+//sets up a scenario's game with either the reference or optimised engine,
+//features that can't be placed are left out as the console game would
+void scenario_setup(struct game_state *state, struct scenario *scenario,
+    int reference) {
+
+    engine_initialise(state);
+    engine_reference(state, reference);
+    engine_shadowcast(state, !reference && scenario->shadowcast);
+    engine_place_player(state, scenario->player_row, scenario->player_col);
+    for (int i = 0; i < scenario->feature_count; i++) {
+        struct placement_request *feature = &scenario->features[i];
+        if (feature->instruction == PLACE_GROUPED_WALLS) {
+            engine_place_grouped_walls(state, feature->start_row,
+                feature->start_col, feature->end_row, feature->end_col);
+        } else {
+            engine_place_feature(state, feature->instruction,
+                feature->start_row, feature->start_col);
+        }
+    }
+    engine_start(state);
+}
+
+/*
+==============================================================================
+============================ END SCENARIO SECTION ============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+============================ START COMPARE SECTION ===========================
+==============================================================================
+*/
+
+//plays a scenario on both engines, returns TRUE and where if they diverge
+int differential_play(struct differential_pair *pair,
+    struct scenario *scenario, struct divergence *divergence) {
+
+    scenario_setup(&pair->reference, scenario, TRUE);
+    scenario_setup(&pair->optimised, scenario, FALSE);
+    pair->ahead.generations = 0;
+
+    for (int turn = 0; turn < scenario->command_count; turn++) {
+        struct command command = scenario->commands[turn];
+        divergence->turn = turn + 1;
+
+        int reference_events = engine_step(&pair->reference, command);
+        lava_ahead_active = &pair->ahead;
+        int optimised_events = engine_step(&pair->optimised, command);
+        lava_ahead_active = NULL;
+
+        if (reference_events != optimised_events) {
+            divergence->what = "events";
+            divergence->row = INVALID_ROW;
+            divergence->col = INVALID_COL;
+            snprintf(divergence->detail, DIFFERENTIAL_DETAIL,
+                "events %#x, optimised %#x", reference_events,
+                optimised_events);
+            return TRUE;
+        }
+        if (compare_boards(pair->reference.board, pair->optimised.board,
+            "board", divergence) || compare_status(&pair->reference,
+            &pair->optimised, divergence) || compare_rendering(pair,
+            divergence)) {
+            return TRUE;
+        }
+        if (reference_events & EVENT_GAME_OVER) {
+            break;
+        }
+    }
+    return FALSE;
+}
+
+//compares what game_status holds about the player and the game
+int compare_status(struct game_state *reference,
+    struct game_state *optimised, struct divergence *divergence) {
+
+    struct game_status *a = &reference->status;
+    struct game_status *b = &optimised->status;
+    const char *field = NULL;
+
+    if (a->player_row != b->player_row || a->player_col != b->player_col) {
+        field = "player position";
+    } else if (a->score != b->score) {
+        field = "score";
+    } else if (a->lives != b->lives) {
+        field = "lives";
+    } else if (a->can_dash != b->can_dash || a->game_won != b->game_won ||
+        a->game_over != b->game_over) {
+        field = "player flags";
+    } else if (a->gravity != b->gravity || a->lava_mode != b->lava_mode ||
+        a->shadowed != b->shadowed || a->illumination != b->illumination) {
+        field = "modes";
+    } else if (a->entity_hash != b->entity_hash ||
+        a->lava_hash != b->lava_hash) {
+        field = "hash";
+    }
+    if (field == NULL) {
+        return FALSE;
+    }
+    divergence->what = "status";
+    divergence->row = a->player_row;
+    divergence->col = a->player_col;
+    snprintf(divergence->detail, DIFFERENTIAL_DETAIL, "%s differs", field);
+    return TRUE;
+}
+
+//finds the first tile where two boards differ
+int compare_boards(struct tile reference[ROWS][COLS],
+    struct tile optimised[ROWS][COLS], const char *what,
+    struct divergence *divergence) {
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            struct tile a = reference[i][j];
+            struct tile b = optimised[i][j];
+            if (a.entity == b.entity && !a.has_lava == !b.has_lava) {
+                continue;
+            }
+            divergence->what = what;
+            divergence->row = i;
+            divergence->col = j;
+            snprintf(divergence->detail, DIFFERENTIAL_DETAIL,
+                "%s %d %d is %s%s, optimised %s%s", what, i, j,
+                entity_name(a.entity), a.has_lava ? " on lava" : "",
+                entity_name(b.entity), b.has_lava ? " on lava" : "");
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+//compares the board the player sees and the text it is printed as
+int compare_rendering(struct differential_pair *pair,
+    struct divergence *divergence) {
+
+    int reference_visible = compute_visible_board(pair->reference_view,
+        &pair->reference);
+    int optimised_visible = compute_visible_board(pair->optimised_view,
+        &pair->optimised);
+    struct tile (*reference)[COLS] = reference_visible ?
+        pair->reference_view : pair->reference.board;
+    struct tile (*optimised)[COLS] = optimised_visible ?
+        pair->optimised_view : pair->optimised.board;
+
+    if (compare_boards(reference, optimised, "visible tile", divergence)) {
+        return TRUE;
+    }
+    render_board(pair->reference_text, reference,
+        pair->reference.status.lives, TRUE);
+    render_board(pair->optimised_text, optimised,
+        pair->optimised.status.lives, FALSE);
+    if (strcmp(pair->reference_text, pair->optimised_text) == 0) {
+        return FALSE;
+    }
+    divergence->what = "rendering";
+    divergence->row = INVALID_ROW;
+    divergence->col = INVALID_COL;
+    snprintf(divergence->detail, DIFFERENTIAL_DETAIL,
+        "printed boards differ");
+    return TRUE;
+}
+
+//prints a board into a string the way the console game would, with the
+//provided printing code for the reference game
+void render_board(char *text, struct tile board[ROWS][COLS], int lives,
+    int reference) {
+
+    FILE *out = fmemopen(text, DIFFERENTIAL_BOARD_TEXT, "w");
+    if (out == NULL) {
+        text[0] = '\0';
+        return;
+    }
+    if (reference) {
+        print_board_scalar(out, board, lives);
+    } else {
+        print_board(out, board, lives);
+    }
+    fclose(out);
+}
+
+/*
+==============================================================================
+============================= END COMPARE SECTION ============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+=========================== START MINIMISE SECTION ===========================
+==============================================================================
+*/
+
+//shrinks a diverging scenario to the fewest commands and features that
+//still diverge, leaving where it now diverges in divergence
+void scenario_minimise(struct differential_pair *pair,
+    struct scenario *scenario, struct divergence *divergence) {
+
+    static struct scenario trial;
+    struct divergence found;
+
+    scenario->command_count = divergence->turn;
+    for (int i = scenario->command_count - 1; i >= 0; i--) {
+        trial = *scenario;
+        memmove(&trial.commands[i], &trial.commands[i + 1],
+            (trial.command_count - i - 1) * sizeof(trial.commands[0]));
+        trial.command_count--;
+        if (differential_play(pair, &trial, &found)) {
+            trial.command_count = found.turn;
+            *scenario = trial;
+            *divergence = found;
+            i = i > scenario->command_count ? scenario->command_count : i;
+        }
+    }
+    for (int i = scenario->feature_count - 1; i >= 0; i--) {
+        trial = *scenario;
+        memmove(&trial.features[i], &trial.features[i + 1],
+            (trial.feature_count - i - 1) * sizeof(trial.features[0]));
+        trial.feature_count--;
+        if (differential_play(pair, &trial, &found)) {
+            *scenario = trial;
+            *divergence = found;
+        }
+    }
+    differential_play(pair, scenario, divergence);
+}
+
+//prints a scenario as console input, then what went wrong on its last turn
+void print_reproducer(FILE *out, struct scenario *scenario,
+    struct divergence *divergence) {
+
+    fprintf(out, "--- Reproducer: %d feature(s), %d command(s) ---\n",
+        scenario->feature_count, scenario->command_count);
+    fprintf(out, "%d %d\n", scenario->player_row, scenario->player_col);
+    for (int i = 0; i < scenario->feature_count; i++) {
+        struct placement_request *feature = &scenario->features[i];
+        if (feature->instruction == PLACE_GROUPED_WALLS) {
+            fprintf(out, "%c %d %d %d %d\n", feature->instruction,
+                feature->start_row, feature->start_col, feature->end_row,
+                feature->end_col);
+        } else {
+            fprintf(out, "%c %d %d\n", feature->instruction,
+                feature->start_row, feature->start_col);
+        }
+    }
+    fprintf(out, "%c\n", START);
+    for (int i = 0; i < scenario->command_count; i++) {
+        print_command(out, scenario->commands[i]);
+    }
+    fprintf(out, "--- Diverges at turn %d: %s ---\n", divergence->turn,
+        divergence->detail);
+}
+
+//prints one command the way it would be typed
+void print_command(FILE *out, struct command command) {
+
+    if (command.instruction == ILLUMINATE) {
+        fprintf(out, "%c %d\n", command.instruction, command.radius);
+    } else if (command.instruction2 != 0) {
+        fprintf(out, "%c %c\n", command.instruction, command.instruction2);
+    } else {
+        fprintf(out, "%c\n", command.instruction);
+    }
+}
+
+//a tile's entity in words
+const char *entity_name(enum entity entity) {
+
+    const char *names[ENTITY_TYPES] = {"empty", "dirt", "a wall",
+        "a boulder", "a gem", "a locked exit", "an open exit", "hidden",
+        "the player"};
+    return names[entity];
+}
+
+/*
+==============================================================================
+============================ END MINIMISE SECTION ============================
+==============================================================================
+*/
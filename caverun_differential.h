@@ -0,0 +1,28 @@
+// caverun_differential.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <The fast engine checked against the original rules>
+
+/*
+Overview: Every fast path in the engine (boulder bit masks, lava worked out
+ahead, shadowcasting, parallel shadows) has to give exactly what the
+original tile by tile code gives. A differential run generates random games
+from seeds and plays each one on two engines in lockstep, one with
+engine_reference on and one with every fast path on, comparing everything
+after every turn. Each game that diverges is shrunk to the fewest features
+and commands that still diverge, and printed as console input.
+*/
+
+#ifndef CAVERUN_DIFFERENTIAL_H
+#define CAVERUN_DIFFERENTIAL_H
+
+#define DIFFERENTIAL_DEFAULT_TURNS  200
+
+struct differential_options {
+    int seeds;
+    int turns;
+};
+
+int differential_run(struct differential_options *options);
+
+#endif
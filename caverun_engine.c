@@ -0,0 +1,1347 @@
+// caverun_engine.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <The rules of CS Caverun, with no input or output>
+
+/*
+Overview: This file is the engine behind the console game. Setup places the
+player and features, and each call to engine_step plays one command: the
+player moves or dashes, then the boulders fall and the lava evolves, and any
+hit is resolved by respawning or ending the game. Instead of printing, every
+step returns EVENT_ flags so the front-end can say what happened, and the
+engine never exits the process.
+*/
+
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "caverun.h"
+#include "caverun_profile.h"
+
+const int D_ROW[ASCII_LIMIT] = {
+    [UP_SINGLE] = -1, [DOWN_SINGLE] = 1, [LEFT_SINGLE] = 0, [RIGHT_SINGLE] = 0,
+    [UP_DASH] = -1, [DOWN_DASH] = 1, [LEFT_DASH] = 0, [RIGHT_DASH] = 0   
+};
+const int D_COL[ASCII_LIMIT] = {
+    [UP_SINGLE] = 0, [DOWN_SINGLE] = 0, [LEFT_SINGLE] = -1, [RIGHT_SINGLE] = 1,
+    [UP_DASH] = 0, [DOWN_DASH] = 0, [LEFT_DASH] = -1, [RIGHT_DASH] = 1
+};
+
+struct zobrist_keys zobrist;
+
+/*
+==============================================================================
+========================== START ENGINE API SECTION ==========================
+==============================================================================
+*/
+
+//sets up an empty map of dirt, ready for the player and features
+void engine_initialise(struct game_state *state) {
+
+    static pthread_once_t keys_once = PTHREAD_ONCE_INIT;
+    pthread_once(&keys_once, initialise_zobrist_keys);
+
+    initialise_board(state->board);
+    state->constants.start_row = INVALID_ROW;
+    state->constants.start_col = INVALID_COL;
+    state->constants.settle = FALSE;
+    state->constants.shadowcast = FALSE;
+    state->constants.reference = FALSE;
+    state->status.game_over = FALSE;
+}
+
+//makes boulders fall all the way to rest each turn instead of one tile
+void engine_settle_boulders(struct game_state *state, int enabled) {
+
+    state->constants.settle = enabled;
+}
+
+//works out shadows in one sweep from the player instead of a ray per tile
+void engine_shadowcast(struct game_state *state, int enabled) {
+
+    state->constants.shadowcast = enabled;
+}
+
+//plays every turn with the original tile by tile loops, single threaded
+//shadows and a distance per lit tile instead of the faster versions, which
+//must always give the same
+void engine_reference(struct game_state *state, int enabled) {
+
+    state->constants.reference = enabled;
+}
+
+//places the player's starting position
+enum placement engine_place_player(struct game_state *state, int row, int col) {
+
+    if (row >= ROWS || row < 0 || 
+        col >= COLS || col < 0) {
+        return PLACEMENT_OFF_MAP;
+    }
+    state->board[row][col].entity = PLAYER;
+    state->constants.start_row = row;
+    state->constants.start_col = col;
+    return PLACEMENT_OK;
+}
+
+//adds a single-tile feature to the map
+enum placement engine_place_feature(struct game_state *state,
+    char instruction, int row, int col) {
+
+    struct tile (*board)[COLS] = state->board;
+    enum placement placement = check_valid_placement(board, row, col);
+
+    if (placement == PLACEMENT_OK) {
+        if (instruction == PLACE_WALL) {
+            board[row][col].entity = WALL;
+        } else if (instruction == PLACE_BOULDER) {
+            board[row][col].entity = BOULDER;
+        } else if (instruction == PLACE_GEM) {
+            board[row][col].entity = GEM;
+        } else if (instruction == PLACE_LAVA) {
+            board[row][col].has_lava = TRUE;
+        } else if (instruction == PLACE_EXIT) {
+            board[row][col].entity = EXIT_LOCKED;
+        }
+    }
+    return placement;
+}
+
+//places walls on each tile in the rectangular bound
+enum placement engine_place_grouped_walls(struct game_state *state,
+    int start_row, int start_col, int end_row, int end_col) {
+
+    enum placement placement = validate_grouped_walls(state->board, 
+        start_row, start_col, end_row, end_col);
+
+    if (placement == PLACEMENT_OK) {
+        for (int i = start_row; i <= end_row; i++) {
+            for (int j = start_col; j <= end_col; j++) {
+                state->board[i][j].entity = WALL;
+            }
+        }
+    }
+    return placement;
+}
+
+//finishes setup, the game can be stepped after this
+void engine_start(struct game_state *state) {
+
+    //no game status exists yet, the hash is computed once it does
+    if (entity_counter(state->board, GEM) == 0) {
+        open_exits(state->board, NULL);
+    }
+    initialise_constants_and_game_status(state->board, 
+        &state->status, &state->constants);
+}
+
+//plays a single command and reports everything that happened as events
+int engine_step(struct game_state *state, struct command command) {
+
+    struct game_status *status = &state->status;
+    char instruction = command.instruction;
+    int events = EVENT_NONE;
+
+    if (status->game_over) {
+        return EVENT_GAME_OVER;
+    }
+
+    update_command_history(status, instruction);
+    events |= check_lava_code(status);
+
+    //must pass turn if instruction is L to not trigger any events
+    if (instruction == LAVA_TRIGGER) {
+    } else if (!isupper(instruction)) {
+        if (instruction == ILLUMINATE) {
+            events |= illuminate_toggle(status, command.radius) | EVENT_RENDER;
+        } else if (instruction == SHADOW) {
+            events |= shadow_toggle(status) | EVENT_RENDER;
+        } else if (instruction == GRAVITY) {
+            status->gravity = command.instruction2;
+            events |= EVENT_GRAVITY | entities_turns(state);
+        } else if (instruction == QUIT) {
+            status->game_over = TRUE;
+            events |= EVENT_QUIT | EVENT_GAME_OVER;
+        } else if (instruction == PRINT_SCORE || 
+            instruction == PRINT_MAP_STATS || instruction == HINT ||
+            instruction == PRINT_PROFILE) {
+            //queries don't change the game, the front-end answers them
+        } else {
+            PROFILE_START(move_timer);
+            move_player_single(state->board, status, instruction);
+            PROFILE_STOP(move_timer, TIMER_MOVE);
+            events |= end_of_move(state);
+        }
+    } else if (status->can_dash) {
+        PROFILE_START(move_timer);
+        move_player_dash(state->board, status, 
+            instruction, command.instruction2);
+        PROFILE_STOP(move_timer, TIMER_MOVE);
+        events |= end_of_move(state);
+    } else {
+        status->can_dash = TRUE; 
+        events |= EVENT_OUT_OF_BREATH | EVENT_RENDER;
+    }
+    return events;
+}
+
+//the cave moves on one turn without the player, e.g. a real-time tick with
+//no key pressed, it isn't a command so it is part of no lava code and
+//leaves the dash alone
+int engine_tick(struct game_state *state) {
+
+    if (state->status.game_over) {
+        return EVENT_GAME_OVER;
+    }
+    return entities_turns(state);
+}
+
+//the player's current score
+int engine_score(struct game_state *state) {
+
+    return state->status.score;
+}
+
+//tile counts, completion and points left for the map statistics command
+void engine_map_statistics(struct game_state *state,
+    struct map_statistics *statistics) {
+
+    statistics->dirt = entity_counter(state->board, DIRT);
+    statistics->gems = entity_counter(state->board, GEM);
+    statistics->boulders = entity_counter(state->board, BOULDER);
+    statistics->completion_percentage = 
+        calc_completion_percent(state->board, state->constants);
+    statistics->maximum_points_remaining = 
+        calc_max_points_remaining(state->board, state->status);
+}
+
+//how many tiles are covered in lava
+int engine_lava_cells(struct game_state *state) {
+
+    int count = 0;
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            count += state->board[i][j].has_lava;
+        }
+    }
+    return count;
+}
+
+//fingerprint of the whole game state, read in constant time
+uint64_t engine_hash(struct game_state *state) {
+
+    return game_state_hash(&state->status);
+}
+
+/*
+==============================================================================
+=========================== END ENGINE API SECTION ===========================
+==============================================================================
+*/
+
+/*
+==============================================================================
+=========================== START GAMEPLAY SECTION ===========================
+==============================================================================
+*/
+
+//moves player by a single tile
+void move_player_single(struct tile board[ROWS][COLS], 
+    struct game_status *status, char instruction) {
+
+    int new_row = status->player_row + D_ROW[(int) instruction];
+    int new_col = status->player_col + D_COL[(int) instruction];
+
+    if (valid_move(board, new_row, new_col)) {
+        status->score += update_score(board, status, new_row, new_col);
+        //makes the current tile empty
+        set_entity(board, status, 
+            status->player_row, status->player_col, EMPTY);
+        status->player_row = new_row;
+        status->player_col = new_col;
+        //if player is on exit tile, exits the game
+        check_exit_condition(board, status);
+        //makes the new tile the player
+        set_entity(board, status, 
+            status->player_row, status->player_col, PLAYER);
+    }
+    status->can_dash = TRUE;
+}
+
+//moves player by multiple tiles if dash is valid
+void move_player_dash(struct tile board[ROWS][COLS], 
+    struct game_status *status, char instruction, char instruction2) {
+    
+    //immediately ensures the next action cannot be a dash
+    status->can_dash = FALSE; 
+    
+    //maps first movement instruction to new board location
+    int new_row1 = status->player_row + D_ROW[(int) instruction];
+    int new_col1 = status->player_col + D_COL[(int) instruction];
+    if (!valid_move(board, new_row1, new_col1)) {
+        return;  
+    }
+    //apply first move
+    dash_move(board, status, new_row1, new_col1);
+    if (status->game_won) {
+        return;
+    }
+
+    //maps second movement instruction to new board location
+    int new_row2 = status->player_row + D_ROW[(int) instruction2];
+    int new_col2 = status->player_col + D_COL[(int) instruction2];
+    if (!valid_move(board, new_row2, new_col2)) {
+        set_entity(board, status, 
+            status->player_row, status->player_col, PLAYER);
+        return;
+    }
+    //apply second move
+    dash_move(board, status, new_row2, new_col2);
+    set_entity(board, status, status->player_row, status->player_col, PLAYER);
+}
+
+//applies the move once it's valid
+void dash_move(struct tile board[ROWS][COLS], 
+    struct game_status *status, int new_row, int new_col) {
+
+    status->score += update_score(board, status, new_row, new_col);
+    set_entity(board, status, status->player_row, status->player_col, EMPTY);
+    status->player_row = new_row;
+    status->player_col = new_col;
+
+    check_exit_condition(board, status);
+}
+
+//ends the game if the move reached an open exit, otherwise the boulders and
+//lava take their turn
+int end_of_move(struct game_state *state) {
+
+    if (state->status.game_won) {
+        state->status.game_over = TRUE;
+        return EVENT_WIN | EVENT_GAME_OVER;
+    }
+    return entities_turns(state);
+}
+
+//control movement and logic of all boulder and lava entities
+int entities_turns(struct game_state *state) {
+
+    struct game_status *status = &state->status;
+    int events = EVENT_TURN;
+
+    PROFILE_START(boulder_timer);
+    boulder_turn(state->board, status, state->constants);
+    PROFILE_STOP(boulder_timer, TIMER_BOULDERS);
+    if (status->boulder_hit) {
+        status->boulder_hit = FALSE;
+        events |= player_hit(state, EVENT_BOULDER_RESPAWN);
+        if (status->game_over) {
+            return events;
+        }
+    }
+
+    PROFILE_START(lava_timer);
+    lava_turn(state->board, status);
+    PROFILE_STOP(lava_timer, TIMER_LAVA);
+    if (status->lava_hit) {
+        status->lava_hit = FALSE;
+        events |= player_hit(state, EVENT_LAVA_RESPAWN);
+    }
+    return events | EVENT_RENDER;
+}
+
+//boulder movement based on direction of gravity, a whole line of the
+//board at a time, see caverun_boulders.c
+void boulder_turn(struct tile board[ROWS][COLS], 
+    struct game_status *status, struct constants constants) {
+
+    if (constants.settle) {
+        boulder_settle(board, status, constants);
+    } else if (constants.reference) {
+        boulder_turn_scalar(board, status, constants);
+    } else {
+        boulder_turn_bits(board, status, constants);
+    }
+}
+
+//the same boulder movement one tile at a time, the rules as written
+void boulder_turn_scalar(struct tile board[ROWS][COLS], 
+    struct game_status *status, struct constants constants) {
+
+    if (status->gravity == GRAVITY_UP) {
+        for (int i = 0; i < LAST_ROW; i++) {
+            for (int j = 0; j < COLS; j++) {
+                boulder_move(board, status, constants, 1, 0, i, j);
+            }
+        }
+    } else if (status->gravity == GRAVITY_DOWN) {
+        for (int i = LAST_ROW; i > 0; i--) {
+            for (int j = 0; j < COLS; j++) {
+                boulder_move(board, status, constants, -1, 0, i, j);
+            }
+        }
+    } else if (status->gravity == GRAVITY_LEFT) {
+        for (int j = 0; j < LAST_COL; j++) {
+            for (int i = 0; i < ROWS; i++) {
+                boulder_move(board, status, constants, 0, 1, i, j);
+            }
+        }
+    } else if (status->gravity == GRAVITY_RIGHT) {
+        for (int j = LAST_COL; j > 0; j--) {
+            for (int i = 0; i < ROWS; i++) {
+                boulder_move(board, status, constants, 0, -1, i, j);
+            }
+        }
+    }
+}
+
+//physically moves the boulders
+void boulder_move(struct tile board[ROWS][COLS], struct game_status *status,
+    struct constants constants, int r_offset, int c_offset, int i, int j) {
+
+    ///boulder hits player and spawn is currently occupied
+    if (board[i][j].entity == PLAYER && 
+        board[i + r_offset][j + c_offset].entity == BOULDER && 
+        board[constants.start_row]
+        [constants.start_col].entity != EMPTY) {
+        boulder_spawn_check(board, status, 
+            constants, r_offset, c_offset, i, j);
+        status->boulder_hit = TRUE;
+    }
+    //boulder moves down into space
+    else if (board[i][j].entity == EMPTY && 
+        board[i + r_offset][j + c_offset].entity == BOULDER) {
+        set_entity(board, status, i, j, BOULDER);
+        set_entity(board, status, i + r_offset, j + c_offset, EMPTY);
+        PROFILE_COUNT(COUNT_BOULDERS_MOVED, 1);
+    }
+    //boulder hits player on 1 life
+    if (board[i][j].entity == PLAYER && 
+        board[i + r_offset][j + c_offset].entity == BOULDER && 
+        status->lives == 1) {
+        set_entity(board, status, i + r_offset, j + c_offset, EMPTY);
+        status->boulder_hit = TRUE;
+    } 
+    //boulder hits player on 2+ lives
+    else if (board[i][j].entity == PLAYER && 
+        board[i + r_offset][j + c_offset].entity == BOULDER && 
+        status->lives > 1) {
+        set_entity(board, status, i, j, BOULDER);
+        set_entity(board, status, i + r_offset, j + c_offset, EMPTY);
+        PROFILE_COUNT(COUNT_BOULDERS_MOVED, 1);
+        status->boulder_hit = TRUE;
+    }  
+}
+
+//moves every boulder as far as it can fall in one pass, giving the same
+//board as repeating boulder_turn until nothing moves except next to the
+//player: a boulder that lands on top of the player stops there this turn
+//and only hits them on the next, where repeated turns would hit them now
+void boulder_settle(struct tile board[ROWS][COLS], 
+    struct game_status *status, struct constants constants) {
+
+    //each line starts at the end gravity pulls towards, the offsets point
+    //back up the line the same way they do in boulder_move
+    int r_offset = 0;
+    int c_offset = 0;
+    if (status->gravity == GRAVITY_UP) {
+        r_offset = 1;
+    } else if (status->gravity == GRAVITY_DOWN) {
+        r_offset = -1;
+    } else if (status->gravity == GRAVITY_LEFT) {
+        c_offset = 1;
+    } else if (status->gravity == GRAVITY_RIGHT) {
+        c_offset = -1;
+    } else {
+        return;
+    }
+
+    //only a boulder already resting on the player hits them, one that lands
+    //there this turn stops on top of them like it would in a normal turn
+    boulder_settle_hit(board, status, constants, r_offset, c_offset);
+
+    if (r_offset != 0) {
+        for (int j = 0; j < COLS; j++) {
+            boulder_settle_line(board, status, 
+                r_offset > 0 ? 0 : LAST_ROW, j, r_offset, 0);
+        }
+    } else {
+        for (int i = 0; i < ROWS; i++) {
+            boulder_settle_line(board, status, 
+                i, c_offset > 0 ? 0 : LAST_COL, 0, c_offset);
+        }
+    }
+}
+
+//packs the boulders of one row or column against the next obstacle below
+//them, anything that isn't empty or a boulder (the player included) stops
+//the boulders behind it
+void boulder_settle_line(struct tile board[ROWS][COLS], 
+    struct game_status *status, int row, int col, int r_offset, int c_offset) {
+
+    int free_row = row;
+    int free_col = col;
+    for (int i = row, j = col; i >= 0 && i < ROWS && j >= 0 && j < COLS;
+        i += r_offset, j += c_offset) {
+        if (board[i][j].entity == BOULDER) {
+            if (i != free_row || j != free_col) {
+                set_entity(board, status, free_row, free_col, BOULDER);
+                set_entity(board, status, i, j, EMPTY);
+                PROFILE_COUNT(COUNT_BOULDERS_MOVED, 1);
+            }
+            free_row += r_offset;
+            free_col += c_offset;
+        } else if (board[i][j].entity != EMPTY) {
+            free_row = i + r_offset;
+            free_col = j + c_offset;
+        }
+    }
+}
+
+//checks the player the way boulder_move would on the first sweep of a turn
+void boulder_settle_hit(struct tile board[ROWS][COLS], 
+    struct game_status *status, struct constants constants, 
+    int r_offset, int c_offset) {
+
+    int row = status->player_row;
+    int col = status->player_col;
+    if (board[row][col].entity == PLAYER &&
+        row + r_offset >= 0 && row + r_offset < ROWS &&
+        col + c_offset >= 0 && col + c_offset < COLS) {
+        boulder_move(board, status, constants, r_offset, c_offset, row, col);
+    }
+}
+
+//checks whether that the boulder that hits the player will be at spawn
+//after hit
+void boulder_spawn_check(struct tile board[ROWS][COLS], 
+    struct game_status *status, struct constants constants, 
+    int r_offset, int c_offset, int i, int j) {
+
+    //is spawn is occupied by a boulder?
+    if (board[constants.start_row][constants.start_col].entity == BOULDER) {
+        //if so, is it the same boulder that is going to hit the player?
+        if (i + r_offset == constants.start_row && 
+            j + c_offset == constants.start_col) {
+            set_entity(board, status, i + r_offset, j + c_offset, EMPTY);
+            set_entity(board, status, i, j, BOULDER);
+        } else {
+            set_entity(board, status, i + r_offset, j + c_offset, EMPTY);
+        }
+    } else {
+        set_entity(board, status, i + r_offset, j + c_offset, EMPTY);
+    }
+}
+
+//handles lava movement and damage, several turns ahead at a time if the
+//caller keeps them, see caverun_lava.c
+void lava_turn(struct tile board[ROWS][COLS], struct game_status *status) {
+
+    if (lava_ahead_active != NULL) {
+        lava_turn_blocked(board, status, lava_ahead_active);
+    } else {
+        lava_turn_scalar(board, status);
+    }
+}
+
+//moves the lava on one generation without looking at the player, for games
+//that check several players' tiles themselves
+void lava_generation(struct tile board[ROWS][COLS], 
+    struct game_status *status) {
+
+    if (lava_ahead_active != NULL) {
+        lava_ahead_step(board, status, lava_ahead_active);
+    } else if (status->lava_mode == GAME_OF_LAVA) {
+        game_of_lava(board, status);
+    } else if (status->lava_mode == LAVA_SEEDS) {
+        lava_seeds(board, status);
+    }
+}
+
+//handles lava movement and damage one generation at a time
+void lava_turn_scalar(struct tile board[ROWS][COLS], 
+    struct game_status *status) {
+
+    if (status->lava_mode == GAME_OF_LAVA) {
+        game_of_lava(board, status);
+    } else if (status->lava_mode == LAVA_SEEDS) {
+        lava_seeds(board, status);
+    }
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            if (board[i][j].entity == PLAYER && board[i][j].has_lava) {
+                set_entity(board, status, i, j, EMPTY);
+                status->lava_hit = TRUE;
+            }
+        }
+    }
+}
+
+//handles the logic for lava birth, survival and death in game of lava
+void game_of_lava(struct tile board[ROWS][COLS], struct game_status *status) {
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            int adjacent_lava_count = count_adjacent_lava(board, i, j);
+            if (!board[i][j].has_lava && adjacent_lava_count == 
+                LAVA_GAME_BIRTH_COUNT) {
+                board[i][j].next_turn_lava = TRUE;
+            } else if (board[i][j].has_lava && 
+                (adjacent_lava_count == LAVA_SURVIVE_MIN || 
+                adjacent_lava_count == LAVA_SURVIVE_MAX)) {
+                board[i][j].next_turn_lava = TRUE;
+            } else if (board[i][j].has_lava && 
+                (adjacent_lava_count < LAVA_SURVIVE_MIN || 
+                adjacent_lava_count > LAVA_SURVIVE_MAX)) {
+                board[i][j].next_turn_lava = FALSE;
+            }
+        }
+    }
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            PROFILE_COUNT(COUNT_LAVA_BORN, 
+                !board[i][j].has_lava && board[i][j].next_turn_lava);
+            PROFILE_COUNT(COUNT_LAVA_KILLED, 
+                board[i][j].has_lava && !board[i][j].next_turn_lava);
+            set_lava(board, status, i, j, board[i][j].next_turn_lava);
+            board[i][j].next_turn_lava = FALSE;
+        }
+    }
+}
+
+//handles the logic for lava birth, survival and death in lava seeds
+void lava_seeds(struct tile board[ROWS][COLS], struct game_status *status) {
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            int adjacent_lava_count = count_adjacent_lava(board, i , j);
+            if (!board[i][j].has_lava && adjacent_lava_count == 
+                LAVA_SEED_BIRTH_COUNT) {
+                board[i][j].next_turn_lava = TRUE;
+            } else {
+                board[i][j].next_turn_lava = FALSE;
+            }
+        }
+    }
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            PROFILE_COUNT(COUNT_LAVA_BORN, 
+                !board[i][j].has_lava && board[i][j].next_turn_lava);
+            PROFILE_COUNT(COUNT_LAVA_KILLED, 
+                board[i][j].has_lava && !board[i][j].next_turn_lava);
+            set_lava(board, status, i, j, board[i][j].next_turn_lava);
+            board[i][j].next_turn_lava = FALSE;
+        }
+    }
+}
+
+//handles consequences of player being hit by boulder of lava
+int player_hit(struct game_state *state, int respawn_event) {
+
+    enum hit_result result = resolve_player_hit(state->board, 
+        &state->status, state->constants);
+    if (result == HIT_RESPAWN) {
+        return respawn_event;
+    }
+
+    state->status.game_over = TRUE;
+    if (result == HIT_NO_LIVES) {
+        return EVENT_LOST | EVENT_GAME_OVER | EVENT_RENDER;
+    }
+    //the whole board goes dark when the player can't respawn
+    state->status.shadow_entire_board = TRUE;
+    return EVENT_RESPAWN_BLOCKED | EVENT_GAME_OVER | EVENT_RENDER;
+}
+
+//applies the rules of a hit to the board without printing anything
+enum hit_result resolve_player_hit(struct tile true_board[ROWS][COLS], 
+    struct game_status *status, struct constants constants) {
+
+    (status->lives)--;
+    if (status->lives == 0) {
+        set_entity(true_board, status, 
+            status->player_row, status->player_col, PLAYER);
+        return HIT_NO_LIVES;
+    } 
+    //respawn point is clear
+    if (true_board[constants.start_row][constants.start_col].entity == EMPTY &&
+        true_board[constants.start_row]
+        [constants.start_col].has_lava == FALSE) {
+        set_entity(true_board, status, 
+            constants.start_row, constants.start_col, PLAYER);
+        status->player_row = constants.start_row;
+        status->player_col = constants.start_col;
+        return HIT_RESPAWN;
+    }
+    set_entity(true_board, status, 
+        status->player_row, status->player_col, PLAYER);
+    return HIT_RESPAWN_BLOCKED;
+}
+
+//toggles the state of the illumination flag
+int illuminate_toggle(struct game_status *status, int radius) {
+
+    status->illumination_radius = radius;
+
+    if (status->illumination_radius <= 0) {
+        status->illumination = FALSE;
+        return EVENT_ILLUMINATION_OFF;
+    } else {
+        status->illumination = TRUE;
+        return EVENT_ILLUMINATION_ON;
+    }
+}
+
+//toggles the state of the shadowed flag
+int shadow_toggle(struct game_status *status) {
+
+    if (status->shadowed == FALSE) {
+        status->shadowed = TRUE;
+        return EVENT_SHADOW_ON;
+    } else {
+        status->shadowed = FALSE;
+        return EVENT_SHADOW_OFF;
+    }
+}
+
+//maps the true board to the game board, with hidden tiles based on radius
+//from the player, see illuminate_scalar for the rules as written
+void illuminate(struct tile game_board[ROWS][COLS], 
+    struct tile true_board[ROWS][COLS], struct game_status status) {
+
+    //any radius past the size of the board lights all of it
+    long long radius = status.illumination_radius;
+    if (radius > 2 * (ROWS + COLS)) {
+        radius = 2 * (ROWS + COLS);
+    }
+
+    for (int i = 0; i < ROWS; i++) {
+        //the lit tiles of a row are one span around the player's column,
+        //found once for the row instead of a sqrt per tile
+        long long row_distance = i - status.player_row;
+        long long room = radius * radius - row_distance * row_distance;
+        int first_col = COLS;
+        int last_col = -1;
+        if (radius >= 0 && room >= 0) {
+            int reach = (int) sqrt((double) room);
+            while ((long long) reach * reach > room) {
+                reach--;
+            }
+            while ((long long) (reach + 1) * (reach + 1) <= room) {
+                reach++;
+            }
+            first_col = status.player_col - reach;
+            last_col = status.player_col + reach;
+        }
+        for (int j = 0; j < COLS; j++) {
+            game_board[i][j].has_lava = true_board[i][j].has_lava;
+            if (j >= first_col && j <= last_col) {
+                game_board[i][j].entity = true_board[i][j].entity;
+            } else {
+                game_board[i][j].entity = HIDDEN;
+            }
+        }
+    }
+}
+
+//the same mapping with a distance worked out for every tile, as written
+void illuminate_scalar(struct tile game_board[ROWS][COLS], 
+    struct tile true_board[ROWS][COLS], struct game_status status) {
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            game_board[i][j].has_lava = true_board[i][j].has_lava;
+            double distance = 
+                sqrt((i - status.player_row) * (i - status.player_row) + 
+                (j - status.player_col) * (j - status.player_col));
+            if (distance <= status.illumination_radius) {
+                game_board[i][j].entity = true_board[i][j].entity;
+            } else {
+                game_board[i][j].entity = HIDDEN;
+            }
+        }
+    }
+}
+
+//maps the true board to the game board, with hidden tiles based on shadows
+//big boards share their rows out between threads, see caverun_visibility.c
+void shadow(struct tile game_board[ROWS][COLS], 
+    struct tile true_board[ROWS][COLS], struct game_status status) {
+
+    if (ROWS * COLS >= VISIBILITY_PARALLEL_TILES && 
+        shadow_parallel(game_board, true_board, status)) {
+        return;
+    }
+    shadow_rows(game_board, true_board, status, 0, ROWS);
+}
+
+//shadows the rows from first_row up to but not including last_row, returns
+//the number of rays traced
+int shadow_rows(struct tile game_board[ROWS][COLS], 
+    struct tile true_board[ROWS][COLS], struct game_status status,
+    int first_row, int last_row) {
+
+    int rays = 0;
+    for (int i = first_row; i < last_row; i++) {
+        for (int j = 0; j < COLS; j++) {
+            int hide = 0;
+            game_board[i][j].has_lava = true_board[i][j].has_lava;
+            if (true_board[i][j].entity != PLAYER) {
+                hide = check_hidden(true_board, status, i, j);
+                rays++;
+            }
+            if (!hide) {
+                game_board[i][j].entity = true_board[i][j].entity;
+            } else {
+                game_board[i][j].entity = HIDDEN;
+            }
+        }
+    }
+    return rays;
+}
+
+//checks each tile and whether it should be hidden using rays
+int check_hidden(struct tile board[ROWS][COLS], 
+    struct game_status status, int i, int j) {
+
+    PROFILE_COUNT(COUNT_RAYS_TRACED, 1);
+    int start_x = status.player_row;
+    int start_y = status.player_col;
+    int gradient_x = i - start_x;
+    int gradient_y = j - start_y;
+    int corner_blocked_above = FALSE;
+    int corner_blocked_below = FALSE;
+
+    for (double lambda = 0; lambda < 1; lambda += SHADOW_RAY_STEP) {
+        double raw_row = start_x + lambda * gradient_x;
+        double raw_col = start_y + lambda * gradient_y;
+        int current_row = (int)(round(raw_row));
+        int current_col = (int)(round(raw_col));
+
+        //stop before reaching the actual tile as to not give false positives
+        if (raw_row >= i - 0.5 && raw_row <= i + 0.5 &&
+            raw_col >= j - 0.5 && raw_col <= j + 0.5) {
+            break;
+        }
+        //corner check
+        if (fabs(fmod(raw_row, 1.0) - 0.5) < EPSILON &&
+            fabs(fmod(raw_col, 1.0) - 0.5) < EPSILON) {
+            corner_blocked_above |= above_corner_check(board, 
+                raw_row, raw_col, gradient_x, gradient_y);
+            corner_blocked_below |= below_corner_check(board, 
+                raw_row, raw_col, gradient_x , gradient_y);
+        } else {
+            char type = board[current_row][current_col].entity;
+            if (type == WALL || type == BOULDER || type == GEM) {
+                return TRUE;
+            }
+        }
+    }
+
+    if (corner_blocked_above && corner_blocked_below) {
+        return TRUE;
+    } else {
+        return FALSE; 
+    }
+}
+
+//checks whether one of the tiles directly above the corner causes a blocked ray
+int above_corner_check(struct tile board[ROWS][COLS], 
+    double row, double col, int gradient_x, int gradient_y) {
+
+    int base_row = (int)(floor(row));
+    int base_col;
+
+    /*
+    this check determines whether to check the left or right side of the
+    corner since at the very last corner, you don't want to check the actual
+    tile itself and give a false positive
+    */
+    if (gradient_x * gradient_y > 0) {
+        base_col = (int)(ceil(col));
+    } else {
+        base_col = (int)(floor(col));
+    }
+    return (type_check(board, base_row, base_col));
+}
+
+//checks whether one of the tiles directly below the corner causes a blocked ray
+int below_corner_check(struct tile board[ROWS][COLS], 
+    double row, double col, int gradient_x, int gradient_y) {
+
+    int base_row = (int)(ceil(row));
+    int base_col;
+
+    /*
+    this check determines whether to check the left or right side of the
+    corner since at the very last corner, you don't want to check the actual
+    tile itself and give a false positive
+    */
+    if (gradient_x * gradient_y > 0) {
+        base_col = (int)(floor(col));
+    } else {
+        base_col = (int)(ceil(col));
+    }
+    return (type_check(board, base_row, base_col));
+}
+
+/*
+==============================================================================
+============================ END GAMEPLAY SECTION ============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+============================ START HELPER SECTION ============================
+==============================================================================
+*/
+
+//initialises every constant and variable in the structs
+void initialise_constants_and_game_status(struct tile true_board[ROWS][COLS],
+    struct game_status *status, struct constants *constants) {
+
+    status->player_row = constants->start_row;
+    status->player_col = constants->start_col; 
+    constants->init_dirt = entity_counter(true_board, DIRT);
+    constants->init_gem = entity_counter(true_board, GEM);
+
+    status->score = 0;
+    status->can_dash = TRUE;
+    status->boulder_hit = FALSE;
+    status->lava_hit = FALSE;
+    status->game_won = FALSE;
+    status->game_over = FALSE;
+    status->lives = INITIAL_LIVES;
+
+    status->illumination = FALSE;
+    status->illumination_radius = 0;
+    status->shadowed = FALSE;
+    status->shadow_entire_board = FALSE;
+    status->gravity = GRAVITY_DOWN;
+    status->lava_mode = LAVA_NONE;
+
+    for (int i = 0; i < CMD_HISTORY_LENGTH; i++) {
+        status->cmd_history[i] = 0;
+    }
+    compute_board_hash(true_board, status);
+}
+
+//determines whether a tile placement is valid
+enum placement check_valid_placement(struct tile board[ROWS][COLS], 
+    int row, int col) {
+
+    if (row < 0 || row >= ROWS || 
+        col < 0 || col >= COLS) {
+        return PLACEMENT_OFF_MAP;
+    } else if (board[row][col].entity != DIRT) {
+        return PLACEMENT_OCCUPIED;
+    } 
+    return PLACEMENT_OK;
+}
+
+//determines whether any tile in the rectangular bound is invalid to place on
+enum placement validate_grouped_walls(struct tile board[ROWS][COLS], 
+    int start_row, int start_col, int end_row, int end_col) {
+
+    //validate map rectangle bounds
+    if (start_row < 0 || start_row >= ROWS || 
+        start_col < 0 || start_col >= COLS ||
+        end_row < 0 || end_row >= ROWS || 
+        end_col < 0 || end_col >= COLS) {
+        return PLACEMENT_OFF_MAP;
+    } 
+    //validates tile occupation i.e. all tiles need to be free
+    int is_occupied = FALSE;
+    for (int i = start_row; i <= end_row; i++) {
+        for (int j = start_col; j <= end_col; j++) {
+            if (board[i][j].entity != DIRT) {
+                is_occupied = TRUE;
+                //saves unnecessary checking once one invalid tile is found
+                break;
+            }
+        }
+    }
+
+    if (is_occupied) {
+        return PLACEMENT_OCCUPIED;
+    } else {
+        return PLACEMENT_OK;
+    }            
+}
+
+//checks whether movement will arrive at a valid destination
+int valid_move(struct tile board[ROWS][COLS], int new_row, int new_col) {
+
+    return (new_row >= 0 && new_row < ROWS &&
+        new_col >= 0 && new_col < COLS &&
+        (board[new_row][new_col].entity == EMPTY ||
+        board[new_row][new_col].entity == DIRT ||
+        board[new_row][new_col].entity == GEM ||
+        board[new_row][new_col].entity == EXIT_UNLOCKED));
+}
+
+//counts how many type of a certain entity are currently on the board
+int entity_counter(struct tile board[ROWS][COLS], enum entity entity_type) {
+    int counter = 0; 
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            if (board[i][j].entity == entity_type) {
+                counter++;
+            }
+        }
+    }
+    return counter;
+}
+
+//updates the score based on dirt and gem collection
+int update_score(struct tile board[ROWS][COLS], 
+    struct game_status *status, int row, int col) {
+        
+    if (board[row][col].entity == DIRT) {
+        if (status->lava_mode != LAVA_NONE) {
+            return POINTS_DIRT_LAVA;
+        } else {
+            return POINTS_DIRT_NORMAL;
+        }
+    } else if (board[row][col].entity == GEM) {
+        set_entity(board, status, row, col, EMPTY);
+        if (status->lava_mode != LAVA_NONE) {
+            return POINTS_GEM_LAVA;
+        } else {
+            return POINTS_GEM_NORMAL;
+        }
+    }
+    return 0;
+}
+
+//calculates the maximum remaining points depending on game mode
+int calc_max_points_remaining(struct tile board[ROWS][COLS], 
+    struct game_status status) {
+    
+    int maximum_points_remaining;
+    if (status.lava_mode != LAVA_NONE) {
+        maximum_points_remaining = (entity_counter(board, DIRT) * 
+        POINTS_DIRT_LAVA) + (entity_counter(board, GEM) * POINTS_GEM_LAVA);
+    } else {
+        maximum_points_remaining = entity_counter(board, DIRT) * 
+        POINTS_DIRT_NORMAL + 
+        (entity_counter(board, GEM) * POINTS_GEM_NORMAL);
+    }
+    return maximum_points_remaining;
+}
+
+//calculates how much of the map the player has explored
+double calc_completion_percent(struct tile board[ROWS][COLS], 
+    struct constants constants) {
+
+    double completion_percentage = 100.0 * 
+    (1.0 - (double)(entity_counter(board, DIRT) + entity_counter(board, GEM)) /
+    (constants.init_dirt + constants.init_gem));
+
+    return completion_percentage;
+}
+
+//determines whether to open the exits based on how many gems remaining
+//and flags the game as won if the player is standing on an open exit
+void check_exit_condition(struct tile board[ROWS][COLS], 
+    struct game_status *status) {
+
+    if (entity_counter(board, GEM) == 0) {
+        open_exits(board, status);
+    }
+
+    if (board[status->player_row][status->player_col].entity == 
+        EXIT_UNLOCKED) {
+        set_entity(board, status, 
+            status->player_row, status->player_col, PLAYER);
+        status->game_won = TRUE;
+    }
+}
+
+//opens all exits on the map
+void open_exits(struct tile board[ROWS][COLS], struct game_status *status) {
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            if (board[i][j].entity == EXIT_LOCKED) {
+                set_entity(board, status, i, j, EXIT_UNLOCKED);
+            }
+        }
+    }
+}
+
+//intakes new commands to check whether lava mode should be activated
+void update_command_history(struct game_status *status, char new_command) {
+
+    for (int i = 0; i < CMD_HISTORY_LENGTH - 1; i++) {
+        status->cmd_history[i] = status->cmd_history[i + 1];
+    }
+    status->cmd_history[CMD_HISTORY_LENGTH - 1] = new_command;
+}
+
+//checks whether the command history matches a lava code
+int check_lava_code(struct game_status *status) {
+
+    int events = EVENT_NONE;
+
+    if (status->cmd_history[0] == UP_SINGLE && 
+        status->cmd_history[1] == RIGHT_SINGLE &&
+        status->cmd_history[2] == DOWN_SINGLE && 
+        status->cmd_history[3] == LEFT_SINGLE &&
+        status->cmd_history[4] == LAVA_TRIGGER) {
+        if (status->lava_mode != GAME_OF_LAVA) {
+            events = EVENT_GAME_OF_LAVA;
+        }
+        status->lava_mode = GAME_OF_LAVA;
+    } else if (status->cmd_history[0] == UP_SINGLE && 
+        status->cmd_history[1] == LEFT_SINGLE &&
+        status->cmd_history[2] == DOWN_SINGLE && 
+        status->cmd_history[3] == RIGHT_SINGLE &&
+        status->cmd_history[4] == LAVA_TRIGGER) {
+        if (status->lava_mode != LAVA_SEEDS) {
+            events = EVENT_LAVA_SEEDS;
+        }
+        status->lava_mode = LAVA_SEEDS;
+    }
+    return events;
+}
+
+//counts all 8 tiles around a tile and how many of them are lava
+int count_adjacent_lava(struct tile board[ROWS][COLS], int i, int j) {
+
+    int adjacent_lava_counter = 0;
+
+    //tiles in the first/last row/column wrap around to the other side
+    int up = WRAP_BACK(i, ROWS);
+    int down = WRAP_NEXT(i, ROWS);
+    int left = WRAP_BACK(j, COLS);
+    int right = WRAP_NEXT(j, COLS);
+
+    if (board[up][left].has_lava) {
+        adjacent_lava_counter++;
+    } 
+    if (board[up][j].has_lava) {
+        adjacent_lava_counter++;
+    } 
+    if (board[up][right].has_lava) {
+        adjacent_lava_counter++;
+    } 
+    if (board[i][left].has_lava) {
+        adjacent_lava_counter++;
+    } 
+    if (board[i][right].has_lava) {
+        adjacent_lava_counter++;
+    } 
+    if (board[down][left].has_lava) {
+        adjacent_lava_counter++;
+    } 
+    if (board[down][j].has_lava) {
+        adjacent_lava_counter++;
+    } 
+    if (board[down][right].has_lava) {
+        adjacent_lava_counter++;
+    } 
+    return adjacent_lava_counter;
+}
+
+//helper for corner check to see whether corner collides with opaque object
+int type_check(struct tile board[ROWS][COLS], int base_row, int base_col) {
+    
+    char type = board[base_row][base_col].entity;
+    if (type == WALL || type == BOULDER || type == GEM) {
+        return TRUE; 
+    } else {
+        return FALSE;
+    }
+}
+
+//shadows the entire board when player is hit by boulder on respawn point
+void shadow_entire_board(struct tile game_board[ROWS][COLS], 
+    struct tile true_board[ROWS][COLS], struct game_status status) {
+    
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            game_board[i][j].has_lava = true_board[i][j].has_lava;
+            if (i != status.player_row || j != status.player_col) {
+                game_board[i][j].entity = HIDDEN;
+            }
+        }
+    }
+}
+
+//fills the game board with what the player can currently see, returns FALSE
+//if nothing is hidden and the true board should be shown as it is
+int compute_visible_board(struct tile game_board[ROWS][COLS], 
+    struct game_state *state) {
+
+    struct game_status status = state->status;
+    int visible = TRUE;
+
+    PROFILE_START(visibility_timer);
+    if (status.shadow_entire_board && status.shadowed) {
+        shadow_entire_board(game_board, state->board, status);
+    } else if (status.shadowed && state->constants.shadowcast) {
+        shadowcast(game_board, state->board, status);
+    } else if (status.shadowed && state->constants.reference) {
+        shadow_rows(game_board, state->board, status, 0, ROWS);
+    } else if (status.shadowed) {
+        shadow(game_board, state->board, status);
+    } else if (status.illumination && state->constants.reference) {
+        illuminate_scalar(game_board, state->board, status);
+    } else if (status.illumination) {
+        illuminate(game_board, state->board, status);
+    } else {
+        visible = FALSE;
+    }
+    PROFILE_STOP(visibility_timer, TIMER_VISIBILITY);
+    return visible;
+}
+
+//current time from a clock that never jumps backwards
+long long monotonic_ns(void) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * NS_PER_SEC + now.tv_nsec;
+}
+
+/*
+==============================================================================
+============================= END HELPER SECTION =============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+========================= START STATE HASHING SECTION ========================
+==============================================================================
+*/
+
+/*
+The state hash is a 64-bit zobrist hash: every (tile, entity) pair, every lava
+tile and every status flag has a random key, and the hash of a state is the
+XOR of the keys of everything present. Board keys are folded into the status
+incrementally as tiles are written, so reading the hash never rescans the
+board. The keys come from a fixed seed so hashes are comparable across runs.
+*/
+
+//fills the key tables from the fixed seed
+void initialise_zobrist_keys(void) {
+
+    uint64_t seed = ZOBRIST_SEED;
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            for (int k = 0; k < ENTITY_TYPES; k++) {
+                zobrist.entity[i][j][k] = splitmix64(&seed);
+            }
+            zobrist.lava[i][j] = splitmix64(&seed);
+            zobrist.player[i][j] = splitmix64(&seed);
+        }
+    }
+    for (int i = 0; i < ASCII_LIMIT; i++) {
+        zobrist.gravity[i] = splitmix64(&seed);
+    }
+    for (int i = 0; i < LAVA_MODES; i++) {
+        zobrist.lava_mode[i] = splitmix64(&seed);
+    }
+    for (int i = 0; i <= INITIAL_LIVES; i++) {
+        zobrist.lives[i] = splitmix64(&seed);
+    }
+    zobrist.can_dash = splitmix64(&seed);
+}
+
+//advances the seed and returns the next well-mixed 64-bit random number
+uint64_t splitmix64(uint64_t *seed) {
+
+    uint64_t z = (*seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+//hashes the whole board from scratch, only needed once gameplay starts
+void compute_board_hash(struct tile board[ROWS][COLS], 
+    struct game_status *status) {
+
+    status->entity_hash = 0;
+    status->lava_hash = 0;
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            status->entity_hash ^= zobrist.entity[i][j][board[i][j].entity];
+            if (board[i][j].has_lava) {
+                status->lava_hash ^= zobrist.lava[i][j];
+            }
+        }
+    }
+}
+
+//writes an entity to a tile, keeping the entity hash up to date
+//status is NULL during setup since the hash doesn't exist yet
+void set_entity(struct tile board[ROWS][COLS], struct game_status *status,
+    int row, int col, enum entity entity) {
+
+    if (status != NULL) {
+        status->entity_hash ^= zobrist.entity[row][col][board[row][col].entity] 
+            ^ zobrist.entity[row][col][entity];
+    }
+    board[row][col].entity = entity;
+}
+
+//writes the lava flag of a tile, keeping the lava hash up to date
+void set_lava(struct tile board[ROWS][COLS], struct game_status *status,
+    int row, int col, int has_lava) {
+
+    if (!board[row][col].has_lava != !has_lava) {
+        status->lava_hash ^= zobrist.lava[row][col];
+    }
+    board[row][col].has_lava = has_lava;
+}
+
+//combines the board hashes with the status flags in constant time
+uint64_t game_state_hash(struct game_status *status) {
+
+    uint64_t hash = status->entity_hash ^ status->lava_hash;
+
+    hash ^= zobrist.player[status->player_row][status->player_col];
+    hash ^= zobrist.gravity[status->gravity & (ASCII_LIMIT - 1)];
+    hash ^= zobrist.lava_mode[status->lava_mode];
+    if (status->lives >= 0 && status->lives <= INITIAL_LIVES) {
+        hash ^= zobrist.lives[status->lives];
+    }
+    if (status->can_dash) {
+        hash ^= zobrist.can_dash;
+    }
+    return hash;
+}
+
+/*
+==============================================================================
+========================== END STATE HASHING SECTION =========================
+==============================================================================
+*/
+
+// ===========================================================================
+// Definitions of Provided Functions
+// ===========================================================================
+
+//given a 2D board array, initialise all tile entities to DIRT.
+void initialise_board(struct tile board[ROWS][COLS]) {
+
+    for (int row = 0; row < ROWS; row++) {
+        for (int col = 0; col < COLS; col++) {
+            board[row][col].entity = DIRT;
+            board[row][col].has_lava = FALSE;
+            board[row][col].next_turn_lava = FALSE;
+        }
+    }
+}
@@ -0,0 +1,242 @@
+// caverun_frames.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Publishes boards to a shared memory ring for viewers>
+
+/*
+Overview: Frames are written like a seqlock. The game marks a frame's
+sequence odd, fills it in, then stores its even sequence and finally moves
+the header's latest frame on, all with release stores. A viewer reads a
+frame's sequence, copies the frame and reads the sequence again, keeping
+the copy only if both reads match the frame it asked for. The game never
+waits for anyone, so a viewer that falls more than a ring behind just
+skips ahead to the newest frame. frame_ring_watch is such a viewer,
+printing each frame as a board.
+*/
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "caverun.h"
+#include "caverun_frames.h"
+#include "caverun_session.h"
+
+#define FRAME_WATCH_POLL_NS   (10 * NS_PER_MS)
+
+size_t frame_ring_size(void);
+int frame_ring_read(struct frame_ring *ring, uint64_t number,
+    struct shared_frame *copy);
+void frame_unpack(struct shared_frame *frame, struct tile board[ROWS][COLS]);
+
+/*
+==============================================================================
+=========================== START PUBLISHING SECTION =========================
+==============================================================================
+*/
+
+//creates the ring file and maps it, FALSE if it can't
+int frame_ring_open(struct frame_ring *ring, const char *path) {
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(path);
+        return FALSE;
+    }
+    size_t size = frame_ring_size();
+    void *map = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror(path);
+        return FALSE;
+    }
+
+    ring->header = map;
+    ring->frames = (struct shared_frame *) (ring->header + 1);
+    ring->published = 0;
+    memcpy(ring->header->magic, FRAME_RING_MAGIC, sizeof(ring->header->magic));
+    ring->header->rows = ROWS;
+    ring->header->cols = COLS;
+    ring->header->slots = FRAME_RING_SLOTS;
+    ring->header->frame_size = sizeof(struct shared_frame);
+    atomic_store_explicit(&ring->header->latest, 0, memory_order_release);
+    atomic_store_explicit(&ring->header->closed, FALSE, memory_order_release);
+    return TRUE;
+}
+
+//packs a board into the next frame and makes it the latest
+void frame_ring_publish(struct frame_ring *ring, struct tile board[ROWS][COLS],
+    struct game_status *status, int turn) {
+
+    uint64_t number = ring->published + 1;
+    struct shared_frame *frame = &ring->frames[number % FRAME_RING_SLOTS];
+
+    atomic_store_explicit(&frame->sequence, 2 * number - 1, 
+        memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    frame->turn = turn;
+    frame->player_row = status->player_row;
+    frame->player_col = status->player_col;
+    frame->lives = status->lives;
+    frame->score = status->score;
+    frame->flags = (status->game_won ? FRAME_GAME_WON : 0) |
+        (status->game_over ? FRAME_GAME_OVER : 0);
+    memset(frame->entities, 0, sizeof(frame->entities));
+    memset(frame->lava, 0, sizeof(frame->lava));
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            int cell = i * COLS + j;
+            frame->entities[cell / 2] |= board[i][j].entity << (cell % 2 * 4);
+            if (board[i][j].has_lava) {
+                frame->lava[cell / 8] |= 1 << (cell % 8);
+            }
+        }
+    }
+
+    atomic_store_explicit(&frame->sequence, 2 * number, memory_order_release);
+    atomic_store_explicit(&ring->header->latest, number, memory_order_release);
+    ring->published = number;
+}
+
+//tells viewers no more frames are coming and unmaps the ring, the file is
+//left behind for viewers that are still reading it
+void frame_ring_close(struct frame_ring *ring) {
+
+    atomic_store_explicit(&ring->header->closed, TRUE, memory_order_release);
+    munmap(ring->header, frame_ring_size());
+}
+
+size_t frame_ring_size(void) {
+
+    return sizeof(struct frame_ring_header) + 
+        FRAME_RING_SLOTS * sizeof(struct shared_frame);
+}
+
+/*
+==============================================================================
+============================ END PUBLISHING SECTION ==========================
+==============================================================================
+*/
+
+/*
+==============================================================================
+============================ START VIEWING SECTION ===========================
+==============================================================================
+*/
+
+//follows a ring, printing every frame it manages to read, returns the exit
+//status once the game has closed the ring
+int frame_ring_watch(const char *path) {
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+    void *map = mmap(NULL, frame_ring_size(), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror(path);
+        return 1;
+    }
+    struct frame_ring ring = {map, (struct shared_frame *) 
+        ((struct frame_ring_header *) map + 1), 0};
+    if (memcmp(ring.header->magic, FRAME_RING_MAGIC, 
+        sizeof(ring.header->magic)) != 0 || ring.header->rows != ROWS || 
+        ring.header->cols != COLS || 
+        ring.header->frame_size != (int) sizeof(struct shared_frame)) {
+        fprintf(stderr, "%s: not a frame ring for a %dx%d board\n", 
+            path, ROWS, COLS);
+        munmap(map, frame_ring_size());
+        return 1;
+    }
+
+    static struct tile board[ROWS][COLS];
+    struct shared_frame frame;
+    uint64_t seen = 0;
+    int skipped = 0;
+    struct timespec poll = {0, FRAME_WATCH_POLL_NS};
+    while (TRUE) {
+        //closed is read first so no frame published before it is missed
+        int closed = atomic_load_explicit(&ring.header->closed, 
+            memory_order_acquire);
+        uint64_t latest = atomic_load_explicit(&ring.header->latest,
+            memory_order_acquire);
+        if (latest == seen && closed) {
+            break;
+        } else if (latest == seen) {
+            nanosleep(&poll, NULL);
+            continue;
+        }
+
+        uint64_t next = seen + 1;
+        if (latest - seen >= FRAME_RING_SLOTS / 2) {
+            next = latest;
+        }
+        if (!frame_ring_read(&ring, next, &frame)) {
+            next = latest;
+            if (!frame_ring_read(&ring, next, &frame)) {
+                continue;
+            }
+        }
+        skipped += next - seen - 1;
+        seen = next;
+
+        frame_unpack(&frame, board);
+        printf("Frame %llu: turn %d, score %d\n", (unsigned long long) seen,
+            frame.turn, frame.score);
+        print_board(stdout, board, frame.lives);
+        fflush(stdout);
+    }
+    if (skipped > 0) {
+        printf("Skipped %d frame(s) that were overwritten before they could "
+            "be read\n", skipped);
+    }
+    munmap(map, frame_ring_size());
+    return 0;
+}
+
+//copies out a frame, FALSE if it isn't that frame or changed while copying
+int frame_ring_read(struct frame_ring *ring, uint64_t number,
+    struct shared_frame *copy) {
+
+    struct shared_frame *frame = &ring->frames[number % FRAME_RING_SLOTS];
+    uint64_t before = atomic_load_explicit(&frame->sequence, 
+        memory_order_acquire);
+    if (before != 2 * number) {
+        return FALSE;
+    }
+    memcpy(copy, frame, sizeof(*copy));
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&frame->sequence, 
+        memory_order_relaxed) == before;
+}
+
+//turns a frame's packed planes back into a board
+void frame_unpack(struct shared_frame *frame, struct tile board[ROWS][COLS]) {
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            int cell = i * COLS + j;
+            board[i][j].entity = (frame->entities[cell / 2] >> 
+                (cell % 2 * 4)) & 0x0F;
+            board[i][j].has_lava = (frame->lava[cell / 8] >> (cell % 8)) & 1;
+            board[i][j].next_turn_lava = FALSE;
+        }
+    }
+}
+
+/*
+==============================================================================
+============================= END VIEWING SECTION ============================
+==============================================================================
+*/
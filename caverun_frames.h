@@ -0,0 +1,69 @@
+// caverun_frames.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Publishes boards to a shared memory ring for viewers>
+
+/*
+Overview: A frame ring is a file mapped into memory, e.g. under /dev/shm,
+holding a header and a ring of fixed-size frames. Every board the game
+prints is also packed into the next frame: entities at four bits a tile,
+lava at one bit a tile, plus the player, lives, score and a sequence
+number. Viewers map the same file read-only and copy frames out without
+ever making the game wait, using each frame's sequence number to notice a
+frame that was rewritten while they were reading it.
+*/
+
+#ifndef CAVERUN_FRAMES_H
+#define CAVERUN_FRAMES_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "caverun.h"
+
+#define FRAME_RING_MAGIC      "CVFRAME1"
+#define FRAME_RING_SLOTS      64
+#define FRAME_ENTITY_BYTES    ((ROWS * COLS + 1) / 2)
+#define FRAME_LAVA_BYTES      ((ROWS * COLS + 7) / 8)
+
+#define FRAME_GAME_WON        (1 << 0)
+#define FRAME_GAME_OVER       (1 << 1)
+
+//one published board, sequence is odd while the game is writing it and
+//otherwise twice the frame's number
+struct shared_frame {
+    _Atomic uint64_t sequence;
+    int32_t turn;
+    int32_t player_row;
+    int32_t player_col;
+    int32_t lives;
+    int32_t score;
+    int32_t flags;
+    uint8_t entities[FRAME_ENTITY_BYTES];
+    uint8_t lava[FRAME_LAVA_BYTES];
+};
+
+//start of the mapped file, latest is the number of the newest whole frame
+struct frame_ring_header {
+    char magic[8];
+    int32_t rows;
+    int32_t cols;
+    int32_t slots;
+    int32_t frame_size;
+    _Atomic uint64_t latest;
+    _Atomic int32_t closed;
+};
+
+struct frame_ring {
+    struct frame_ring_header *header;
+    struct shared_frame *frames;
+    uint64_t published;
+};
+
+int frame_ring_open(struct frame_ring *ring, const char *path);
+void frame_ring_publish(struct frame_ring *ring, struct tile board[ROWS][COLS],
+    struct game_status *status, int turn);
+void frame_ring_close(struct frame_ring *ring);
+int frame_ring_watch(const char *path);
+
+#endif
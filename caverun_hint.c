@@ -0,0 +1,359 @@
+// caverun_hint.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Lookahead search suggesting the best next moves>
+
+/*
+Overview: The hint searches every sequence of moves, dashes and gravity
+changes from the current state with iterative deepening. Each node is a copy
+of the game stepped with engine_step, so boulders, lava, dash cooldowns and
+respawns all behave exactly as they would in play. Each depth is split into
+(first, second) action pairs which worker threads pull from a shared counter,
+so a thread that finishes a cheap subtree immediately takes more work. Nodes
+are copied into preallocated per-thread stacks and each thread keeps a
+transposition table keyed by the zobrist hash, so nothing is allocated while
+searching. The table key also covers the last few commands (a lava code
+could still be finished from them) and whether the game is won or over. Win
+and loss values count the plies from the root, so they are stored as the
+distance from the node and moved back to the right ply when looked up. Commands
+that only matter for lava codes are never tried.
+*/
+
+#include <ctype.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "caverun.h"
+#include "caverun_profile.h"
+
+#define HINT_MAX_THREADS      8
+#define HINT_TIME_BUDGET_MS   250
+#define HINT_ACTIONS          24
+#define HINT_TT_SIZE          (1 << 15)
+#define HINT_DEADLINE_CHECK   1024
+#define HINT_WIN_VALUE        1000000
+#define HINT_LOSS_VALUE       (-1000000)
+#define HINT_LIFE_VALUE       1000
+#define HINT_KEY_PRIME        0x100000001b3ULL
+
+//transposition table entry, value is relative to the score at that node, or
+//to the node's ply for a win or loss
+struct hint_tt_entry {
+    uint64_t hash;
+    int depth;
+    int value;
+};
+
+struct hint_search;
+
+//per-thread search state, preallocated so the search itself never allocates
+struct hint_worker {
+    pthread_t thread;
+    struct hint_search *search;
+    struct game_state stack[HINT_MAX_DEPTH + 1];
+    struct command pv[HINT_MAX_DEPTH + 1][HINT_MAX_DEPTH];
+    int pv_length[HINT_MAX_DEPTH + 1];
+    struct hint_tt_entry tt[HINT_TT_SIZE];
+    long long nodes;
+};
+
+//shared state of one hint request, work items are (first, second) action
+//pairs handed out through an atomic counter so idle threads keep pulling work
+struct hint_search {
+    struct game_state root;
+    int depth;
+    int item_count;
+    atomic_int next_item;
+    atomic_int aborted;
+    long long deadline_ns;
+    int item_value[HINT_ACTIONS * HINT_ACTIONS];
+    struct command item_pv[HINT_ACTIONS * HINT_ACTIONS][HINT_MAX_DEPTH];
+    int item_pv_length[HINT_ACTIONS * HINT_ACTIONS];
+};
+
+const struct command HINT_ACTION_LIST[HINT_ACTIONS] = {
+    {UP_SINGLE, 0, 0}, {DOWN_SINGLE, 0, 0},
+    {LEFT_SINGLE, 0, 0}, {RIGHT_SINGLE, 0, 0},
+    {UP_DASH, UP_SINGLE, 0}, {UP_DASH, DOWN_SINGLE, 0},
+    {UP_DASH, LEFT_SINGLE, 0}, {UP_DASH, RIGHT_SINGLE, 0},
+    {DOWN_DASH, UP_SINGLE, 0}, {DOWN_DASH, DOWN_SINGLE, 0},
+    {DOWN_DASH, LEFT_SINGLE, 0}, {DOWN_DASH, RIGHT_SINGLE, 0},
+    {LEFT_DASH, UP_SINGLE, 0}, {LEFT_DASH, DOWN_SINGLE, 0},
+    {LEFT_DASH, LEFT_SINGLE, 0}, {LEFT_DASH, RIGHT_SINGLE, 0},
+    {RIGHT_DASH, UP_SINGLE, 0}, {RIGHT_DASH, DOWN_SINGLE, 0},
+    {RIGHT_DASH, LEFT_SINGLE, 0}, {RIGHT_DASH, RIGHT_SINGLE, 0},
+    {GRAVITY, GRAVITY_UP, 0}, {GRAVITY, GRAVITY_DOWN, 0},
+    {GRAVITY, GRAVITY_LEFT, 0}, {GRAVITY, GRAVITY_RIGHT, 0}
+};
+
+struct hint_worker hint_workers[HINT_MAX_THREADS];
+
+void hint_search_depth(struct hint_search *search, int thread_count);
+void *hint_worker_run(void *arg);
+int hint_search_node(struct hint_worker *worker, int ply, int depth_left);
+int hint_action_allowed(struct game_status *status, int action);
+int hint_evaluate(struct game_state *node, int ply);
+uint64_t hint_key(struct game_state *node);
+int hint_is_terminal(int value);
+int hint_tt_store(struct game_state *node, int ply, int value);
+int hint_tt_load(struct game_state *node, int ply, int stored);
+int hint_thread_count(void);
+
+//searches for the best line of play from the current state
+void engine_hint(struct game_state *state, struct hint_result *result) {
+
+    static struct hint_search search;
+    int thread_count = hint_thread_count();
+    long long start_ns = monotonic_ns();
+    //the search's steps aren't the player's turns, so they aren't profiled
+    //and don't use up the lava the caller has worked out ahead
+    int was_profiling = profile_active;
+    int was_tracing = trace_active;
+    struct lava_ahead *was_ahead = lava_ahead_active;
+    profile_active = FALSE;
+    trace_active = FALSE;
+    lava_ahead_active = NULL;
+
+    search.root = *state;
+    search.deadline_ns = start_ns + HINT_TIME_BUDGET_MS * NS_PER_MS;
+    for (int i = 0; i < thread_count; i++) {
+        memset(hint_workers[i].tt, 0, sizeof(hint_workers[i].tt));
+        hint_workers[i].nodes = 0;
+    }
+
+    result->length = 0;
+    result->depth = 0;
+    for (int depth = 1; depth <= HINT_MAX_DEPTH; depth++) {
+        search.depth = depth;
+        hint_search_depth(&search, thread_count);
+        if (atomic_load(&search.aborted)) {
+            break;
+        }
+        //only a fully searched depth is trusted
+        int best_value = HINT_LOSS_VALUE - 1;
+        for (int i = 0; i < search.item_count; i++) {
+            if (search.item_value[i] > best_value) {
+                best_value = search.item_value[i];
+                result->length = search.item_pv_length[i];
+                memcpy(result->line, search.item_pv[i], sizeof(result->line));
+            }
+        }
+        result->depth = depth;
+        if (best_value >= HINT_WIN_VALUE - HINT_MAX_DEPTH) {
+            break;
+        }
+    }
+
+    //replays the line to report where it actually ends up
+    struct game_state *line_end = &hint_workers[0].stack[0];
+    *line_end = *state;
+    for (int i = 0; i < result->length; i++) {
+        engine_step(line_end, result->line[i]);
+    }
+    result->line_end = line_end->status;
+
+    result->nodes = 0;
+    for (int i = 0; i < thread_count; i++) {
+        result->nodes += hint_workers[i].nodes;
+    }
+    result->seconds = (double)(monotonic_ns() - start_ns) / NS_PER_SEC;
+    result->thread_count = thread_count;
+    profile_active = was_profiling;
+    trace_active = was_tracing;
+    lava_ahead_active = was_ahead;
+}
+
+//searches every work item to the given depth across all threads
+void hint_search_depth(struct hint_search *search, int thread_count) {
+
+    search->item_count = search->depth > 1 ?
+        HINT_ACTIONS * HINT_ACTIONS : HINT_ACTIONS;
+    atomic_store(&search->next_item, 0);
+    atomic_store(&search->aborted, FALSE);
+
+    for (int i = 0; i < thread_count; i++) {
+        hint_workers[i].search = search;
+    }
+    //the calling thread works as well instead of waiting idle
+    for (int i = 1; i < thread_count; i++) {
+        if (pthread_create(&hint_workers[i].thread, NULL,
+            hint_worker_run, &hint_workers[i]) != 0) {
+            thread_count = i;
+            break;
+        }
+    }
+    hint_worker_run(&hint_workers[0]);
+    for (int i = 1; i < thread_count; i++) {
+        pthread_join(hint_workers[i].thread, NULL);
+    }
+}
+
+//pulls work items until none are left or the deadline passes
+void *hint_worker_run(void *arg) {
+
+    struct hint_worker *worker = arg;
+    struct hint_search *search = worker->search;
+    int pair_items = search->item_count > HINT_ACTIONS;
+
+    int item = atomic_fetch_add(&search->next_item, 1);
+    while (item < search->item_count && !atomic_load(&search->aborted)) {
+        int first = pair_items ? item / HINT_ACTIONS : item;
+        int second = pair_items ? item % HINT_ACTIONS : 0;
+        int value = HINT_LOSS_VALUE - 1;
+        int length = 0;
+
+        //an item is only valid if every action in it can be issued
+        if (hint_action_allowed(&search->root.status, first)) {
+            struct game_state *node = &worker->stack[1];
+            *node = search->root;
+            engine_step(node, HINT_ACTION_LIST[first]);
+            worker->nodes++;
+            search->item_pv[item][0] = HINT_ACTION_LIST[first];
+            length = 1;
+
+            if (!pair_items || node->status.game_over) {
+                value = hint_search_node(worker, 1, search->depth - 1);
+                memcpy(&search->item_pv[item][1], worker->pv[1],
+                    worker->pv_length[1] * sizeof(struct command));
+                length += worker->pv_length[1];
+            } else if (hint_action_allowed(&node->status, second)) {
+                worker->stack[2] = *node;
+                engine_step(&worker->stack[2], HINT_ACTION_LIST[second]);
+                worker->nodes++;
+                value = hint_search_node(worker, 2, search->depth - 2);
+                search->item_pv[item][1] = HINT_ACTION_LIST[second];
+                memcpy(&search->item_pv[item][2], worker->pv[2],
+                    worker->pv_length[2] * sizeof(struct command));
+                length = 2 + worker->pv_length[2];
+            }
+        }
+        search->item_value[item] = value;
+        search->item_pv_length[item] = length;
+        item = atomic_fetch_add(&search->next_item, 1);
+    }
+    return NULL;
+}
+
+//depth-limited search below a node, returns the best reachable value
+int hint_search_node(struct hint_worker *worker, int ply, int depth_left) {
+
+    struct game_state *node = &worker->stack[ply];
+    worker->pv_length[ply] = 0;
+
+    if (worker->nodes % HINT_DEADLINE_CHECK == 0 &&
+        monotonic_ns() > worker->search->deadline_ns) {
+        atomic_store(&worker->search->aborted, TRUE);
+    }
+    if (node->status.game_over || depth_left == 0) {
+        return hint_evaluate(node, ply);
+    }
+    if (atomic_load_explicit(&worker->search->aborted,
+        memory_order_relaxed)) {
+        return HINT_LOSS_VALUE;
+    }
+
+    uint64_t hash = hint_key(node);
+    struct hint_tt_entry *entry = &worker->tt[hash % HINT_TT_SIZE];
+    if (entry->hash == hash && entry->depth >= depth_left) {
+        return hint_tt_load(node, ply, entry->value);
+    }
+
+    int best_value = HINT_LOSS_VALUE - 1;
+    for (int i = 0; i < HINT_ACTIONS; i++) {
+        if (!hint_action_allowed(&node->status, i)) {
+            continue;
+        }
+        struct game_state *child = &worker->stack[ply + 1];
+        *child = *node;
+        engine_step(child, HINT_ACTION_LIST[i]);
+        worker->nodes++;
+
+        int value = hint_search_node(worker, ply + 1, depth_left - 1);
+        if (value > best_value) {
+            best_value = value;
+            worker->pv[ply][0] = HINT_ACTION_LIST[i];
+            memcpy(&worker->pv[ply][1], worker->pv[ply + 1],
+                worker->pv_length[ply + 1] * sizeof(struct command));
+            worker->pv_length[ply] = worker->pv_length[ply + 1] + 1;
+        }
+    }
+
+    if (!atomic_load_explicit(&worker->search->aborted,
+        memory_order_relaxed)) {
+        entry->hash = hash;
+        entry->depth = depth_left;
+        entry->value = hint_tt_store(node, ply, best_value);
+    }
+    return best_value;
+}
+
+//dashes can't be tried while out of breath, everything else always can
+int hint_action_allowed(struct game_status *status, int action) {
+
+    return status->can_dash || !isupper(HINT_ACTION_LIST[action].instruction);
+}
+
+//scores a node, winning sooner beats winning later and losing is worst
+int hint_evaluate(struct game_state *node, int ply) {
+
+    if (node->status.game_won) {
+        return HINT_WIN_VALUE - ply;
+    } else if (node->status.game_over) {
+        return HINT_LOSS_VALUE + ply;
+    }
+    return node->status.score + node->status.lives * HINT_LIFE_VALUE;
+}
+
+//the zobrist hash with the command history and end of game flags mixed in,
+//as two nodes with the same board can still play out differently
+uint64_t hint_key(struct game_state *node) {
+
+    uint64_t key = engine_hash(node);
+    for (int i = 0; i < CMD_HISTORY_LENGTH; i++) {
+        key = (key ^ (unsigned char) node->status.cmd_history[i]) *
+            HINT_KEY_PRIME;
+    }
+    key = (key ^ (uint64_t) node->status.game_won) * HINT_KEY_PRIME;
+    key = (key ^ (uint64_t) node->status.game_over) * HINT_KEY_PRIME;
+    return key;
+}
+
+//checks if a value came from a win or a loss rather than a score
+int hint_is_terminal(int value) {
+
+    return value >= HINT_WIN_VALUE - HINT_MAX_DEPTH - 1 ||
+        value <= HINT_LOSS_VALUE + HINT_MAX_DEPTH + 1;
+}
+
+//turns a value into its table form, wins and losses become relative to ply
+//and anything else relative to the score, so equal boards share entries
+int hint_tt_store(struct game_state *node, int ply, int value) {
+
+    if (hint_is_terminal(value)) {
+        return value > 0 ? value + ply : value - ply;
+    }
+    return value - node->status.score;
+}
+
+//turns a table value back into a value at this node's ply and score
+int hint_tt_load(struct game_state *node, int ply, int stored) {
+
+    if (hint_is_terminal(stored)) {
+        return stored > 0 ? stored - ply : stored + ply;
+    }
+    return stored + node->status.score;
+}
+
+//uses one thread per online core, up to the size of the worker pool
+int hint_thread_count(void) {
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) {
+        return 1;
+    } else if (cores > HINT_MAX_THREADS) {
+        return HINT_MAX_THREADS;
+    }
+    return (int) cores;
+}
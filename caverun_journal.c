@@ -0,0 +1,622 @@
+// caverun_journal.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Compact binary record of a played game, with seeking>
+
+/*
+Overview: A journal starts with a header (magic, board size, keyframe
+interval and rules) followed by a stream of entries. Every entry begins with
+one byte holding a code in its high nibble and an argument in its low
+nibble, so moves, dashes, gravity changes and the single letter commands all
+take exactly one byte. Illumination is followed by its radius and anything
+unusual is stored raw. A real-time tick with no command is a JOURNAL_TICK
+entry on its own. Code JOURNAL_RECORD marks the setup statements and
+keyframes, whose numbers are written as zigzag varints (small numbers of
+either sign take one byte). A keyframe holds one byte per tile plus the game
+status, enough to rebuild the game without anything before it.
+
+Entries are appended to a memory buffer and written out with one write()
+every keyframe, or sooner if the buffer fills. The file is opened append
+only, so a crash can only ever lose the unwritten end of the buffer, and the
+reader simply stops at the first incomplete entry.
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "caverun.h"
+#include "caverun_journal.h"
+#include "caverun_session.h"
+
+#define JOURNAL_MAGIC         "CVJ1"
+#define JOURNAL_MAGIC_LENGTH  4
+
+//entry codes, the high nibble of an entry's first byte
+#define JOURNAL_MOVE          0x0
+#define JOURNAL_DASH          0x1
+#define JOURNAL_GRAVITY       0x2
+#define JOURNAL_ILLUMINATE    0x3
+#define JOURNAL_LETTER        0x4
+#define JOURNAL_RAW           0x5
+#define JOURNAL_TICK          0x6
+#define JOURNAL_RECORD        0xF
+
+//record types, the low nibble of a JOURNAL_RECORD entry
+#define RECORD_PLAYER         0x0
+#define RECORD_FEATURE        0x1
+#define RECORD_GROUPED_WALLS  0x2
+#define RECORD_START          0x3
+#define RECORD_KEYFRAME       0x4
+
+#define TILE_LAVA             (1 << 4)
+#define TILE_NEXT_TURN_LAVA   (1 << 5)
+#define TILE_ENTITY_MASK      0x0F
+
+//wasd in nibble order, and the letter commands that take no argument
+const char JOURNAL_DIRECTIONS[] = "wsad";
+const char JOURNAL_LETTERS[] = "upmhtLq";
+
+//reads entries back out of a journal held in memory
+struct journal_reader {
+    const unsigned char *data;
+    long length;
+    long position;
+    int failed;
+};
+
+void journal_flush(struct journal *journal);
+void journal_put_byte(struct journal *journal, int byte);
+void journal_put_int(struct journal *journal, int value);
+void journal_record(struct journal *journal, int type);
+void journal_keyframe(struct journal *journal, struct game_state *state);
+void journal_count_turn(struct journal *journal, struct game_state *state);
+int journal_nibble(const char *table, char c);
+
+int journal_get_byte(struct journal_reader *reader);
+int journal_get_int(struct journal_reader *reader);
+int journal_read_header(struct journal_reader *reader, int *settle);
+int journal_read_entry(struct journal_reader *reader,
+    struct game_state *state, int *turn, int apply);
+void journal_read_command(struct journal_reader *reader, int entry,
+    struct command *command);
+void journal_read_keyframe(struct journal_reader *reader,
+    struct game_state *state, int apply);
+unsigned char *journal_read_file(const char *path, long *length);
+
+/*
+==============================================================================
+============================ START WRITING SECTION ===========================
+==============================================================================
+*/
+
+//creates the journal file and writes its header, FALSE if it can't
+int journal_open(struct journal *journal, const char *path,
+    int keyframe_interval, int settle) {
+
+    journal->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (journal->fd < 0) {
+        perror(path);
+        return FALSE;
+    }
+    journal->length = 0;
+    journal->turns = 0;
+    journal->keyframe_interval = keyframe_interval;
+    journal->failed = FALSE;
+
+    for (int i = 0; i < JOURNAL_MAGIC_LENGTH; i++) {
+        journal_put_byte(journal, JOURNAL_MAGIC[i]);
+    }
+    journal_put_int(journal, ROWS);
+    journal_put_int(journal, COLS);
+    journal_put_int(journal, keyframe_interval);
+    journal_put_int(journal, settle);
+    return TRUE;
+}
+
+//records the player's accepted starting position
+void journal_player(struct journal *journal, int row, int col) {
+
+    journal_record(journal, RECORD_PLAYER);
+    journal_put_int(journal, row);
+    journal_put_int(journal, col);
+}
+
+//records an accepted single-tile feature
+void journal_feature(struct journal *journal, char instruction,
+    int row, int col) {
+
+    journal_record(journal, RECORD_FEATURE);
+    journal_put_byte(journal, instruction);
+    journal_put_int(journal, row);
+    journal_put_int(journal, col);
+}
+
+//records an accepted block of walls
+void journal_grouped_walls(struct journal *journal, int start_row,
+    int start_col, int end_row, int end_col) {
+
+    journal_record(journal, RECORD_GROUPED_WALLS);
+    journal_put_int(journal, start_row);
+    journal_put_int(journal, start_col);
+    journal_put_int(journal, end_row);
+    journal_put_int(journal, end_col);
+}
+
+//records the end of setup, with a keyframe of the starting game
+void journal_start(struct journal *journal, struct game_state *state) {
+
+    journal_record(journal, RECORD_START);
+    journal_keyframe(journal, state);
+}
+
+//records one turn's command, and a keyframe of the game it left behind
+//every keyframe_interval turns
+void journal_turn(struct journal *journal, struct command command,
+    struct game_state *state) {
+
+    int direction = journal_nibble(JOURNAL_DIRECTIONS, command.instruction);
+    int second = journal_nibble(JOURNAL_DIRECTIONS, command.instruction2);
+    int letter = journal_nibble(JOURNAL_LETTERS, command.instruction);
+    int dash = journal_nibble("WSAD", command.instruction);
+
+    if (direction >= 0) {
+        journal_put_byte(journal, JOURNAL_MOVE << 4 | direction);
+    } else if (dash >= 0 && second >= 0) {
+        journal_put_byte(journal, JOURNAL_DASH << 4 | dash << 2 | second);
+    } else if (command.instruction == GRAVITY && second >= 0) {
+        journal_put_byte(journal, JOURNAL_GRAVITY << 4 | second);
+    } else if (command.instruction == ILLUMINATE) {
+        journal_put_byte(journal, JOURNAL_ILLUMINATE << 4);
+        journal_put_int(journal, command.radius);
+    } else if (letter >= 0) {
+        journal_put_byte(journal, JOURNAL_LETTER << 4 | letter);
+    } else {
+        //anything else, e.g. a dash in an unknown direction, is kept as is
+        journal_put_byte(journal, JOURNAL_RAW << 4);
+        journal_put_byte(journal, command.instruction);
+        journal_put_byte(journal, command.instruction2);
+    }
+    journal_count_turn(journal, state);
+}
+
+//records a real-time tick, a turn the cave moved on with no command
+void journal_tick(struct journal *journal, struct game_state *state) {
+
+    journal_put_byte(journal, JOURNAL_TICK << 4);
+    journal_count_turn(journal, state);
+}
+
+//counts a turn just recorded, adding a keyframe every keyframe_interval
+void journal_count_turn(struct journal *journal, struct game_state *state) {
+
+    journal->turns++;
+    if (journal->turns % journal->keyframe_interval == 0) {
+        journal_keyframe(journal, state);
+    }
+}
+
+//writes out whatever is left and closes the file, FALSE if anything was lost
+int journal_close(struct journal *journal) {
+
+    journal_flush(journal);
+    if (close(journal->fd) != 0) {
+        journal->failed = TRUE;
+    }
+    if (journal->failed) {
+        fprintf(stderr, "journal: could not be written in full\n");
+    }
+    return !journal->failed;
+}
+
+//appends the buffer to the file, giving up on the journal if it can't
+void journal_flush(struct journal *journal) {
+
+    int written = 0;
+    while (!journal->failed && written < journal->length) {
+        ssize_t count = write(journal->fd, journal->buffer + written,
+            journal->length - written);
+        if (count < 0) {
+            perror("journal");
+            journal->failed = TRUE;
+        } else {
+            written += count;
+        }
+    }
+    journal->length = 0;
+}
+
+void journal_put_byte(struct journal *journal, int byte) {
+
+    if (journal->length == JOURNAL_BUFFER_SIZE) {
+        journal_flush(journal);
+    }
+    journal->buffer[journal->length] = (unsigned char) byte;
+    journal->length++;
+}
+
+//writes a zigzag varint, 7 bits per byte with the top bit meaning "more"
+void journal_put_int(struct journal *journal, int value) {
+
+    unsigned int zigzag = ((unsigned int) value << 1) ^ (unsigned int)
+        (value >> 31);
+    while (zigzag >= 0x80) {
+        journal_put_byte(journal, (zigzag & 0x7F) | 0x80);
+        zigzag >>= 7;
+    }
+    journal_put_byte(journal, zigzag);
+}
+
+void journal_record(struct journal *journal, int type) {
+
+    journal_put_byte(journal, JOURNAL_RECORD << 4 | type);
+}
+
+//writes the whole game as of the current turn, then flushes the batch
+void journal_keyframe(struct journal *journal, struct game_state *state) {
+
+    struct game_status *status = &state->status;
+    struct constants *constants = &state->constants;
+
+    journal_record(journal, RECORD_KEYFRAME);
+    journal_put_int(journal, journal->turns);
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            struct tile *tile = &state->board[i][j];
+            journal_put_byte(journal, tile->entity |
+                (tile->has_lava ? TILE_LAVA : 0) |
+                (tile->next_turn_lava ? TILE_NEXT_TURN_LAVA : 0));
+        }
+    }
+
+    int fields[] = {
+        status->player_row, status->player_col, status->score,
+        status->lives, status->can_dash, status->boulder_hit,
+        status->lava_hit, status->game_won, status->game_over,
+        status->illumination, status->illumination_radius, status->shadowed,
+        status->shadow_entire_board, status->gravity, status->lava_mode,
+        constants->start_row, constants->start_col, constants->init_dirt,
+        constants->init_gem, constants->settle
+    };
+    for (int i = 0; i < (int) (sizeof(fields) / sizeof(fields[0])); i++) {
+        journal_put_int(journal, fields[i]);
+    }
+    for (int i = 0; i < CMD_HISTORY_LENGTH; i++) {
+        journal_put_byte(journal, status->cmd_history[i]);
+    }
+    journal_flush(journal);
+}
+
+//position of c in a table of up to 16 characters, or -1
+int journal_nibble(const char *table, char c) {
+
+    for (int i = 0; table[i] != '\0'; i++) {
+        if (table[i] == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+==============================================================================
+============================= END WRITING SECTION ============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+============================ START READING SECTION ===========================
+==============================================================================
+*/
+
+//prints the game as it was after the given turn, or at the end of the
+//journal if turn is negative, returns the exit status
+int journal_replay(const char *path, int turn, FILE *out) {
+
+    long length;
+    unsigned char *data = journal_read_file(path, &length);
+    if (data == NULL) {
+        perror(path);
+        return 1;
+    }
+    struct journal_reader reader = {data, length, 0, FALSE};
+    static struct game_state state;
+    int settle;
+    if (!journal_read_header(&reader, &settle)) {
+        fprintf(stderr, "%s: not a journal for a %dx%d board\n",
+            path, ROWS, COLS);
+        free(data);
+        return 1;
+    }
+    long entries_start = reader.position;
+
+    //finds the last keyframe at or before the turn without playing anything
+    int current = 0;
+    int total_turns = 0;
+    int keyframes = 0;
+    long keyframe_position = entries_start;
+    int keyframe_turn = 0;
+    long entry_position = reader.position;
+    int entry;
+    while ((entry = journal_read_entry(&reader, &state, &current,
+        FALSE)) >= 0) {
+        if (entry == RECORD_KEYFRAME) {
+            keyframes++;
+            if (turn < 0 || current <= turn) {
+                keyframe_position = entry_position;
+                keyframe_turn = current;
+            }
+        }
+        total_turns = current;
+        entry_position = reader.position;
+    }
+    if (turn < 0 || turn > total_turns) {
+        turn = total_turns;
+    }
+
+    //then plays forward from it, or from setup if there was no keyframe
+    engine_initialise(&state);
+    engine_settle_boulders(&state, settle);
+    engine_shadowcast(&state, session_rules.shadowcast);
+    reader.position = keyframe_position;
+    reader.failed = FALSE;
+    current = 0;
+    int started = FALSE;
+    static struct lava_ahead ahead;
+    ahead.generations = 0;
+    lava_ahead_active = &ahead;
+    while (current < turn || !started) {
+        entry = journal_read_entry(&reader, &state, &current, TRUE);
+        if (entry < 0) {
+            break;
+        } else if (entry == RECORD_START || entry == RECORD_KEYFRAME) {
+            started = TRUE;
+        }
+    }
+    lava_ahead_active = NULL;
+    free(data);
+
+    fprintf(out, "Journal %s: %d turns, %d keyframes\n", path,
+        total_turns, keyframes);
+    if (!started) {
+        fprintf(out, "The game never left the setup phase\n");
+        print_board(out, state.board, INITIAL_LIVES);
+        return 0;
+    }
+    fprintf(out, "Turn %d, played %d turns from the keyframe at turn %d\n",
+        turn, turn - keyframe_turn, keyframe_turn);
+    static struct tile visible[ROWS][COLS];
+    if (compute_visible_board(visible, &state)) {
+        print_board(out, visible, state.status.lives);
+    } else {
+        print_board(out, state.board, state.status.lives);
+    }
+    fprintf(out, "Your score is %d\n", engine_score(&state));
+    return 0;
+}
+
+int journal_get_byte(struct journal_reader *reader) {
+
+    if (reader->position >= reader->length) {
+        reader->failed = TRUE;
+        return 0;
+    }
+    return reader->data[reader->position++];
+}
+
+int journal_get_int(struct journal_reader *reader) {
+
+    unsigned int zigzag = 0;
+    int byte;
+    int shift = 0;
+    do {
+        byte = journal_get_byte(reader);
+        if (shift < 32) {
+            zigzag |= (unsigned int) (byte & 0x7F) << shift;
+        }
+        shift += 7;
+    } while ((byte & 0x80) && !reader->failed);
+    return (int) (zigzag >> 1) ^ -(int) (zigzag & 1);
+}
+
+//checks the journal was written for this build's board size
+int journal_read_header(struct journal_reader *reader, int *settle) {
+
+    for (int i = 0; i < JOURNAL_MAGIC_LENGTH; i++) {
+        if (journal_get_byte(reader) != JOURNAL_MAGIC[i]) {
+            return FALSE;
+        }
+    }
+    int rows = journal_get_int(reader);
+    int cols = journal_get_int(reader);
+    int keyframe_interval = journal_get_int(reader);
+    *settle = journal_get_int(reader);
+    return !reader->failed && rows == ROWS && cols == COLS &&
+        keyframe_interval > 0;
+}
+
+//reads one entry, applying it to the game if apply is set, returns the
+//record type for setup records and keyframes, JOURNAL_RECORD for a turn,
+//and -1 at the end of the journal or an incomplete entry
+int journal_read_entry(struct journal_reader *reader,
+    struct game_state *state, int *turn, int apply) {
+
+    int entry = journal_get_byte(reader);
+    if (reader->failed) {
+        return -1;
+    }
+    int code = entry >> 4;
+    int type = entry & 0x0F;
+    int values[4];
+    char instruction = 0;
+
+    if (code == JOURNAL_TICK) {
+        if (apply) {
+            engine_tick(state);
+        }
+        (*turn)++;
+        return JOURNAL_RECORD;
+    } else if (code != JOURNAL_RECORD) {
+        struct command command;
+        journal_read_command(reader, entry, &command);
+        if (reader->failed) {
+            return -1;
+        }
+        if (apply) {
+            engine_step(state, command);
+        }
+        (*turn)++;
+        return JOURNAL_RECORD;
+    } else if (type == RECORD_KEYFRAME) {
+        *turn = journal_get_int(reader);
+        journal_read_keyframe(reader, state, apply);
+        return reader->failed ? -1 : type;
+    } else if (type == RECORD_FEATURE) {
+        instruction = journal_get_byte(reader);
+    }
+
+    int value_count = type == RECORD_GROUPED_WALLS ? 4 :
+        type == RECORD_START ? 0 : 2;
+    for (int i = 0; i < value_count; i++) {
+        values[i] = journal_get_int(reader);
+    }
+    if (reader->failed || type > RECORD_KEYFRAME) {
+        return -1;
+    } else if (!apply) {
+        return type;
+    }
+
+    if (type == RECORD_PLAYER) {
+        engine_place_player(state, values[0], values[1]);
+    } else if (type == RECORD_FEATURE) {
+        engine_place_feature(state, instruction, values[0], values[1]);
+    } else if (type == RECORD_GROUPED_WALLS) {
+        engine_place_grouped_walls(state, values[0], values[1],
+            values[2], values[3]);
+    } else {
+        engine_start(state);
+    }
+    return type;
+}
+
+//decodes a turn's command from its first byte and any that follow it
+void journal_read_command(struct journal_reader *reader, int entry,
+    struct command *command) {
+
+    int code = entry >> 4;
+    int argument = entry & 0x0F;
+
+    command->instruction = 0;
+    command->instruction2 = 0;
+    command->radius = 0;
+    if (code == JOURNAL_MOVE && argument < 4) {
+        command->instruction = JOURNAL_DIRECTIONS[argument];
+    } else if (code == JOURNAL_DASH) {
+        command->instruction = "WSAD"[argument >> 2];
+        command->instruction2 = JOURNAL_DIRECTIONS[argument & 3];
+    } else if (code == JOURNAL_GRAVITY && argument < 4) {
+        command->instruction = GRAVITY;
+        command->instruction2 = JOURNAL_DIRECTIONS[argument];
+    } else if (code == JOURNAL_ILLUMINATE) {
+        command->instruction = ILLUMINATE;
+        command->radius = journal_get_int(reader);
+    } else if (code == JOURNAL_LETTER &&
+        argument < (int) strlen(JOURNAL_LETTERS)) {
+        command->instruction = JOURNAL_LETTERS[argument];
+    } else if (code == JOURNAL_RAW) {
+        command->instruction = journal_get_byte(reader);
+        command->instruction2 = journal_get_byte(reader);
+    } else {
+        reader->failed = TRUE;
+    }
+}
+
+//reads a keyframe, replacing the whole game with it if apply is set
+void journal_read_keyframe(struct journal_reader *reader,
+    struct game_state *state, int apply) {
+
+    struct game_state keyframe;
+    struct game_status *status = &keyframe.status;
+    struct constants *constants = &keyframe.constants;
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            int tile = journal_get_byte(reader);
+            keyframe.board[i][j].entity = tile & TILE_ENTITY_MASK;
+            keyframe.board[i][j].has_lava = (tile & TILE_LAVA) != 0;
+            keyframe.board[i][j].next_turn_lava =
+                (tile & TILE_NEXT_TURN_LAVA) != 0;
+        }
+    }
+
+    //in the order journal_keyframe writes them
+    status->player_row = journal_get_int(reader);
+    status->player_col = journal_get_int(reader);
+    status->score = journal_get_int(reader);
+    status->lives = journal_get_int(reader);
+    status->can_dash = journal_get_int(reader);
+    status->boulder_hit = journal_get_int(reader);
+    status->lava_hit = journal_get_int(reader);
+    status->game_won = journal_get_int(reader);
+    status->game_over = journal_get_int(reader);
+    status->illumination = journal_get_int(reader);
+    status->illumination_radius = journal_get_int(reader);
+    status->shadowed = journal_get_int(reader);
+    status->shadow_entire_board = journal_get_int(reader);
+    status->gravity = (char) journal_get_int(reader);
+    status->lava_mode = journal_get_int(reader);
+    constants->start_row = journal_get_int(reader);
+    constants->start_col = journal_get_int(reader);
+    constants->init_dirt = journal_get_int(reader);
+    constants->init_gem = journal_get_int(reader);
+    constants->settle = journal_get_int(reader);
+    //how shadows and turns are worked out is up to whoever is replaying
+    constants->shadowcast = state->constants.shadowcast;
+    constants->reference = state->constants.reference;
+    for (int i = 0; i < CMD_HISTORY_LENGTH; i++) {
+        status->cmd_history[i] = journal_get_byte(reader);
+    }
+
+    if (apply && !reader->failed) {
+        compute_board_hash(keyframe.board, status);
+        *state = keyframe;
+    }
+}
+
+//reads a whole file into memory, NULL if it can't
+unsigned char *journal_read_file(const char *path, long *length) {
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    unsigned char *data = NULL;
+    long size = 0;
+    long capacity = 0;
+    int c;
+    while ((c = getc(file)) != EOF) {
+        if (size == capacity) {
+            capacity = capacity == 0 ? JOURNAL_BUFFER_SIZE : capacity * 2;
+            unsigned char *grown = realloc(data, capacity);
+            if (grown == NULL) {
+                free(data);
+                fclose(file);
+                return NULL;
+            }
+            data = grown;
+        }
+        data[size++] = (unsigned char) c;
+    }
+    fclose(file);
+    *length = size;
+    return data == NULL ? malloc(1) : data;
+}
+
+/*
+==============================================================================
+============================= END READING SECTION ============================
+==============================================================================
+*/
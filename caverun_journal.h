@@ -0,0 +1,49 @@
+// caverun_journal.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Compact binary record of a played game, with seeking>
+
+/*
+Overview: A journal records a game as it is played: the accepted setup
+statements, then one entry per turn, with a full keyframe of the game every
+so many turns. Most commands fit in a single byte. Entries collect in memory
+and are appended to the file in batches, so recording costs a turn next to
+nothing. journal_replay rebuilds the game at any turn by loading the last
+keyframe before it and playing only the turns after that.
+*/
+
+#ifndef CAVERUN_JOURNAL_H
+#define CAVERUN_JOURNAL_H
+
+#include <stdio.h>
+
+#include "caverun.h"
+
+#define JOURNAL_BUFFER_SIZE         (1 << 16)
+#define JOURNAL_KEYFRAME_INTERVAL   64
+
+struct journal {
+    int fd;
+    unsigned char buffer[JOURNAL_BUFFER_SIZE];
+    int length;
+    int turns;
+    int keyframe_interval;
+    int failed;
+};
+
+int journal_open(struct journal *journal, const char *path, 
+    int keyframe_interval, int settle);
+void journal_player(struct journal *journal, int row, int col);
+void journal_feature(struct journal *journal, char instruction, 
+    int row, int col);
+void journal_grouped_walls(struct journal *journal, int start_row, 
+    int start_col, int end_row, int end_col);
+void journal_start(struct journal *journal, struct game_state *state);
+void journal_turn(struct journal *journal, struct command command,
+    struct game_state *state);
+void journal_tick(struct journal *journal, struct game_state *state);
+int journal_close(struct journal *journal);
+
+int journal_replay(const char *path, int turn, FILE *out);
+
+#endif
@@ -0,0 +1,101 @@
+// caverun_latency.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Fixed-size latency histograms with percentile queries>
+
+/*
+Overview: Values below LATENCY_SUB_BUCKETS get a bucket each. Above that a
+value is placed by the position of its highest set bit and the
+LATENCY_SUB_BITS bits just below it, and a percentile is reported as the top
+of the bucket it lands in so that it never understates the real latency.
+*/
+
+#include <string.h>
+
+#include "caverun.h"
+#include "caverun_latency.h"
+
+int latency_bucket(long long ns);
+long long latency_bucket_top(int bucket);
+
+//empties a histogram
+void latency_reset(struct latency_histogram *histogram) {
+
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+//counts one duration
+void latency_record(struct latency_histogram *histogram, long long ns) {
+
+    if (ns < 0) {
+        ns = 0;
+    }
+    histogram->counts[latency_bucket(ns)]++;
+    histogram->total++;
+    histogram->sum_ns += ns;
+    if (ns > histogram->max_ns) {
+        histogram->max_ns = ns;
+    }
+}
+
+//the smallest bucket top that at least percentile% of values fit under
+long long latency_percentile(struct latency_histogram *histogram,
+    double percentile) {
+
+    if (histogram->total == 0) {
+        return 0;
+    }
+    long long target = (long long)(histogram->total * percentile / 100.0);
+    if (target < 1) {
+        target = 1;
+    }
+
+    long long seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= target) {
+            long long top = latency_bucket_top(i);
+            return top < histogram->max_ns ? top : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+//adds every value of one histogram into another
+void latency_merge(struct latency_histogram *into,
+    struct latency_histogram *from) {
+
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        into->counts[i] += from->counts[i];
+    }
+    into->total += from->total;
+    into->sum_ns += from->sum_ns;
+    if (from->max_ns > into->max_ns) {
+        into->max_ns = from->max_ns;
+    }
+}
+
+//finds which bucket a value belongs in
+int latency_bucket(long long ns) {
+
+    unsigned long long value = (unsigned long long) ns;
+    if (value < LATENCY_SUB_BUCKETS) {
+        return (int) value;
+    }
+    int top_bit = 63 - __builtin_clzll(value);
+    int shift = top_bit - LATENCY_SUB_BITS;
+    int sub = (int)((value >> shift) & (LATENCY_SUB_BUCKETS - 1));
+    return (shift + 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+//the largest value that still falls in a bucket
+long long latency_bucket_top(int bucket) {
+
+    if (bucket < LATENCY_SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = bucket / LATENCY_SUB_BUCKETS - 1;
+    int sub = bucket % LATENCY_SUB_BUCKETS;
+    unsigned long long base = (unsigned long long)(LATENCY_SUB_BUCKETS + sub);
+    return (long long)(((base + 1) << shift) - 1);
+}
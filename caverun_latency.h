@@ -0,0 +1,35 @@
+// caverun_latency.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Fixed-size latency histograms with percentile queries>
+
+/*
+Overview: A histogram counts nanosecond durations in log-linear buckets: each
+power of two is split into LATENCY_SUB_BUCKETS equal parts, so any recorded
+value is known to within about 6% while the whole histogram stays a fixed
+array that never allocates. Recording is a few shifts and an increment, cheap
+enough to do on every turn.
+*/
+
+#ifndef CAVERUN_LATENCY_H
+#define CAVERUN_LATENCY_H
+
+#define LATENCY_SUB_BITS      4
+#define LATENCY_SUB_BUCKETS   (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS       (64 * LATENCY_SUB_BUCKETS)
+
+struct latency_histogram {
+    long long counts[LATENCY_BUCKETS];
+    long long total;
+    long long sum_ns;
+    long long max_ns;
+};
+
+void latency_reset(struct latency_histogram *histogram);
+void latency_record(struct latency_histogram *histogram, long long ns);
+long long latency_percentile(struct latency_histogram *histogram,
+    double percentile);
+void latency_merge(struct latency_histogram *into,
+    struct latency_histogram *from);
+
+#endif
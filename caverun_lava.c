@@ -0,0 +1,265 @@
+// caverun_lava.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Lava worked out several turns ahead, a band of rows at a time>
+
+/*
+Overview: Lava only ever depends on the lava around it, never on boulders,
+the player or anything else on the board, so where the lava will be in the
+next few turns is already decided. When a caller sets lava_ahead_active,
+lava_turn hands over to lava_turn_blocked, which works out the next
+LAVA_BLOCK_DEPTH generations at once and then plays one of them each turn.
+
+The generations are worked out on bit planes, one bit per tile and 64 tiles
+per word, a band of LAVA_BAND_ROWS rows at a time. A band is loaded with
+LAVA_BLOCK_DEPTH extra rows above and below it, and each generation is right
+on one row fewer at each edge than the last, so after LAVA_BLOCK_DEPTH
+generations exactly the band's own rows are still right. The band and its
+halo stay in cache for all of them, instead of the whole board going through
+memory twice a generation. Boards with no more rows than a band are done as
+one band that wraps around, with no halo at all.
+
+Each turn only the tiles whose lava changed are written back to the board,
+through set_lava so the hash stays correct, and the player's tile is checked
+for lava exactly as lava_turn always has. The lava hash of every worked out
+generation is kept, so a board whose lava isn't one of them (a new game, the
+lava code being entered, a journal seek) is simply worked out again from
+the board itself.
+*/
+
+#include <string.h>
+
+#include "caverun.h"
+#include "caverun_profile.h"
+
+#define LAVA_HALO_ROWS        (LAVA_BAND_ROWS + 2 * LAVA_BLOCK_DEPTH)
+
+_Thread_local struct lava_ahead *lava_ahead_active = NULL;
+
+int lava_ahead_find(struct lava_ahead *ahead, struct game_status *status);
+void lava_ahead_fill(struct tile board[ROWS][COLS],
+    struct game_status *status, struct lava_ahead *ahead, int from_board);
+void lava_ahead_periodic(struct lava_ahead *ahead);
+void lava_ahead_band(struct lava_ahead *ahead, int first_row, int rows);
+void lava_ahead_apply(struct tile board[ROWS][COLS],
+    struct game_status *status, struct lava_ahead *ahead, int generation);
+void lava_row_next(const uint64_t *above, const uint64_t *row,
+    const uint64_t *below, uint64_t *next, enum lava_mode mode);
+void lava_row_sides(const uint64_t *row, uint64_t *west, uint64_t *east);
+uint64_t lava_plane_hash(uint64_t plane[ROWS][LAVA_WORDS]);
+
+//one lava turn played from the generations worked out ahead, giving exactly
+//the board lava_turn_scalar would
+void lava_turn_blocked(struct tile board[ROWS][COLS],
+    struct game_status *status, struct lava_ahead *ahead) {
+
+    lava_ahead_step(board, status, ahead);
+
+    int row = status->player_row;
+    int col = status->player_col;
+    if (row >= 0 && row < ROWS && col >= 0 && col < COLS &&
+        board[row][col].entity == PLAYER && board[row][col].has_lava) {
+        set_entity(board, status, row, col, EMPTY);
+        status->lava_hit = TRUE;
+    }
+}
+
+//moves the board's lava on one generation from the ones worked out ahead,
+//without looking at the player
+void lava_ahead_step(struct tile board[ROWS][COLS],
+    struct game_status *status, struct lava_ahead *ahead) {
+
+    if (status->lava_mode == LAVA_NONE) {
+        return;
+    }
+    int generation = lava_ahead_find(ahead, status);
+    if (generation < 0) {
+        lava_ahead_fill(board, status, ahead, TRUE);
+        generation = 0;
+    } else if (generation == LAVA_BLOCK_DEPTH) {
+        lava_ahead_fill(board, status, ahead, FALSE);
+        generation = 0;
+    }
+    lava_ahead_apply(board, status, ahead, generation + 1);
+}
+
+//which worked out generation the board's lava is, or -1 if none of them
+int lava_ahead_find(struct lava_ahead *ahead, struct game_status *status) {
+
+    if (ahead->mode != status->lava_mode) {
+        return -1;
+    }
+    for (int generation = 0; generation < ahead->generations; generation++) {
+        if (ahead->hashes[generation] == status->lava_hash) {
+            return generation;
+        }
+    }
+    return -1;
+}
+
+//works out the next LAVA_BLOCK_DEPTH generations, starting from the board
+//or, when the last batch has been used up, from its final generation
+void lava_ahead_fill(struct tile board[ROWS][COLS],
+    struct game_status *status, struct lava_ahead *ahead, int from_board) {
+
+    if (from_board) {
+        memset(ahead->planes[0], 0, sizeof(ahead->planes[0]));
+        for (int i = 0; i < ROWS; i++) {
+            for (int j = 0; j < COLS; j++) {
+                if (board[i][j].has_lava) {
+                    ahead->planes[0][i][j / 64] |= (uint64_t) 1 << (j % 64);
+                }
+            }
+        }
+        ahead->hashes[0] = status->lava_hash;
+    } else {
+        memcpy(ahead->planes[0], ahead->planes[LAVA_BLOCK_DEPTH],
+            sizeof(ahead->planes[0]));
+        ahead->hashes[0] = ahead->hashes[LAVA_BLOCK_DEPTH];
+    }
+    ahead->mode = status->lava_mode;
+
+    if (ROWS <= LAVA_BAND_ROWS) {
+        lava_ahead_periodic(ahead);
+    } else {
+        for (int first_row = 0; first_row < ROWS;
+            first_row += LAVA_BAND_ROWS) {
+            int rows = ROWS - first_row < LAVA_BAND_ROWS ?
+                ROWS - first_row : LAVA_BAND_ROWS;
+            lava_ahead_band(ahead, first_row, rows);
+        }
+    }
+    for (int generation = 1; generation <= LAVA_BLOCK_DEPTH; generation++) {
+        ahead->hashes[generation] = lava_plane_hash(ahead->planes[generation]);
+    }
+    ahead->generations = LAVA_BLOCK_DEPTH + 1;
+}
+
+//a board that fits in one band, the rows above and below wrapping around
+void lava_ahead_periodic(struct lava_ahead *ahead) {
+
+    for (int generation = 1; generation <= LAVA_BLOCK_DEPTH; generation++) {
+        uint64_t (*from)[LAVA_WORDS] = ahead->planes[generation - 1];
+        for (int i = 0; i < ROWS; i++) {
+            lava_row_next(from[WRAP_BACK(i, ROWS)], from[i],
+                from[WRAP_NEXT(i, ROWS)], ahead->planes[generation][i],
+                ahead->mode);
+        }
+    }
+}
+
+//one band of rows with a halo of LAVA_BLOCK_DEPTH rows on each side, the
+//rows that are still right shrinking by one at each edge every generation
+void lava_ahead_band(struct lava_ahead *ahead, int first_row, int rows) {
+
+    static _Thread_local uint64_t halo[2][LAVA_HALO_ROWS][LAVA_WORDS];
+    int total = rows + 2 * LAVA_BLOCK_DEPTH;
+
+    for (int l = 0; l < total; l++) {
+        int i = ((first_row - LAVA_BLOCK_DEPTH + l) % ROWS + ROWS) % ROWS;
+        memcpy(halo[0][l], ahead->planes[0][i], sizeof(halo[0][l]));
+    }
+    for (int generation = 1; generation <= LAVA_BLOCK_DEPTH; generation++) {
+        uint64_t (*from)[LAVA_WORDS] = halo[(generation - 1) % 2];
+        uint64_t (*to)[LAVA_WORDS] = halo[generation % 2];
+        for (int l = generation; l < total - generation; l++) {
+            lava_row_next(from[l - 1], from[l], from[l + 1], to[l],
+                ahead->mode);
+        }
+        memcpy(ahead->planes[generation][first_row], to[LAVA_BLOCK_DEPTH],
+            rows * sizeof(to[0]));
+    }
+}
+
+//writes the lava of one worked out generation to the board, touching only
+//the tiles that changed since the one before it
+void lava_ahead_apply(struct tile board[ROWS][COLS],
+    struct game_status *status, struct lava_ahead *ahead, int generation) {
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int word = 0; word < LAVA_WORDS; word++) {
+            uint64_t after = ahead->planes[generation][i][word];
+            uint64_t changed = after ^ ahead->planes[generation - 1][i][word];
+            PROFILE_COUNT(COUNT_LAVA_BORN, __builtin_popcountll(changed &
+                after));
+            PROFILE_COUNT(COUNT_LAVA_KILLED, __builtin_popcountll(changed &
+                ~after));
+            while (changed != 0) {
+                int bit = __builtin_ctzll(changed);
+                changed &= changed - 1;
+                set_lava(board, status, i, word * 64 + bit,
+                    after >> bit & 1);
+            }
+        }
+    }
+}
+
+//the next generation of one row, from it and the rows either side of it
+//the eight neighbour counts are added up bitwise, 64 tiles at a time, in
+//three bits which is enough as only counts of 2 and 3 matter
+void lava_row_next(const uint64_t *above, const uint64_t *row,
+    const uint64_t *below, uint64_t *next, enum lava_mode mode) {
+
+    uint64_t sides[3][2][LAVA_WORDS];
+    lava_row_sides(above, sides[0][0], sides[0][1]);
+    lava_row_sides(row, sides[1][0], sides[1][1]);
+    lava_row_sides(below, sides[2][0], sides[2][1]);
+
+    for (int word = 0; word < LAVA_WORDS; word++) {
+        uint64_t neighbours[8] = {
+            sides[0][0][word], above[word], sides[0][1][word],
+            sides[1][0][word], sides[1][1][word],
+            sides[2][0][word], below[word], sides[2][1][word]
+        };
+        uint64_t ones = 0;
+        uint64_t twos = 0;
+        uint64_t fours = 0;
+        for (int k = 0; k < 8; k++) {
+            uint64_t carry = ones & neighbours[k];
+            ones ^= neighbours[k];
+            fours ^= twos & carry;
+            twos ^= carry;
+        }
+        if (mode == GAME_OF_LAVA) {
+            next[word] = ~fours & twos & (ones | row[word]);
+        } else {
+            next[word] = ~fours & twos & ~ones & ~row[word];
+        }
+    }
+    next[LAVA_WORDS - 1] &= ~(uint64_t) 0 >> (63 - (COLS - 1) % 64);
+}
+
+//each tile's west and east neighbour in a row, wrapping around the sides
+void lava_row_sides(const uint64_t *row, uint64_t *west, uint64_t *east) {
+
+    int last = LAVA_WORDS - 1;
+    for (int word = 0; word < LAVA_WORDS; word++) {
+        west[word] = row[word] << 1;
+        if (word > 0) {
+            west[word] |= row[word - 1] >> 63;
+        }
+        east[word] = row[word] >> 1;
+        if (word < last) {
+            east[word] |= row[word + 1] << 63;
+        }
+    }
+    west[0] |= row[last] >> ((COLS - 1) % 64) & 1;
+    east[last] |= (row[0] & 1) << ((COLS - 1) % 64);
+    west[last] &= ~(uint64_t) 0 >> (63 - (COLS - 1) % 64);
+}
+
+//the lava hash a board would have with this plane's lava
+uint64_t lava_plane_hash(uint64_t plane[ROWS][LAVA_WORDS]) {
+
+    uint64_t hash = 0;
+    for (int i = 0; i < ROWS; i++) {
+        for (int word = 0; word < LAVA_WORDS; word++) {
+            uint64_t lava = plane[i][word];
+            while (lava != 0) {
+                hash ^= zobrist.lava[i][word * 64 + __builtin_ctzll(lava)];
+                lava &= lava - 1;
+            }
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,347 @@
+// caverun_level.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <One level shared by every session playing it>
+
+/*
+Overview: A level is loaded by playing a setup file through a quiet session
+up to the start of gameplay, with features placed in bulk against an
+occupancy index, and keeping the game state it ends up with. That state is
+only ever read from then on. The server holds one reference to the level it
+gives new clients and every overlay playing it holds another, so a level
+that has been replaced is freed once the last game on it ends.
+
+An overlay starts as just the level's status and no changed tiles. To play
+a statement it is loaded onto the scratch session: the tiles the last
+overlay had changed go back to the level's, this overlay's changed tiles
+are written over them and its status and counters are copied in, so
+loading only costs as much as the two overlays have changed. Afterwards the
+scratch board is compared with the level's a row at a time, skipping rows
+that are the same, and the tiles that differ become the overlay's changes.
+A game only ever holds the tiles it has actually changed, e.g. the dirt it
+has dug and the gems it has taken, however big the map is. Nothing about a
+game is kept on the scratch session between statements, since its lava
+ahead is keyed by the lava's hash and its game board is worked out again
+for every board printed.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "caverun.h"
+#include "caverun_level.h"
+#include "caverun_session.h"
+
+#define LEVEL_READ_BLOCK       4096
+#define LEVEL_INITIAL_CHANGES  64
+
+char *level_read_file(const char *path, long *length);
+void overlay_revert(struct level_scratch *scratch,
+    struct level_overlay *overlay);
+int overlay_add_change(struct level_overlay *overlay, int index,
+    struct tile *tile);
+
+/*
+==============================================================================
+============================ START LEVEL SECTION =============================
+==============================================================================
+*/
+
+//sets up a level from a setup file, which has to get as far as starting
+//the game, returns NULL if it can't be loaded
+struct level *level_load(const char *path) {
+
+    long length = 0;
+    char *data = level_read_file(path, &length);
+    if (data == NULL) {
+        perror(path);
+        return NULL;
+    }
+    struct level *level = malloc(sizeof(struct level));
+    struct session *session = malloc(sizeof(struct session));
+    struct occupancy_index *occupancy = malloc(sizeof(*occupancy));
+    if (level == NULL || session == NULL || occupancy == NULL) {
+        fprintf(stderr, "Could not allocate level %s\n", path);
+        free(data);
+        free(level);
+        free(session);
+        free(occupancy);
+        return NULL;
+    }
+
+    session_begin(session, NULL);
+    session->occupancy = occupancy;
+    long used = 0;
+    while (session->phase != PHASE_GAMEPLAY) {
+        int step = session_step(session, data + used, length - used, TRUE);
+        if (step == 0) {
+            break;
+        }
+        used += step;
+    }
+
+    int started = session->phase == PHASE_GAMEPLAY;
+    if (started) {
+        level->references = 1;
+        level->start = session->state;
+        level->locked_exits = session->locked_exits;
+        fprintf(stderr, "Loaded level %s, %d of %d feature(s) placed\n",
+            path, session->bulk_summary.results[PLACEMENT_OK],
+            session->bulk_summary.requests);
+    } else {
+        fprintf(stderr, "Level %s never starts the game\n", path);
+        free(level);
+        level = NULL;
+    }
+    free(data);
+    free(session);
+    free(occupancy);
+    return level;
+}
+
+//takes another reference to a level
+void level_retain(struct level *level) {
+
+    level->references++;
+}
+
+//lets go of a reference, freeing the level with the last one, the server
+//is single threaded so the count needs no atomics
+void level_release(struct level *level) {
+
+    if (level != NULL && --level->references == 0) {
+        free(level);
+    }
+}
+
+//reads a whole file into a new buffer
+char *level_read_file(const char *path, long *length) {
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    char *data = NULL;
+    size_t size = 0;
+    FILE *copy = open_memstream(&data, &size);
+    if (copy == NULL) {
+        fclose(file);
+        return NULL;
+    }
+    char block[LEVEL_READ_BLOCK];
+    size_t count;
+    while ((count = fread(block, 1, sizeof(block), file)) > 0) {
+        fwrite(block, 1, count, copy);
+    }
+    int failed = ferror(file);
+    fclose(file);
+    fclose(copy);
+    if (failed) {
+        free(data);
+        return NULL;
+    }
+    *length = size;
+    return data;
+}
+
+/*
+==============================================================================
+============================= END LEVEL SECTION ==============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+=========================== START OVERLAY SECTION ============================
+==============================================================================
+*/
+
+//starts a new game on a level, printing the welcome and the level's board
+//where a game set up by hand would have printed its setup
+void overlay_begin(struct level_overlay *overlay, struct level *level,
+    FILE *out) {
+
+    level_retain(level);
+    overlay->level = level;
+    overlay->status = level->start.status;
+    overlay->phase = PHASE_GAMEPLAY;
+    overlay->statements = 0;
+    overlay->turns = 0;
+    overlay->last_events = EVENT_NONE;
+    overlay->macro_count = 0;
+    overlay->rendered_turn = 0;
+    overlay->rendered_ns = 0;
+    overlay->frame_skipped = FALSE;
+    overlay->locked_exits = level->locked_exits;
+    overlay->render_pending = FALSE;
+    overlay->resume_turn = 0;
+    overlay->changes = NULL;
+    overlay->change_count = 0;
+    overlay->change_capacity = 0;
+
+    if (out != NULL) {
+        fprintf(out, "Welcome to CS Caverun!\n\n");
+        print_board(out, level->start.board, INITIAL_LIVES);
+        fprintf(out, "--- Gameplay Phase ---\n");
+    }
+}
+
+//puts an overlay's game on the scratch session, ready for session_step
+struct session *overlay_load(struct level_scratch *scratch,
+    struct level_overlay *overlay, FILE *out) {
+
+    struct session *session = &scratch->session;
+    struct level *level = overlay->level;
+
+    if (scratch->level != level) {
+        //the scratch board is held to its level, which could otherwise be
+        //freed and another allocated in its place
+        level_retain(level);
+        level_release(scratch->level);
+        scratch->level = level;
+        scratch->loaded = NULL;
+        memcpy(session->state.board, level->start.board,
+            sizeof(session->state.board));
+        session->state.constants = level->start.constants;
+    }
+    if (scratch->loaded != overlay) {
+        if (scratch->loaded != NULL) {
+            overlay_revert(scratch, scratch->loaded);
+        }
+        for (int i = 0; i < overlay->change_count; i++) {
+            int index = overlay->changes[i].index;
+            session->state.board[index / COLS][index % COLS] =
+                overlay->changes[i].tile;
+        }
+        scratch->loaded = overlay;
+    }
+
+    session->state.status = overlay->status;
+    session->out = out;
+    session->journal = NULL;
+    session->pipeline = NULL;
+    session->frames = NULL;
+    session->broadcast = NULL;
+    session->occupancy = NULL;
+    session->bulk_count = 0;
+    session->phase = overlay->phase;
+    session->statements = overlay->statements;
+    session->turns = overlay->turns;
+    session->last_events = overlay->last_events;
+    memcpy(session->macros, overlay->macros,
+        overlay->macro_count * sizeof(struct session_macro));
+    session->macro_count = overlay->macro_count;
+    session->batch_depth = 0;
+    session->render_pending = overlay->render_pending;
+    session->batch_interrupted = FALSE;
+    session->resume_turn = overlay->resume_turn;
+    session->rendered_turn = overlay->rendered_turn;
+    session->rendered_ns = overlay->rendered_ns;
+    session->frame_skipped = overlay->frame_skipped;
+    session->locked_exits = overlay->locked_exits;
+    return session;
+}
+
+//keeps what the statements just played changed, a game whose changes
+//can't be kept any more is over
+void overlay_store(struct level_scratch *scratch,
+    struct level_overlay *overlay) {
+
+    struct session *session = &scratch->session;
+    struct tile (*start)[COLS] = overlay->level->start.board;
+
+    overlay->status = session->state.status;
+    overlay->phase = session->phase;
+    overlay->statements = session->statements;
+    overlay->turns = session->turns;
+    overlay->last_events = session->last_events;
+    memcpy(overlay->macros, session->macros,
+        session->macro_count * sizeof(struct session_macro));
+    overlay->macro_count = session->macro_count;
+    overlay->rendered_turn = session->rendered_turn;
+    overlay->rendered_ns = session->rendered_ns;
+    overlay->frame_skipped = session->frame_skipped;
+    overlay->locked_exits = session->locked_exits;
+    overlay->render_pending = session->render_pending;
+    overlay->resume_turn = session->resume_turn;
+
+    overlay->change_count = 0;
+    for (int i = 0; i < ROWS; i++) {
+        if (memcmp(session->state.board[i], start[i],
+            sizeof(start[i])) == 0) {
+            continue;
+        }
+        for (int j = 0; j < COLS; j++) {
+            struct tile *tile = &session->state.board[i][j];
+            if (memcmp(tile, &start[i][j], sizeof(*tile)) != 0 &&
+                !overlay_add_change(overlay, i * COLS + j, tile)) {
+                //the scratch board is no longer its level plus the
+                //overlay's changes, so it is rebuilt on the next load
+                overlay->phase = PHASE_OVER;
+                level_release(scratch->level);
+                scratch->level = NULL;
+                scratch->loaded = NULL;
+                return;
+            }
+        }
+    }
+}
+
+//lets go of a game's changes and its level
+void overlay_end(struct level_scratch *scratch,
+    struct level_overlay *overlay) {
+
+    if (scratch->loaded == overlay) {
+        overlay_revert(scratch, overlay);
+        scratch->loaded = NULL;
+    }
+    free(overlay->changes);
+    overlay->changes = NULL;
+    overlay->change_count = 0;
+    overlay->change_capacity = 0;
+    level_release(overlay->level);
+    overlay->level = NULL;
+}
+
+//puts the tiles an overlay changed on the scratch board back to its level's
+void overlay_revert(struct level_scratch *scratch,
+    struct level_overlay *overlay) {
+
+    struct tile (*board)[COLS] = scratch->session.state.board;
+    struct tile (*start)[COLS] = scratch->level->start.board;
+    for (int i = 0; i < overlay->change_count; i++) {
+        int row = overlay->changes[i].index / COLS;
+        int col = overlay->changes[i].index % COLS;
+        board[row][col] = start[row][col];
+    }
+}
+
+//adds one changed tile, doubling the room for them when it runs out,
+//returns FALSE if there is no memory for it
+int overlay_add_change(struct level_overlay *overlay, int index,
+    struct tile *tile) {
+
+    if (overlay->change_count == overlay->change_capacity) {
+        int capacity = overlay->change_capacity == 0 ?
+            LEVEL_INITIAL_CHANGES : 2 * overlay->change_capacity;
+        struct level_change *changes = realloc(overlay->changes,
+            capacity * sizeof(struct level_change));
+        if (changes == NULL) {
+            return FALSE;
+        }
+        overlay->changes = changes;
+        overlay->change_capacity = capacity;
+    }
+    overlay->changes[overlay->change_count].index = index;
+    overlay->changes[overlay->change_count].tile = *tile;
+    overlay->change_count++;
+    return TRUE;
+}
+
+/*
+==============================================================================
+============================ END OVERLAY SECTION =============================
+==============================================================================
+*/
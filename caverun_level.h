@@ -0,0 +1,81 @@
+// caverun_level.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <One level shared by every session playing it>
+
+/*
+Overview: When every client of a server plays the same level, the walls and
+starting layout are the same for all of them and only what each player has
+done differs. A level is set up once from a setup file and never changed
+after, and is shared by reference count between the server and every
+session playing it. Each session keeps only a level_overlay: its status,
+the few counters a session has, and the tiles it has changed from the
+level. Sessions are played one at a time on a single full session, the
+level_scratch, which the overlay is loaded onto before a statement and
+stored back from after it.
+*/
+
+#ifndef CAVERUN_LEVEL_H
+#define CAVERUN_LEVEL_H
+
+#include <stdio.h>
+
+#include "caverun.h"
+#include "caverun_session.h"
+
+//a level as it is when gameplay starts, never changed once loaded
+struct level {
+    int references;
+    struct game_state start;
+    int locked_exits;
+};
+
+//one tile a session has changed from its level, row * COLS + col
+struct level_change {
+    int index;
+    struct tile tile;
+};
+
+//everything one session playing a level has that the level doesn't
+struct level_overlay {
+    struct level *level;
+    struct game_status status;
+    enum session_phase phase;
+    int statements;
+    int turns;
+    int last_events;
+    struct session_macro macros[SESSION_MACROS];
+    int macro_count;
+    int rendered_turn;
+    long long rendered_ns;
+    int frame_skipped;
+    int locked_exits;
+    int render_pending;
+    int resume_turn;
+    struct level_change *changes;
+    int change_count;
+    int change_capacity;
+};
+
+//the full session overlays are played on, the board being its level's plus
+//the changes of the overlay last loaded
+struct level_scratch {
+    struct session session;
+    struct level *level;
+    struct level_overlay *loaded;
+};
+
+struct level *level_load(const char *path);
+void level_retain(struct level *level);
+void level_release(struct level *level);
+
+void overlay_begin(struct level_overlay *overlay, struct level *level,
+    FILE *out);
+struct session *overlay_load(struct level_scratch *scratch,
+    struct level_overlay *overlay, FILE *out);
+void overlay_store(struct level_scratch *scratch,
+    struct level_overlay *overlay);
+void overlay_end(struct level_scratch *scratch,
+    struct level_overlay *overlay);
+
+#endif
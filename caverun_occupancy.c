@@ -0,0 +1,177 @@
+// caverun_occupancy.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Map features placed in bulk with an occupancy index>
+
+/*
+Overview: A feature can only go on dirt, so every placement during setup asks
+whether a tile or a rectangle of tiles has anything other than dirt on it.
+validate_grouped_walls answers that by looking at every tile of the
+rectangle, which makes a big level built out of thousands of grouped walls
+slow. The occupancy index answers it in O(log ROWS * log COLS) instead.
+
+The index is a two dimensional Fenwick tree over the tiles that aren't dirt,
+in the form that adds to a whole rectangle as cheaply as it sums one: four
+trees hold the corner differences of the counts, and those differences times
+their row, their column and both, which is everything needed to sum any
+rectangle from its corners. A grouped wall is only ever placed on a
+rectangle that is all dirt, so placing it is one rectangle add, and a single
+feature is a one tile add. Lava doesn't count as it never makes a tile
+anything but dirt.
+
+engine_place_features plays a batch of placements in order against the
+index, giving exactly the board the usual setup functions would, and counts
+the results so the caller can report them all at once.
+*/
+
+#include <string.h>
+
+#include "caverun.h"
+
+void occupancy_add(struct occupancy_index *index, int row, int col,
+    long long delta);
+long long occupancy_prefix(struct occupancy_index *index, int row, int col);
+enum placement place_request(struct game_state *state,
+    struct occupancy_index *index, struct placement_request *request);
+
+//indexes every tile of a board that isn't dirt, in one pass over it
+void occupancy_build(struct occupancy_index *index,
+    struct tile board[ROWS][COLS]) {
+
+    memset(index, 0, sizeof(*index));
+    //each tile's corner difference from the tiles above and to its left
+    for (int i = 1; i <= ROWS; i++) {
+        for (int j = 1; j <= COLS; j++) {
+            long long delta = (board[i - 1][j - 1].entity != DIRT) -
+                (i > 1 && board[i - 2][j - 1].entity != DIRT) -
+                (j > 1 && board[i - 1][j - 2].entity != DIRT) +
+                (i > 1 && j > 1 && board[i - 2][j - 2].entity != DIRT);
+            index->tree[0][i][j] = delta;
+            index->tree[1][i][j] = delta * i;
+            index->tree[2][i][j] = delta * j;
+            index->tree[3][i][j] = delta * i * j;
+        }
+    }
+    //then each value is pushed to its parents, along rows and then columns
+    for (int k = 0; k < 4; k++) {
+        for (int i = 1; i <= ROWS; i++) {
+            for (int j = 1; j <= COLS; j++) {
+                int parent = j + (j & -j);
+                if (parent <= COLS) {
+                    index->tree[k][i][parent] += index->tree[k][i][j];
+                }
+            }
+        }
+        for (int i = 1; i <= ROWS; i++) {
+            int parent = i + (i & -i);
+            for (int j = 1; parent <= ROWS && j <= COLS; j++) {
+                index->tree[k][parent][j] += index->tree[k][i][j];
+            }
+        }
+    }
+}
+
+//how many tiles of a rectangle aren't dirt, the rectangle must be on the map
+long long occupancy_count(struct occupancy_index *index, int start_row,
+    int start_col, int end_row, int end_col) {
+
+    return occupancy_prefix(index, end_row + 1, end_col + 1) -
+        occupancy_prefix(index, start_row, end_col + 1) -
+        occupancy_prefix(index, end_row + 1, start_col) +
+        occupancy_prefix(index, start_row, start_col);
+}
+
+//adds to the count of every tile of a rectangle on the map
+void occupancy_fill(struct occupancy_index *index, int start_row,
+    int start_col, int end_row, int end_col, long long delta) {
+
+    occupancy_add(index, start_row + 1, start_col + 1, delta);
+    occupancy_add(index, start_row + 1, end_col + 2, -delta);
+    occupancy_add(index, end_row + 2, start_col + 1, -delta);
+    occupancy_add(index, end_row + 2, end_col + 2, delta);
+}
+
+//adds to one corner difference, counted from 1, corners past the edge of the
+//map never affect a tile on it and are left out
+void occupancy_add(struct occupancy_index *index, int row, int col,
+    long long delta) {
+
+    for (int i = row; i <= ROWS; i += i & -i) {
+        for (int j = col; j <= COLS; j += j & -j) {
+            index->tree[0][i][j] += delta;
+            index->tree[1][i][j] += delta * row;
+            index->tree[2][i][j] += delta * col;
+            index->tree[3][i][j] += delta * row * col;
+        }
+    }
+}
+
+//how many of the first row rows and col columns of tiles aren't dirt
+long long occupancy_prefix(struct occupancy_index *index, int row, int col) {
+
+    long long sums[4] = {0, 0, 0, 0};
+    for (int i = row; i > 0; i -= i & -i) {
+        for (int j = col; j > 0; j -= j & -j) {
+            for (int k = 0; k < 4; k++) {
+                sums[k] += index->tree[k][i][j];
+            }
+        }
+    }
+    return sums[0] * (row + 1) * (col + 1) - sums[1] * (col + 1) -
+        sums[2] * (row + 1) + sums[3];
+}
+
+//places a batch of features in order, recording each one's result and
+//counting them all in the summary
+void engine_place_features(struct game_state *state,
+    struct occupancy_index *index, struct placement_request requests[],
+    int count, struct placement_summary *summary) {
+
+    for (int i = 0; i < count; i++) {
+        requests[i].result = place_request(state, index, &requests[i]);
+        summary->requests++;
+        summary->results[requests[i].result]++;
+    }
+}
+
+//places one feature, checking the index instead of the tiles
+enum placement place_request(struct game_state *state,
+    struct occupancy_index *index, struct placement_request *request) {
+
+    int start_row = request->start_row;
+    int start_col = request->start_col;
+    int end_row = request->end_row;
+    int end_col = request->end_col;
+
+    if (request->instruction != PLACE_GROUPED_WALLS) {
+        end_row = start_row;
+        end_col = start_col;
+    }
+    if (start_row < 0 || start_row >= ROWS || start_col < 0 ||
+        start_col >= COLS || end_row < 0 || end_row >= ROWS ||
+        end_col < 0 || end_col >= COLS) {
+        return PLACEMENT_OFF_MAP;
+    }
+    //a backwards rectangle covers no tiles, so is placed without effect
+    if (start_row > end_row || start_col > end_col) {
+        return PLACEMENT_OK;
+    }
+    if (occupancy_count(index, start_row, start_col, end_row, end_col) > 0) {
+        return PLACEMENT_OCCUPIED;
+    }
+
+    if (request->instruction == PLACE_GROUPED_WALLS) {
+        for (int i = start_row; i <= end_row; i++) {
+            for (int j = start_col; j <= end_col; j++) {
+                state->board[i][j].entity = WALL;
+            }
+        }
+    } else {
+        engine_place_feature(state, request->instruction, start_row,
+            start_col);
+    }
+    if (state->board[start_row][start_col].entity != DIRT) {
+        occupancy_fill(index, start_row, start_col, end_row, end_col, 1);
+    }
+    return PLACEMENT_OK;
+}
@@ -0,0 +1,146 @@
+// caverun_pipeline.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Formats and writes boards on a thread of their own>
+
+/*
+Overview: The game thread fills the frame at head and then advances head
+with a release store, the render thread reads the frame at tail and then
+advances tail, so neither ever locks or touches a frame the other owns.
+Two semaphores count the ready and free frames, only so that an idle thread
+sleeps instead of spinning. When the ring is full the game thread waits for
+the render thread, so output can never pile up without limit. The render
+thread flushes the real output whenever it runs out of frames, which is
+when the game is waiting for input and its prompt has to be visible.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "caverun.h"
+#include "caverun_pipeline.h"
+#include "caverun_session.h"
+
+void pipeline_push(struct pipeline *pipeline, const char *text, 
+    int text_length, struct tile board[ROWS][COLS], int lives);
+void *pipeline_render(void *arg);
+
+//starts the render thread writing to out, FALSE if it can't
+int pipeline_start(struct pipeline *pipeline, FILE *out) {
+
+    pipeline->out = out;
+    atomic_init(&pipeline->head, 0);
+    atomic_init(&pipeline->tail, 0);
+    pipeline->capture = open_memstream(&pipeline->capture_data, 
+        &pipeline->capture_size);
+    if (pipeline->capture == NULL) {
+        perror("pipeline");
+        return FALSE;
+    }
+    sem_init(&pipeline->ready, 0, 0);
+    sem_init(&pipeline->free, 0, PIPELINE_FRAMES);
+    if (pthread_create(&pipeline->thread, NULL, pipeline_render, 
+        pipeline) != 0) {
+        perror("pipeline");
+        fclose(pipeline->capture);
+        free(pipeline->capture_data);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+//the stream the game should print its text into
+FILE *pipeline_stream(struct pipeline *pipeline) {
+
+    return pipeline->capture;
+}
+
+//hands everything printed so far to the render thread, followed by a copy
+//of the board if there is one, a NULL board only passes the text on
+void pipeline_publish(struct pipeline *pipeline, 
+    struct tile board[ROWS][COLS], int lives) {
+
+    fflush(pipeline->capture);
+    const char *text = pipeline->capture_data;
+    int length = pipeline->capture_size;
+    if (length == 0 && board == NULL) {
+        return;
+    }
+
+    //text longer than a frame goes in frames of its own first
+    while (length > PIPELINE_TEXT_SIZE) {
+        pipeline_push(pipeline, text, PIPELINE_TEXT_SIZE, NULL, 0);
+        text += PIPELINE_TEXT_SIZE;
+        length -= PIPELINE_TEXT_SIZE;
+    }
+    pipeline_push(pipeline, text, length, board, lives);
+    fseek(pipeline->capture, 0, SEEK_SET);
+}
+
+//writes everything still queued and stops the render thread
+void pipeline_stop(struct pipeline *pipeline) {
+
+    pipeline_publish(pipeline, NULL, 0);
+    //a post without a frame behind it tells the render thread to finish
+    sem_post(&pipeline->ready);
+    pthread_join(pipeline->thread, NULL);
+    fclose(pipeline->capture);
+    free(pipeline->capture_data);
+    sem_destroy(&pipeline->ready);
+    sem_destroy(&pipeline->free);
+    fflush(pipeline->out);
+}
+
+//fills the next free frame and publishes it, waiting if the ring is full
+void pipeline_push(struct pipeline *pipeline, const char *text, 
+    int text_length, struct tile board[ROWS][COLS], int lives) {
+
+    sem_wait(&pipeline->free);
+    unsigned int head = atomic_load_explicit(&pipeline->head, 
+        memory_order_relaxed);
+    struct frame *frame = &pipeline->frames[head % PIPELINE_FRAMES];
+
+    memcpy(frame->text, text, text_length);
+    frame->text_length = text_length;
+    frame->has_board = board != NULL;
+    if (board != NULL) {
+        memcpy(frame->board, board, sizeof(frame->board));
+        frame->lives = lives;
+    }
+    atomic_store_explicit(&pipeline->head, head + 1, memory_order_release);
+    sem_post(&pipeline->ready);
+}
+
+//writes frames in order until told to stop
+void *pipeline_render(void *arg) {
+
+    struct pipeline *pipeline = arg;
+
+    while (TRUE) {
+        sem_wait(&pipeline->ready);
+        unsigned int tail = atomic_load_explicit(&pipeline->tail,
+            memory_order_relaxed);
+        unsigned int head = atomic_load_explicit(&pipeline->head,
+            memory_order_acquire);
+        if (tail == head) {
+            return NULL;
+        }
+
+        struct frame *frame = &pipeline->frames[tail % PIPELINE_FRAMES];
+        fwrite(frame->text, 1, frame->text_length, pipeline->out);
+        if (frame->has_board) {
+            print_board(pipeline->out, frame->board, frame->lives);
+        }
+        atomic_store_explicit(&pipeline->tail, tail + 1, 
+            memory_order_release);
+        sem_post(&pipeline->free);
+
+        if (atomic_load_explicit(&pipeline->head, memory_order_acquire) == 
+            tail + 1) {
+            fflush(pipeline->out);
+        }
+    }
+}
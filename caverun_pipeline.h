@@ -0,0 +1,59 @@
+// caverun_pipeline.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Formats and writes boards on a thread of their own>
+
+/*
+Overview: A pipeline lets the game thread carry on with the next turn while
+the last one is still being printed. Everything a session prints goes into
+a memory stream, and each board it would print is instead copied into a
+frame together with the text printed before it. Frames pass to a render
+thread through a fixed ring, which formats the boards and writes everything
+out in the order it was produced.
+*/
+
+#ifndef CAVERUN_PIPELINE_H
+#define CAVERUN_PIPELINE_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "caverun.h"
+
+#define PIPELINE_FRAMES       3
+#define PIPELINE_TEXT_SIZE    4096
+
+//one unit of output: text, then optionally a board to format after it,
+//never changed once published
+struct frame {
+    char text[PIPELINE_TEXT_SIZE];
+    int text_length;
+    int has_board;
+    struct tile board[ROWS][COLS];
+    int lives;
+};
+
+//single producer, single consumer ring, head is only written by the game
+//thread and tail only by the render thread
+struct pipeline {
+    struct frame frames[PIPELINE_FRAMES];
+    atomic_uint head;
+    atomic_uint tail;
+    sem_t ready;
+    sem_t free;
+    pthread_t thread;
+    FILE *out;
+    FILE *capture;
+    char *capture_data;
+    size_t capture_size;
+};
+
+int pipeline_start(struct pipeline *pipeline, FILE *out);
+FILE *pipeline_stream(struct pipeline *pipeline);
+void pipeline_publish(struct pipeline *pipeline, 
+    struct tile board[ROWS][COLS], int lives);
+void pipeline_stop(struct pipeline *pipeline);
+
+#endif
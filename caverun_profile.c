@@ -0,0 +1,66 @@
+// caverun_profile.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Optional timers, counters and trace spans for a turn>
+
+#include <string.h>
+
+#include "caverun_profile.h"
+
+struct profile profile;
+struct trace_buffer trace_buffer;
+_Thread_local int profile_active = FALSE;
+_Thread_local int trace_active = FALSE;
+
+const char *PROFILE_TIMER_NAMES[PROFILE_TIMERS] = {
+    "whole turn", "input parse", "player move", "boulder turn", "lava turn",
+    "visibility", "print board"
+};
+
+const char *PROFILE_COUNTER_NAMES[PROFILE_COUNTERS] = {
+    "boulders moved", "lava cells born", "lava cells killed", "rays traced"
+};
+
+//forgets everything recorded so far
+void profile_reset(void) {
+
+    memset(&profile, 0, sizeof(profile));
+}
+
+//ends a phase that started at start_ns, a full trace buffer drops the span
+//instead of writing it out in the middle of a turn
+void profile_stop(long long start_ns, enum profile_timer timer) {
+
+    long long duration_ns = monotonic_ns() - start_ns;
+#ifdef CAVERUN_PROFILE
+    if (profile_active) {
+        latency_record(&profile.timers[timer], duration_ns);
+    }
+#endif
+    if (!trace_active) {
+        return;
+    } else if (trace_buffer.count == TRACE_BUFFER_EVENTS) {
+        trace_buffer.dropped++;
+        return;
+    }
+    struct trace_event *event = &trace_buffer.events[trace_buffer.count];
+    event->timer = timer;
+    event->start_ns = start_ns;
+    event->duration_ns = duration_ns;
+    event->command.instruction = '\0';
+    event->lava_cells = 0;
+    trace_buffer.count++;
+}
+
+//adds the command and lava population to the turn span just recorded
+void trace_annotate_turn(struct command command, int lava_cells) {
+
+    if (trace_buffer.count == 0) {
+        return;
+    }
+    struct trace_event *event = &trace_buffer.events[trace_buffer.count - 1];
+    if (event->timer == TIMER_TURN) {
+        event->command = command;
+        event->lava_cells = lava_cells;
+    }
+}
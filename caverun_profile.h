@@ -0,0 +1,100 @@
+// caverun_profile.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Optional timers, counters and trace spans for a turn>
+
+/*
+Overview: The phases of a turn are wrapped in PROFILE_START and PROFILE_STOP.
+Building with -DCAVERUN_PROFILE=ON records every phase into a latency
+histogram and counts the work done inside it. Independently of the build,
+a front-end can turn on tracing at runtime, which keeps every phase as a
+span in an in-memory buffer for caverun_trace.c to write out between turns.
+With neither on, a phase costs one predictable branch and the counters
+compile to nothing.
+
+Only threads that set profile_active or trace_active record anything, which
+keeps the hint search and batch threads from mixing their steps into the
+player's turns.
+*/
+
+#ifndef CAVERUN_PROFILE_H
+#define CAVERUN_PROFILE_H
+
+#include "caverun.h"
+#include "caverun_latency.h"
+
+#define TRACE_BUFFER_EVENTS   8192
+
+enum profile_timer {
+    TIMER_TURN,
+    TIMER_PARSE,
+    TIMER_MOVE,
+    TIMER_BOULDERS,
+    TIMER_LAVA,
+    TIMER_VISIBILITY,
+    TIMER_RENDER,
+    PROFILE_TIMERS
+};
+
+enum profile_counter {
+    COUNT_BOULDERS_MOVED,
+    COUNT_LAVA_BORN,
+    COUNT_LAVA_KILLED,
+    COUNT_RAYS_TRACED,
+    PROFILE_COUNTERS
+};
+
+struct profile {
+    struct latency_histogram timers[PROFILE_TIMERS];
+    long long counters[PROFILE_COUNTERS];
+};
+
+//one finished phase, turns also carry the command and the lava population
+struct trace_event {
+    enum profile_timer timer;
+    long long start_ns;
+    long long duration_ns;
+    struct command command;
+    int lava_cells;
+};
+
+struct trace_buffer {
+    struct trace_event events[TRACE_BUFFER_EVENTS];
+    int count;
+    long long dropped;
+};
+
+extern struct profile profile;
+extern struct trace_buffer trace_buffer;
+extern _Thread_local int profile_active;
+extern _Thread_local int trace_active;
+extern const char *PROFILE_TIMER_NAMES[PROFILE_TIMERS];
+extern const char *PROFILE_COUNTER_NAMES[PROFILE_COUNTERS];
+
+#ifdef CAVERUN_PROFILE
+#define PROFILE_RECORDING  (profile_active || trace_active)
+#define PROFILE_COUNT(counter, amount) \
+    do { \
+        if (profile_active) { \
+            profile.counters[counter] += amount; \
+        } \
+    } while (0)
+#else
+#define PROFILE_RECORDING  trace_active
+#define PROFILE_COUNT(counter, amount)
+#endif
+
+#define PROFILE_START(timer) \
+    long long timer = PROFILE_RECORDING ? monotonic_ns() : 0
+#define PROFILE_STOP(timer, which) \
+    do { \
+        if (PROFILE_RECORDING) { \
+            profile_stop(timer, which); \
+        } \
+    } while (0)
+
+void profile_reset(void);
+void profile_stop(long long start_ns, enum profile_timer timer);
+void trace_annotate_turn(struct command command, int lava_cells);
+
+#endif
@@ -0,0 +1,261 @@
+// caverun_realtime.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <The console game played in real time, one turn per tick>
+
+/*
+Overview: Setup is read a line at a time exactly like the console game. When
+gameplay starts the terminal leaves canonical mode, so keys are delivered as
+they are pressed without Enter and without being echoed, and from then on
+the loop sleeps in poll until either a key arrives or the next tick is due,
+whichever is first. Each byte of input keeps the time it was read, so when
+a tick plays the command a key completed, the time from that key to the
+frame being flushed is recorded. It is at most one tick plus the time to
+play and print the turn, and the percentiles are printed when the game
+ends, along with any keys that waited through a whole tick without being
+played (e.g. typed faster than one per tick) and any ticks that had to be
+dropped. Input that isn't a terminal (e.g. a file) is played the
+same way, one command per tick, without changing any terminal settings.
+*/
+
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "caverun.h"
+#include "caverun_broadcast.h"
+#include "caverun_pipeline.h"
+#include "caverun_realtime.h"
+#include "caverun_trace.h"
+
+volatile sig_atomic_t realtime_stop = FALSE;
+
+void realtime_setup(struct realtime *realtime, struct session *session);
+void realtime_wait(struct realtime *realtime, struct session *session);
+void realtime_read(struct realtime *realtime);
+void realtime_tick(struct realtime *realtime, struct session *session);
+void realtime_consume(struct realtime *realtime, int used);
+void realtime_flush(struct session *session);
+void realtime_raw_mode(struct realtime *realtime);
+void realtime_restore(struct realtime *realtime);
+void realtime_handle_stop(int signal_number);
+void print_realtime_stats(FILE *out, struct realtime *realtime);
+
+//plays the session's game from stdin, advancing it every tick_ms whether or
+//not a key has been pressed
+int realtime_play(struct session *session, int tick_ms) {
+
+    static struct realtime realtime;
+    realtime.tick_ns = tick_ms * NS_PER_MS;
+    realtime.next_tick_ns = 0;
+    latency_reset(&realtime.key_to_frame);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = realtime_handle_stop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    while (!realtime_stop && session->phase != PHASE_OVER) {
+        realtime_flush(session);
+        if (session->phase != PHASE_GAMEPLAY) {
+            if (realtime.at_eof) {
+                break;
+            }
+            realtime_setup(&realtime, session);
+            continue;
+        }
+        //once input has ended the game runs until what is left is played
+        if (realtime.at_eof && realtime.input_length == 0) {
+            break;
+        }
+        if (realtime.next_tick_ns == 0) {
+            realtime_raw_mode(&realtime);
+            realtime.next_tick_ns = monotonic_ns() + realtime.tick_ns;
+        }
+
+        realtime_wait(&realtime, session);
+        if (monotonic_ns() < realtime.next_tick_ns) {
+            continue;
+        }
+        realtime_tick(&realtime, session);
+        realtime.next_tick_ns += realtime.tick_ns;
+        //ticks due while this one was played are dropped, not caught up
+        long long now = monotonic_ns();
+        if (now >= realtime.next_tick_ns) {
+            long long missed = (now - realtime.next_tick_ns) /
+                realtime.tick_ns + 1;
+            realtime.dropped += missed;
+            realtime.next_tick_ns += missed * realtime.tick_ns;
+        }
+    }
+    realtime_restore(&realtime);
+    if (realtime.ticks > 0) {
+        print_realtime_stats(stderr, &realtime);
+    }
+    return 0;
+}
+
+//reads setup statements as the console game does, blocking until they come
+void realtime_setup(struct realtime *realtime, struct session *session) {
+
+    realtime_read(realtime);
+    int used;
+    while (session->phase != PHASE_GAMEPLAY && session->phase != PHASE_OVER &&
+        (used = session_step(session, realtime->input,
+        realtime->input_length, realtime->at_eof)) > 0) {
+        realtime_consume(realtime, used);
+    }
+}
+
+//sleeps until a key arrives or the next tick is due
+void realtime_wait(struct realtime *realtime, struct session *session) {
+
+    if (session->broadcast != NULL) {
+        broadcast_poll(session->broadcast);
+    }
+    //keys already waiting are still read when the tick is overdue
+    long long wait_ns = realtime->next_tick_ns - monotonic_ns();
+    struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+    int timeout_ms = wait_ns <= 0 ? 0 :
+        (int) ((wait_ns + NS_PER_MS - 1) / NS_PER_MS);
+    int ready = poll(&input, realtime->at_eof ? 0 : 1, timeout_ms);
+    if (ready > 0) {
+        realtime_read(realtime);
+    }
+}
+
+//appends whatever input is waiting, stamping every byte with when it came
+void realtime_read(struct realtime *realtime) {
+
+    int space = REALTIME_INPUT_SIZE - realtime->input_length;
+    if (space == 0) {
+        return;
+    }
+    ssize_t count = read(STDIN_FILENO,
+        realtime->input + realtime->input_length, space);
+    if (count < 0 && errno == EINTR) {
+        return;
+    } else if (count <= 0) {
+        realtime->at_eof = TRUE;
+        return;
+    }
+    long long now = monotonic_ns();
+    for (int i = 0; i < count; i++) {
+        realtime->arrival_ns[realtime->input_length + i] = now;
+    }
+    realtime->input_length += count;
+}
+
+//plays one tick: the first command the input completes, or the cave moving
+//on by itself
+void realtime_tick(struct realtime *realtime, struct session *session) {
+
+    int turns = session->turns;
+    while (session->turns == turns && session->phase == PHASE_GAMEPLAY) {
+        int used = session_step(session, realtime->input,
+            realtime->input_length, realtime->at_eof);
+        int pending = realtime->input_length;
+        if (used == 0 && pending > 0 &&
+            isdigit((unsigned char) realtime->input[pending - 1])) {
+            //a number could still go on, but the tick won't wait for it
+            used = session_step(session, realtime->input,
+                realtime->input_length, TRUE);
+        }
+        if (used == 0) {
+            break;
+        }
+        //the key that completed the command is the one the player waits on
+        long long pressed_ns = realtime->arrival_ns[used - 1];
+        realtime_consume(realtime, used);
+        if (session->turns != turns) {
+            realtime_flush(session);
+            long long latency_ns = monotonic_ns() - pressed_ns;
+            latency_record(&realtime->key_to_frame, latency_ns);
+            //a key is late if an earlier tick came after it and missed it
+            if (pressed_ns < realtime->next_tick_ns - realtime->tick_ns) {
+                realtime->late_frames++;
+            }
+        }
+    }
+    if (session->turns == turns && session->phase == PHASE_GAMEPLAY) {
+        session_tick(session);
+    }
+    realtime->ticks++;
+    trace_flush_if_needed();
+}
+
+//drops the first used bytes of input and their arrival times
+void realtime_consume(struct realtime *realtime, int used) {
+
+    realtime->input_length -= used;
+    memmove(realtime->input, realtime->input + used, realtime->input_length);
+    memmove(realtime->arrival_ns, realtime->arrival_ns + used,
+        realtime->input_length * sizeof(realtime->arrival_ns[0]));
+}
+
+//gets everything printed so far onto the screen
+void realtime_flush(struct session *session) {
+
+    if (session->pipeline != NULL) {
+        pipeline_publish(session->pipeline, NULL, 0);
+    } else if (session->out != NULL) {
+        fflush(session->out);
+    }
+}
+
+//keys arrive one at a time without Enter and aren't echoed, output and
+//signals such as Ctrl-C are left as they were
+void realtime_raw_mode(struct realtime *realtime) {
+
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO,
+        &realtime->saved) != 0) {
+        return;
+    }
+    struct termios raw = realtime->saved;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0) {
+        realtime->raw = TRUE;
+    }
+}
+
+//puts the terminal back the way it was found
+void realtime_restore(struct realtime *realtime) {
+
+    if (realtime->raw) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &realtime->saved);
+        realtime->raw = FALSE;
+    }
+}
+
+//ends the game at the next wake up so the terminal can be restored
+void realtime_handle_stop(int signal_number) {
+
+    (void) signal_number;
+    realtime_stop = TRUE;
+}
+
+//how well the ticks kept up and how long keys took to reach the screen
+void print_realtime_stats(FILE *out, struct realtime *realtime) {
+
+    struct latency_histogram *latency = &realtime->key_to_frame;
+    fprintf(out, "Real time: %lld ticks of %lldms, %lld dropped\n",
+        realtime->ticks, realtime->tick_ns / NS_PER_MS, realtime->dropped);
+    if (latency->total == 0) {
+        return;
+    }
+    fprintf(out, "Key to frame: p50 %.2fms, p99 %.2fms, max %.2fms, "
+        "%lld of %lld keys missed a tick\n",
+        (double) latency_percentile(latency, 50.0) / NS_PER_MS,
+        (double) latency_percentile(latency, 99.0) / NS_PER_MS,
+        (double) latency->max_ns / NS_PER_MS, realtime->late_frames,
+        latency->total);
+}
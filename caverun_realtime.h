@@ -0,0 +1,47 @@
+// caverun_realtime.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <The console game played in real time, one turn per tick>
+
+/*
+Overview: In real time the cave doesn't wait for the player. Once setup is
+over the terminal is put in raw mode so every key arrives as it is pressed,
+and the game advances on a fixed tick: a tick plays the command the keys
+pressed so far complete, or if there isn't one the cave ticks on without a
+command, so boulders fall and lava spreads either way. A command ending in
+a number, e.g. "i 3", can't tell whether more digits are coming, so a tick
+plays it as it stands. Ticks are scheduled on the monotonic clock against
+when they were due rather than when the last one finished, so they never
+drift, and ticks missed entirely (e.g. the terminal stalled) are dropped
+instead of played all at once.
+*/
+
+#ifndef CAVERUN_REALTIME_H
+#define CAVERUN_REALTIME_H
+
+#include <termios.h>
+
+#include "caverun_latency.h"
+#include "caverun_session.h"
+
+#define REALTIME_DEFAULT_TICK_MS  100
+#define REALTIME_INPUT_SIZE       256
+
+struct realtime {
+    long long tick_ns;
+    long long next_tick_ns;
+    long long ticks;
+    long long dropped;
+    long long late_frames;
+    struct latency_histogram key_to_frame;
+    char input[REALTIME_INPUT_SIZE];
+    long long arrival_ns[REALTIME_INPUT_SIZE];
+    int input_length;
+    int at_eof;
+    int raw;
+    struct termios saved;
+};
+
+int realtime_play(struct session *session, int tick_ms);
+
+#endif
@@ -0,0 +1,873 @@
+// caverun_server.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Hosts many games of CS Caverun in one process>
+
+/*
+Overview: Every connection gets a slot from a pool allocated at startup. A
+slot holds the game session, the input that hasn't formed a full statement
+yet and a fixed output buffer opened with fmemopen, so the session prints
+exactly as it would to stdout. The epoll loop reads whatever a client sent,
+plays every complete statement and writes the output back without blocking.
+A statement is only played when the output buffer has room for everything
+one turn could print, otherwise the slot stops reading until the client
+catches up, so a slow reader holds back only its own game. A counted
+command or macro that fills the buffer partway is stopped the same way
+before its next turn and goes on from there once the output is sent.
+
+A slot plays at most SERVER_SLICE_TURNS turns each time it is served, so a
+long counted command or macro stops partway and goes back to the event
+loop, letting every other client play before it carries on. Hints are
+searched on a worker thread instead of the event loop: a statement stops
+before its hint turn, the worker searches a copy of the game and wakes the
+loop through an eventfd, and the statement goes on with the hint it found.
+A slot whose client leaves while its hint is being searched is only freed
+once the search is done.
+
+Every turn's latency is measured from when its input became runnable (read
+in full, or free to go on after a slice or a full output buffer, or handed
+to the hint worker) to the end of the turn and kept in a histogram, so the
+time a turn spends queued behind other clients counts. A summary with the
+50th, 99th and 99.9th percentiles, CPU use and sessions per core goes to
+stderr every SERVER_REPORT_SECONDS, on SIGUSR1 and at shutdown (SIGINT or
+SIGTERM).
+
+With --level every client plays the same level instead of setting one up,
+and a slot holds a level_overlay instead of a whole session, so it only
+grows with the tiles its game has changed. Statements are played on one
+scratch session shared by every slot, see caverun_level.c. SIGHUP loads the
+level file again for new clients, while games already on the old level
+finish on it.
+*/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "caverun.h"
+#include "caverun_latency.h"
+#include "caverun_level.h"
+#include "caverun_profile.h"
+#include "caverun_server.h"
+#include "caverun_session.h"
+
+#define SERVER_INPUT_SIZE      4096
+#define SERVER_BOARD_TEXT      ((2 * ROWS + 4) * (4 * COLS + 2) + 64)
+#define SERVER_STATEMENT_ROOM  (2 * SERVER_BOARD_TEXT + 1024)
+#define SERVER_OUTPUT_SIZE     (4 * SERVER_STATEMENT_ROOM)
+#define SERVER_SLICE_TURNS     64
+#define SERVER_MAX_EVENTS      64
+#define SERVER_LISTEN_BACKLOG  128
+#define SERVER_WAIT_MS         1000
+#define SERVER_REPORT_SECONDS  10
+#define SERVER_MIN_CORE_USE    0.01
+#define SERVER_FULL_MESSAGE    "Server full! Try again later.\n"
+
+//one connected client and the game being played over it
+struct server_slot {
+    int fd;
+    int input_closed;
+    int output_closed;
+    int held_back;
+    unsigned int events;
+    struct session *session;
+    struct level_overlay overlay;
+    struct session_hint hint;
+    int hint_queued;
+    struct game_state *hint_state;
+    struct server_slot *next_hint;
+    char input[SERVER_INPUT_SIZE];
+    int input_length;
+    long long runnable_ns;
+    char output[SERVER_OUTPUT_SIZE];
+    FILE *out;
+    long output_length;
+    long output_sent;
+    struct server_slot *next_free;
+};
+
+//the hint worker, slots are queued for it and handed back in done
+struct server_hints {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t queued;
+    struct server_slot *queue_head;
+    struct server_slot *queue_tail;
+    struct server_slot *done;
+    int event_fd;
+    int stopping;
+};
+
+struct server {
+    int epoll_fd;
+    int listen_fd;
+    struct server_slot *slots;
+    struct server_slot *free_slots;
+    struct session *sessions;
+    const char *level_path;
+    struct level *level;
+    struct level_scratch scratch;
+    struct server_hints hints;
+    int max_sessions;
+    int active;
+    int peak;
+    long long served;
+    long long rejected;
+    long long turns;
+    struct latency_histogram turn_latency;
+    long long start_ns;
+    long long last_tick_ns;
+    long long last_report_ns;
+    double last_cpu_seconds;
+    double session_seconds;
+    double last_session_seconds;
+};
+
+volatile sig_atomic_t server_report_requested = FALSE;
+volatile sig_atomic_t server_stop_requested = FALSE;
+volatile sig_atomic_t server_reload_requested = FALSE;
+
+int server_open_listener(struct server_options *options);
+int server_allocate(struct server *server, int max_sessions);
+void server_handle_signal(int signal_number);
+void server_accept(struct server *server);
+enum session_phase server_phase(struct server_slot *slot);
+void server_service(struct server *server, struct server_slot *slot,
+    unsigned int events);
+void server_play_statements(struct server *server, struct server_slot *slot);
+void server_collect_output(struct server_slot *slot);
+int server_flush(struct server_slot *slot);
+void server_update_interest(struct server *server, struct server_slot *slot);
+void server_close(struct server *server, struct server_slot *slot);
+void server_free_slot(struct server *server, struct server_slot *slot);
+int server_start_hints(struct server *server);
+void server_stop_hints(struct server *server);
+void server_queue_hint(struct server *server, struct server_slot *slot,
+    struct session *session);
+void *server_hint_worker(void *arg);
+void server_finish_hints(struct server *server);
+void server_reload(struct server *server);
+void server_tick(struct server *server);
+void server_report(struct server *server);
+void print_level_memory(struct server *server);
+
+/*
+==============================================================================
+============================ START SERVER SECTION ============================
+==============================================================================
+*/
+
+//runs the server until it is interrupted, returns the exit status
+int server_run(struct server_options *options) {
+
+    static struct server server;
+    server.level_path = options->level_path;
+    if (server.level_path != NULL) {
+        server.level = level_load(server.level_path);
+        if (server.level == NULL) {
+            return 1;
+        }
+    }
+    server.listen_fd = server_open_listener(options);
+    if (server.listen_fd < 0) {
+        return 1;
+    }
+    if (!server_allocate(&server, options->max_sessions)) {
+        fprintf(stderr, "Could not allocate %d sessions\n",
+            options->max_sessions);
+        return 1;
+    }
+
+    server.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event listen_event = {EPOLLIN, {NULL}};
+    if (server.epoll_fd < 0 || epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD,
+        server.listen_fd, &listen_event) < 0) {
+        perror("epoll");
+        return 1;
+    }
+    if (!server_start_hints(&server)) {
+        return 1;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = server_handle_signal;
+    sigaction(SIGUSR1, &action, NULL);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGHUP, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    profile_active = TRUE;
+    server.start_ns = monotonic_ns();
+    server.last_tick_ns = server.start_ns;
+    server.last_report_ns = server.start_ns;
+    fprintf(stderr, "Serving up to %d sessions\n", server.max_sessions);
+
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!server_stop_requested) {
+        int count = epoll_wait(server.epoll_fd, events, SERVER_MAX_EVENTS,
+            SERVER_WAIT_MS);
+        if (count < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.ptr == NULL) {
+                server_accept(&server);
+            } else if (events[i].data.ptr == &server.hints) {
+                server_finish_hints(&server);
+            } else {
+                server_service(&server, events[i].data.ptr, events[i].events);
+            }
+        }
+        server_tick(&server);
+    }
+
+    server_report(&server);
+    server_stop_hints(&server);
+    for (int i = 0; i < server.max_sessions; i++) {
+        if (server.slots[i].fd >= 0) {
+            server_close(&server, &server.slots[i]);
+        }
+        free(server.slots[i].hint_state);
+    }
+    level_release(server.level);
+    level_release(server.scratch.level);
+    close(server.listen_fd);
+    if (options->unix_path != NULL) {
+        unlink(options->unix_path);
+    }
+    return 0;
+}
+
+//binds the local TCP port or Unix socket the server listens on
+int server_open_listener(struct server_options *options) {
+
+    int listen_fd;
+    if (options->unix_path != NULL) {
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (strlen(options->unix_path) >= sizeof(address.sun_path)) {
+            fprintf(stderr, "Socket path is too long: %s\n",
+                options->unix_path);
+            return -1;
+        }
+        strcpy(address.sun_path, options->unix_path);
+        unlink(options->unix_path);
+
+        listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK |
+            SOCK_CLOEXEC, 0);
+        if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *) &address,
+            sizeof(address)) < 0) {
+            perror(options->unix_path);
+            return -1;
+        }
+        fprintf(stderr, "Listening on %s\n", options->unix_path);
+    } else {
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(options->port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        int reuse = TRUE;
+        listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK |
+            SOCK_CLOEXEC, 0);
+        if (listen_fd >= 0) {
+            setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse,
+                sizeof(reuse));
+        }
+        if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *) &address,
+            sizeof(address)) < 0) {
+            perror("bind");
+            return -1;
+        }
+        fprintf(stderr, "Listening on 127.0.0.1:%d\n", options->port);
+    }
+
+    if (listen(listen_fd, SERVER_LISTEN_BACKLOG) < 0) {
+        perror("listen");
+        return -1;
+    }
+    return listen_fd;
+}
+
+//allocates every session slot up front and chains them into a free list,
+//slots playing a level have no session of their own
+int server_allocate(struct server *server, int max_sessions) {
+
+    server->max_sessions = max_sessions;
+    server->slots = calloc(max_sessions, sizeof(struct server_slot));
+    if (server->slots == NULL) {
+        return FALSE;
+    }
+    if (server->level == NULL) {
+        server->sessions = calloc(max_sessions, sizeof(struct session));
+        if (server->sessions == NULL) {
+            return FALSE;
+        }
+    }
+    server->free_slots = NULL;
+    for (int i = max_sessions - 1; i >= 0; i--) {
+        struct server_slot *slot = &server->slots[i];
+        slot->fd = -1;
+        slot->session = server->level == NULL ? &server->sessions[i] : NULL;
+        slot->out = fmemopen(slot->output, SERVER_OUTPUT_SIZE, "w");
+        if (slot->out == NULL) {
+            return FALSE;
+        }
+        slot->next_free = server->free_slots;
+        server->free_slots = slot;
+    }
+    latency_reset(&server->turn_latency);
+    return TRUE;
+}
+
+//only sets flags, the event loop does the work
+void server_handle_signal(int signal_number) {
+
+    if (signal_number == SIGUSR1) {
+        server_report_requested = TRUE;
+    } else if (signal_number == SIGHUP) {
+        server_reload_requested = TRUE;
+    } else {
+        server_stop_requested = TRUE;
+    }
+}
+
+//takes every waiting connection and starts a game on each one
+void server_accept(struct server *server) {
+
+    int fd;
+    while ((fd = accept4(server->listen_fd, NULL, NULL,
+        SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        struct server_slot *slot = server->free_slots;
+        if (slot == NULL) {
+            //best effort only, the socket is non-blocking
+            ssize_t ignored = write(fd, SERVER_FULL_MESSAGE,
+                strlen(SERVER_FULL_MESSAGE));
+            (void) ignored;
+            close(fd);
+            server->rejected++;
+            continue;
+        }
+        server->free_slots = slot->next_free;
+
+        slot->fd = fd;
+        slot->input_closed = FALSE;
+        slot->output_closed = FALSE;
+        slot->held_back = FALSE;
+        slot->hint.wanted = FALSE;
+        slot->hint.ready = FALSE;
+        slot->input_length = 0;
+        slot->events = 0;
+        rewind(slot->out);
+        slot->output_length = 0;
+        slot->output_sent = 0;
+        if (slot->session != NULL) {
+            session_begin(slot->session, slot->out);
+        } else {
+            overlay_begin(&slot->overlay, server->level, slot->out);
+        }
+        server_collect_output(slot);
+
+        struct epoll_event event = {0, {slot}};
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            slot->next_free = server->free_slots;
+            server->free_slots = slot;
+            slot->fd = -1;
+            close(fd);
+            continue;
+        }
+        server->active++;
+        server->served++;
+        if (server->active > server->peak) {
+            server->peak = server->active;
+        }
+        server_update_interest(server, slot);
+    }
+}
+
+//the phase of a client's game, without loading it if it plays a level
+enum session_phase server_phase(struct server_slot *slot) {
+
+    if (slot->session != NULL) {
+        return slot->session->phase;
+    }
+    return slot->overlay.phase;
+}
+
+//reads from and writes to one client as far as it will go without blocking
+void server_service(struct server *server, struct server_slot *slot,
+    unsigned int events) {
+
+    if (events & EPOLLIN) {
+        ssize_t count = read(slot->fd, slot->input + slot->input_length,
+            SERVER_INPUT_SIZE - slot->input_length);
+        if (count > 0 && server_phase(slot) == PHASE_OVER) {
+            //the game is over, anything else the client sends is ignored
+            slot->input_length = 0;
+        } else if (count > 0) {
+            //input behind a stopped statement only runs once it goes on
+            if (!slot->held_back && !slot->hint_queued) {
+                slot->runnable_ns = monotonic_ns();
+            }
+            slot->input_length += count;
+        } else if (count == 0 || (errno != EAGAIN && errno != EINTR)) {
+            slot->input_closed = TRUE;
+        }
+    } else if (events & (EPOLLHUP | EPOLLERR)) {
+        slot->input_closed = TRUE;
+    }
+    server_play_statements(server, slot);
+    server_update_interest(server, slot);
+}
+
+//plays every complete statement there is output room for, up to a slice
+//of turns, unless the slot is waiting on its hint
+void server_play_statements(struct server *server, struct server_slot *slot) {
+
+    struct session *session = slot->session;
+    int used = 0;
+
+    if (slot->hint_queued) {
+        return;
+    }
+    if (session == NULL) {
+        session = overlay_load(&server->scratch, &slot->overlay, slot->out);
+    }
+    session->out_limit = SERVER_OUTPUT_SIZE - SERVER_STATEMENT_ROOM;
+    session->turn_limit = SERVER_SLICE_TURNS;
+    session->slice_turns = 0;
+    session->hint = &slot->hint;
+    session->latency = &server->turn_latency;
+    session->runnable_ns = slot->runnable_ns;
+    int turns = session->turns;
+    slot->held_back = FALSE;
+    while (session->phase != PHASE_OVER) {
+        if (SERVER_OUTPUT_SIZE - slot->output_length < SERVER_STATEMENT_ROOM) {
+            slot->held_back = TRUE;
+            break;
+        }
+        int step = session_step(session, slot->input + used,
+            slot->input_length - used, slot->input_closed);
+        if (step == 0 && used == 0 && !session->stopped &&
+            slot->input_length == SERVER_INPUT_SIZE) {
+            //a statement longer than the whole buffer is played as it is
+            step = session_step(session, slot->input, SERVER_INPUT_SIZE, 
+                TRUE);
+        }
+        if (session->stopped && slot->hint.wanted) {
+            server_collect_output(slot);
+            server_queue_hint(server, slot, session);
+            break;
+        } else if (session->stopped) {
+            //the rest of the statement waits for its output to be sent or
+            //for the other clients to have their turn
+            server_collect_output(slot);
+            slot->held_back = TRUE;
+            slot->runnable_ns = monotonic_ns();
+            break;
+        }
+        if (step == 0) {
+            break;
+        }
+        used += step;
+        server_collect_output(slot);
+    }
+    server->turns += session->turns - turns;
+
+    memmove(slot->input, slot->input + used, slot->input_length - used);
+    slot->input_length -= used;
+    if (slot->input_closed && slot->input_length == 0 && 
+        session->phase != PHASE_OVER) {
+        session_finish(session);
+        server_collect_output(slot);
+    }
+    if (slot->session == NULL) {
+        overlay_store(&server->scratch, &slot->overlay);
+    }
+}
+
+//moves what the session printed into the output buffer, ready to send
+void server_collect_output(struct server_slot *slot) {
+
+    fflush(slot->out);
+    slot->output_length = ftell(slot->out);
+}
+
+//sends as much pending output as the socket takes, returns FALSE on error
+int server_flush(struct server_slot *slot) {
+
+    while (slot->output_sent < slot->output_length) {
+        ssize_t count = write(slot->fd, slot->output + slot->output_sent,
+            slot->output_length - slot->output_sent);
+        if (count < 0) {
+            return errno == EAGAIN || errno == EINTR;
+        }
+        slot->output_sent += count;
+    }
+    if (slot->held_back && slot->output_length > 0) {
+        //a statement stopped for room can go on now it has been sent
+        slot->runnable_ns = monotonic_ns();
+    }
+    rewind(slot->out);
+    slot->output_length = 0;
+    slot->output_sent = 0;
+    return TRUE;
+}
+
+//flushes a client and decides what to wait for next, closing it when done
+void server_update_interest(struct server *server, struct server_slot *slot) {
+
+    if (!server_flush(slot)) {
+        server_close(server, slot);
+        return;
+    }
+    //sending everything makes room for statements that were held back,
+    //one round per wakeup so a single fast client can't starve the rest
+    if (slot->output_length == 0 && slot->held_back) {
+        server_play_statements(server, slot);
+        if (!server_flush(slot)) {
+            server_close(server, slot);
+            return;
+        }
+    }
+
+    //once the game is over the client's unread input is drained before
+    //closing, since closing with it unread would reset the connection and
+    //could throw away the last of the output
+    int pending_output = slot->output_sent < slot->output_length;
+    if (server_phase(slot) == PHASE_OVER && !pending_output) {
+        if (!slot->output_closed) {
+            shutdown(slot->fd, SHUT_WR);
+            slot->output_closed = TRUE;
+        }
+        if (slot->input_closed) {
+            server_close(server, slot);
+            return;
+        }
+    }
+
+    unsigned int events = 0;
+    if (pending_output || slot->held_back) {
+        events |= EPOLLOUT;
+    }
+    if (slot->output_closed && !slot->input_closed) {
+        events |= EPOLLIN;
+    } else if (!slot->input_closed && server_phase(slot) != PHASE_OVER &&
+        slot->input_length < SERVER_INPUT_SIZE &&
+        SERVER_OUTPUT_SIZE - slot->output_length >= SERVER_STATEMENT_ROOM) {
+        events |= EPOLLIN;
+    }
+    if (events != slot->events) {
+        struct epoll_event event = {events, {slot}};
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, slot->fd, &event);
+        slot->events = events;
+    }
+}
+
+//ends a connection and returns its slot to the pool
+void server_close(struct server *server, struct server_slot *slot) {
+
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, slot->fd, NULL);
+    close(slot->fd);
+    slot->fd = -1;
+    if (slot->session == NULL) {
+        overlay_end(&server->scratch, &slot->overlay);
+    }
+    server->active--;
+    //the hint worker still has the slot, it is freed once the hint is in
+    if (!slot->hint_queued) {
+        server_free_slot(server, slot);
+    }
+}
+
+//returns a slot to the pool
+void server_free_slot(struct server *server, struct server_slot *slot) {
+
+    slot->next_free = server->free_slots;
+    server->free_slots = slot;
+}
+
+/*
+==============================================================================
+============================= END SERVER SECTION =============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+============================= START HINT SECTION =============================
+==============================================================================
+*/
+
+//starts the hint worker and adds its eventfd to the event loop
+int server_start_hints(struct server *server) {
+
+    struct server_hints *hints = &server->hints;
+    hints->queue_head = NULL;
+    hints->queue_tail = NULL;
+    hints->done = NULL;
+    hints->stopping = FALSE;
+    hints->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event event = {EPOLLIN, {hints}};
+    if (hints->event_fd < 0 || epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD,
+        hints->event_fd, &event) < 0) {
+        perror("eventfd");
+        return FALSE;
+    }
+    pthread_mutex_init(&hints->lock, NULL);
+    pthread_cond_init(&hints->queued, NULL);
+    if (pthread_create(&hints->thread, NULL, server_hint_worker, 
+        hints) != 0) {
+        fprintf(stderr, "Could not start the hint worker\n");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+//waits for the hint being searched, if any, and stops the worker
+void server_stop_hints(struct server *server) {
+
+    struct server_hints *hints = &server->hints;
+    pthread_mutex_lock(&hints->lock);
+    hints->stopping = TRUE;
+    pthread_cond_signal(&hints->queued);
+    pthread_mutex_unlock(&hints->lock);
+    pthread_join(hints->thread, NULL);
+    close(hints->event_fd);
+}
+
+//hands a slot whose statement stopped for a hint to the worker, along with
+//a copy of its game, since a level's scratch session is reused meanwhile
+void server_queue_hint(struct server *server, struct server_slot *slot,
+    struct session *session) {
+
+    struct server_hints *hints = &server->hints;
+    slot->hint_state = malloc(sizeof(struct game_state));
+    if (slot->hint_state == NULL) {
+        //without memory for the copy the hint is searched here instead
+        slot->hint.wanted = FALSE;
+        engine_hint(&session->state, &slot->hint.result);
+        slot->hint.ready = TRUE;
+        slot->held_back = TRUE;
+        return;
+    }
+    *slot->hint_state = session->state;
+    slot->hint.wanted = FALSE;
+    slot->hint_queued = TRUE;
+    //the hint turn's latency includes its search and any wait for it
+    slot->runnable_ns = monotonic_ns();
+    slot->next_hint = NULL;
+
+    pthread_mutex_lock(&hints->lock);
+    if (hints->queue_tail == NULL) {
+        hints->queue_head = slot;
+    } else {
+        hints->queue_tail->next_hint = slot;
+    }
+    hints->queue_tail = slot;
+    pthread_cond_signal(&hints->queued);
+    pthread_mutex_unlock(&hints->lock);
+}
+
+//searches queued hints one at a time, engine_hint already uses every core,
+//each is searched from the game as its hint turn leaves it
+void *server_hint_worker(void *arg) {
+
+    struct server_hints *hints = arg;
+    pthread_mutex_lock(&hints->lock);
+    while (!hints->stopping) {
+        struct server_slot *slot = hints->queue_head;
+        if (slot == NULL) {
+            pthread_cond_wait(&hints->queued, &hints->lock);
+            continue;
+        }
+        hints->queue_head = slot->next_hint;
+        if (hints->queue_head == NULL) {
+            hints->queue_tail = NULL;
+        }
+        pthread_mutex_unlock(&hints->lock);
+
+        engine_step(slot->hint_state, slot->hint.command);
+        engine_hint(slot->hint_state, &slot->hint.result);
+
+        pthread_mutex_lock(&hints->lock);
+        slot->next_hint = hints->done;
+        hints->done = slot;
+        uint64_t one = 1;
+        ssize_t ignored = write(hints->event_fd, &one, sizeof(one));
+        (void) ignored;
+    }
+    pthread_mutex_unlock(&hints->lock);
+    return NULL;
+}
+
+//picks up every hint the worker has finished and lets its statement go on
+void server_finish_hints(struct server *server) {
+
+    struct server_hints *hints = &server->hints;
+    uint64_t count;
+    ssize_t ignored = read(hints->event_fd, &count, sizeof(count));
+    (void) ignored;
+
+    pthread_mutex_lock(&hints->lock);
+    struct server_slot *done = hints->done;
+    hints->done = NULL;
+    pthread_mutex_unlock(&hints->lock);
+
+    while (done != NULL) {
+        struct server_slot *slot = done;
+        done = slot->next_hint;
+        slot->hint_queued = FALSE;
+        free(slot->hint_state);
+        slot->hint_state = NULL;
+        if (slot->fd < 0) {
+            server_free_slot(server, slot);
+            continue;
+        }
+        slot->hint.ready = TRUE;
+        server_play_statements(server, slot);
+        server_update_interest(server, slot);
+    }
+}
+
+/*
+==============================================================================
+============================== END HINT SECTION ==============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+========================== START STATISTICS SECTION ==========================
+==============================================================================
+*/
+
+//keeps the time-weighted session count and prints reports when they are due
+void server_tick(struct server *server) {
+
+    long long now_ns = monotonic_ns();
+    server->session_seconds += (double) server->active * 
+        (now_ns - server->last_tick_ns) / NS_PER_SEC;
+    server->last_tick_ns = now_ns;
+
+    if (server_reload_requested) {
+        server_reload_requested = FALSE;
+        server_reload(server);
+    }
+    if (server_report_requested || 
+        now_ns - server->last_report_ns >= SERVER_REPORT_SECONDS * NS_PER_SEC) {
+        server_report_requested = FALSE;
+        server_report(server);
+    }
+}
+
+//gives new clients the level file as it is now, a level that won't load
+//leaves the old one in place
+void server_reload(struct server *server) {
+
+    if (server->level == NULL) {
+        return;
+    }
+    struct level *level = level_load(server->level_path);
+    if (level != NULL) {
+        level_release(server->level);
+        server->level = level;
+    }
+}
+
+//prints session counts, turn latency percentiles and the CPU used since the
+//last report, sessions per core is how many sessions playing like the
+//current ones one core could keep up with
+void server_report(struct server *server) {
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double cpu_seconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + 
+        (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+
+    long long now_ns = monotonic_ns();
+    double wall_seconds = (double)(now_ns - server->last_report_ns) / 
+        NS_PER_SEC;
+    double cores_used = 0;
+    double average_sessions = 0;
+    if (wall_seconds > 0) {
+        cores_used = (cpu_seconds - server->last_cpu_seconds) / wall_seconds;
+        average_sessions = (server->session_seconds - 
+            server->last_session_seconds) / wall_seconds;
+    }
+    server->last_report_ns = now_ns;
+    server->last_cpu_seconds = cpu_seconds;
+    server->last_session_seconds = server->session_seconds;
+
+    struct latency_histogram *latency = &server->turn_latency;
+    fprintf(stderr, "--- Server Statistics ---\n");
+    fprintf(stderr, "Sessions: %d active, %d peak, %lld served, "
+        "%lld rejected\n", server->active, server->peak, server->served,
+        server->rejected);
+    if (server->level != NULL) {
+        print_level_memory(server);
+    }
+    fprintf(stderr, "Turns: %lld, latency p50 %.1fus, p99 %.1fus, "
+        "p99.9 %.1fus, max %.1fus\n", server->turns,
+        latency_percentile(latency, 50) / 1e3,
+        latency_percentile(latency, 99) / 1e3,
+        latency_percentile(latency, 99.9) / 1e3, latency->max_ns / 1e3);
+    fprintf(stderr, "CPU: %.1f%% of a core over the last %.1fs",
+        cores_used * 100, wall_seconds);
+    if (cores_used >= SERVER_MIN_CORE_USE) {
+        fprintf(stderr, ", %.1f sessions on average, about %.0f sessions "
+            "per core\n", average_sessions, average_sessions / cores_used);
+    } else {
+        fprintf(stderr, "\n");
+    }
+#ifdef CAVERUN_PROFILE
+    print_profile(stderr);
+#endif
+}
+
+//how much memory the games on levels hold between them, next to the one
+//copy of the current level they share
+void print_level_memory(struct server *server) {
+
+    long long changes = 0;
+    long long bytes = 0;
+    int playing = 0;
+    for (int i = 0; i < server->max_sessions; i++) {
+        struct level_overlay *overlay = &server->slots[i].overlay;
+        if (server->slots[i].fd >= 0) {
+            changes += overlay->change_count;
+            bytes += sizeof(*overlay) +
+                overlay->change_capacity * sizeof(struct level_change);
+            playing++;
+        }
+    }
+    fprintf(stderr, "Level: %lld changed tile(s) over %d session(s), "
+        "%.1f KiB per session, %.1f KiB shared\n", changes, playing,
+        playing > 0 ? (double) bytes / playing / 1024 : 0.0,
+        (double) sizeof(struct level) / 1024);
+}
+
+/*
+==============================================================================
+=========================== END STATISTICS SECTION ===========================
+==============================================================================
+*/
@@ -0,0 +1,29 @@
+// caverun_server.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Hosts many games of CS Caverun in one process>
+
+/*
+Overview: The server accepts connections on a local TCP port or Unix socket
+and plays an independent game over each one, speaking exactly the same text
+protocol as the console game. All sessions live in a pool allocated once at
+startup and are driven by a single epoll loop, so the server never blocks on
+a slow client. With a level file every client plays that level, sharing
+one copy of it.
+*/
+
+#ifndef CAVERUN_SERVER_H
+#define CAVERUN_SERVER_H
+
+#define SERVER_DEFAULT_SESSIONS  256
+
+struct server_options {
+    int port;
+    const char *unix_path;
+    int max_sessions;
+    const char *level_path;
+};
+
+int server_run(struct server_options *options);
+
+#endif
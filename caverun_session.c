@@ -0,0 +1,1086 @@
+// caverun_session.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <The CS Caverun text protocol, shared by every front-end>
+
+/*
+Overview: This file turns raw input bytes into engine calls and engine events
+into text. Each statement (the starting position, one map feature or one
+gameplay command with its arguments) is only executed once all of its tokens
+have arrived, so a session can be fed a byte at a time from a socket and
+still behave exactly like the scanf-driven console game. Every message and
+board is printed to the session's own output stream.
+*/
+
+#include <ctype.h>
+#include <string.h>
+
+#include "caverun_broadcast.h"
+#include "caverun_frames.h"
+#include "caverun_journal.h"
+#include "caverun_latency.h"
+#include "caverun_pipeline.h"
+#include "caverun_profile.h"
+#include "caverun_session.h"
+
+//one row of a printed board, "|" and three characters a tile, "|" and "\n"
+#define BOARD_TEXT_WIDTH  (4 * COLS + 2)
+
+int session_position_statement(struct session *session,
+    struct scanner *scanner);
+int session_feature_statement(struct session *session,
+    struct scanner *scanner);
+int session_gameplay_statement(struct session *session,
+    struct scanner *scanner);
+void session_queue_feature(struct session *session, char instruction,
+    int values[4]);
+void session_place_features(struct session *session);
+void session_play(struct session *session, struct command command,
+    long long start_ns);
+int session_end_turn(struct session *session, struct command command,
+    int events, int lives);
+int session_define_macro(struct session *session, struct scanner *scanner);
+void session_run_macro(struct session *session, char name);
+struct session_macro *session_find_macro(struct session *session, char name);
+void session_end_batch(struct session *session);
+int session_turn_ready(struct session *session, struct command command);
+int session_render_due(struct session *session, int events, int lives);
+void session_start_gameplay(struct session *session);
+void print_placement_error(FILE *out, enum placement placement);
+void print_placement_summary(FILE *out, struct placement_summary *summary);
+void static_instructions(struct session *session, char instruction);
+void print_hit_events(struct session *session, int events);
+void print_hint(struct session *session);
+
+struct session_rules session_rules = {FALSE, 0, 0, FALSE, FALSE, FALSE};
+
+//how print_board shows every entity but the player on a tile without lava
+const char tile_text[PLAYER][4] = {
+    [EMPTY] = "   ",
+    [DIRT] = " . ",
+    [WALL] = "|||",
+    [BOULDER] = "(O)",
+    [GEM] = "*^*",
+    [EXIT_LOCKED] = "[X]",
+    [EXIT_UNLOCKED] = "[ ]",
+    [HIDDEN] = " X "
+};
+
+/*
+==============================================================================
+============================ START SESSION SECTION ===========================
+==============================================================================
+*/
+
+//starts a new game, printing the welcome and the first setup prompt, a
+//NULL out plays the game quietly without printing anything, and the game
+//is only journalled, pipelined, published to a frame ring or broadcast once
+//the caller sets session->journal, pipeline, frames or broadcast, features
+//are placed in bulk with one summary once it sets session->occupancy
+void session_begin(struct session *session, FILE *out) {
+
+    session->out = out;
+    session->journal = NULL;
+    session->pipeline = NULL;
+    session->frames = NULL;
+    session->broadcast = NULL;
+    session->occupancy = NULL;
+    session->bulk_count = 0;
+    memset(&session->bulk_summary, 0, sizeof(session->bulk_summary));
+    session->phase = PHASE_PLAYER_POSITION;
+    session->statements = 0;
+    session->turns = 0;
+    session->last_events = EVENT_NONE;
+    session->macro_count = 0;
+    session->batch_depth = 0;
+    session->render_pending = FALSE;
+    session->batch_interrupted = FALSE;
+    session->rendered_turn = 0;
+    session->rendered_ns = 0;
+    session->frame_skipped = FALSE;
+    session->locked_exits = 0;
+    session->out_limit = 0;
+    session->stopped = FALSE;
+    session->statement_turn = 0;
+    session->resume_turn = 0;
+    session->turn_limit = 0;
+    session->slice_turns = 0;
+    session->hint = NULL;
+    session->latency = NULL;
+    session->runnable_ns = 0;
+    session->lava_ahead.generations = 0;
+    initialise_board(session->game_board);
+    engine_initialise(&session->state);
+    engine_settle_boulders(&session->state, session_rules.settle);
+    engine_shadowcast(&session->state, session_rules.shadowcast);
+
+    if (out != NULL) {
+        fprintf(out, "Welcome to CS Caverun!\n\n");
+        fprintf(out, "--- Game Setup Phase ---\n");
+        fprintf(out, "Enter the player's starting position: ");
+    }
+}
+
+//executes at most one complete statement from the start of the data and
+//returns how many bytes it used, 0 means more input is needed, or that the
+//statement stopped for room in out when session->stopped is set
+int session_step(struct session *session, const char *data, int length,
+    int at_eof) {
+
+    struct scanner scanner = {data, length, 0, at_eof};
+
+    //whitespace between statements is used up even without a statement
+    if (!skip_whitespace(&scanner) || session->phase == PHASE_OVER) {
+        return scanner.position;
+    }
+
+    int complete = FALSE;
+    if (session->phase == PHASE_PLAYER_POSITION) {
+        complete = session_position_statement(session, &scanner);
+    } else if (session->phase == PHASE_FEATURES) {
+        complete = session_feature_statement(session, &scanner);
+    } else if (session->phase == PHASE_GAMEPLAY) {
+        session->stopped = FALSE;
+        session->statement_turn = 0;
+        complete = session_gameplay_statement(session, &scanner);
+    }
+
+    if (!complete) {
+        return 0;
+    } else if (session->stopped) {
+        //played again from the start once there is room, up to here
+        session->resume_turn = session->statement_turn;
+        return 0;
+    }
+    session->resume_turn = 0;
+    session->statements++;
+    return scanner.position;
+}
+
+//input has ended, setup is finished with whatever was entered so far
+void session_finish(struct session *session) {
+
+    if (session->phase == PHASE_FEATURES) {
+        session_start_gameplay(session);
+    } else if (session->phase == PHASE_GAMEPLAY && session->frame_skipped &&
+        session->out != NULL) {
+        //the last board skipped by the render rules is still shown
+        print_correct_board(session);
+    }
+    session->phase = PHASE_OVER;
+}
+
+//reads the player's starting position, asking again if it is invalid
+int session_position_statement(struct session *session,
+    struct scanner *scanner) {
+
+    int row = INVALID_ROW;
+    int col = INVALID_COL;
+
+    enum scan_result result = scan_int(scanner, &row);
+    if (result == SCAN_FAIL) {
+        //scanf would get stuck on this forever, so it is skipped instead
+        scanner->position++;
+        return TRUE;
+    } else if (result == SCAN_OK) {
+        result = scan_int(scanner, &col);
+    }
+    if (result == SCAN_MORE) {
+        return FALSE;
+    }
+
+    enum placement placement = engine_place_player(&session->state, row, col);
+    if (placement == PLACEMENT_OK) {
+        session->phase = PHASE_FEATURES;
+        if (session->journal != NULL) {
+            journal_player(session->journal, row, col);
+        }
+        if (session->occupancy != NULL) {
+            occupancy_build(session->occupancy, session->state.board);
+        }
+    }
+    if (session->out == NULL) {
+        return TRUE;
+    } else if (placement != PLACEMENT_OK) {
+        fprintf(session->out, "Position %d %d is invalid!\n", row, col);
+        fprintf(session->out, "Enter the player's starting position: ");
+    } else {
+        print_board(session->out, session->state.board, INITIAL_LIVES);
+        fprintf(session->out, "Enter map features:\n");
+    }
+    return TRUE;
+}
+
+//reads one map feature, or the start of the game
+int session_feature_statement(struct session *session,
+    struct scanner *scanner) {
+
+    char instruction;
+    int values[4] = {INVALID_ROW, INVALID_COL, INVALID_ROW, INVALID_COL};
+    int value_count = 0;
+
+    if (scan_char(scanner, &instruction) != SCAN_OK) {
+        return FALSE;
+    }
+    if (instruction == PLACE_WALL || instruction == PLACE_BOULDER || 
+        instruction == PLACE_GEM || instruction == PLACE_LAVA ||
+        instruction == PLACE_EXIT) {
+        //single-tile features default to the top left, like the original
+        values[0] = 0;
+        values[1] = 0;
+        value_count = 2;
+    } else if (instruction == PLACE_GROUPED_WALLS) {
+        value_count = 4;
+    }
+
+    //like scanf, reading stops at the first value that isn't a number
+    enum scan_result result = SCAN_OK;
+    for (int i = 0; i < value_count && result == SCAN_OK; i++) {
+        result = scan_int(scanner, &values[i]);
+    }
+    if (result == SCAN_MORE) {
+        return FALSE;
+    }
+
+    enum placement placement = PLACEMENT_OK;
+    if (instruction == START) {
+        session_start_gameplay(session);
+    } else if (value_count > 0 && session->occupancy != NULL) {
+        session_queue_feature(session, instruction, values);
+    } else if (instruction == PLACE_GROUPED_WALLS) {
+        placement = engine_place_grouped_walls(&session->state, values[0], 
+            values[1], values[2], values[3]);
+        if (placement != PLACEMENT_OK && session->out != NULL) {
+            fprintf(session->out, 
+                "Invalid location: feature cannot be placed here!\n");
+        } else if (placement == PLACEMENT_OK && session->journal != NULL) {
+            journal_grouped_walls(session->journal, values[0], values[1],
+                values[2], values[3]);
+        }
+    } else if (value_count > 0) {
+        placement = engine_place_feature(&session->state, instruction, 
+            values[0], values[1]);
+        print_placement_error(session->out, placement);
+        if (placement == PLACEMENT_OK && session->journal != NULL) {
+            journal_feature(session->journal, instruction, values[0],
+                values[1]);
+        }
+    }
+    return TRUE;
+}
+
+//adds a feature to the batch being built, placing the batch once it's full
+void session_queue_feature(struct session *session, char instruction,
+    int values[4]) {
+
+    struct placement_request *request = &session->bulk[session->bulk_count++];
+    request->instruction = instruction;
+    request->start_row = values[0];
+    request->start_col = values[1];
+    request->end_row = values[2];
+    request->end_col = values[3];
+    if (session->bulk_count == SESSION_BULK_SIZE) {
+        session_place_features(session);
+    }
+}
+
+//places every feature in the batch, in order, journalling the ones placed
+void session_place_features(struct session *session) {
+
+    engine_place_features(&session->state, session->occupancy, session->bulk,
+        session->bulk_count, &session->bulk_summary);
+    for (int i = 0; i < session->bulk_count && session->journal != NULL;
+        i++) {
+        struct placement_request *request = &session->bulk[i];
+        if (request->result != PLACEMENT_OK) {
+            continue;
+        } else if (request->instruction == PLACE_GROUPED_WALLS) {
+            journal_grouped_walls(session->journal, request->start_row,
+                request->start_col, request->end_row, request->end_col);
+        } else {
+            journal_feature(session->journal, request->instruction,
+                request->start_row, request->start_col);
+        }
+    }
+    session->bulk_count = 0;
+}
+
+//reads and plays one gameplay command along with its arguments, a count
+//in front of it or a macro plays as a batch rendered once
+int session_gameplay_statement(struct session *session,
+    struct scanner *scanner) {
+
+    struct game_status *status = &session->state.status;
+    struct command command;
+    enum scan_result result = SCAN_OK;
+    int count = 1;
+    //the first turn's span opens before its command is read, so the parse
+    //lies inside the turn it belongs to
+    PROFILE_START(turn_timer);
+    PROFILE_START(parse_timer);
+
+    if (skip_whitespace(scanner) && 
+        isdigit((unsigned char) scanner->data[scanner->position]) &&
+        scan_int(scanner, &count) == SCAN_MORE) {
+        return FALSE;
+    }
+    if (scan_char(scanner, &command.instruction) != SCAN_OK) {
+        return FALSE;
+    }
+    if (command.instruction == MACRO_DEFINE) {
+        return session_define_macro(session, scanner);
+    }
+    //arguments that fail to read keep their current value
+    command.instruction2 = 0;
+    command.radius = status->illumination_radius;
+
+    if (command.instruction == ILLUMINATE) {
+        result = scan_int(scanner, &command.radius);
+    } else if (command.instruction == GRAVITY) {
+        command.instruction2 = status->gravity;
+        result = scan_char(scanner, &command.instruction2);
+    } else if ((isupper(command.instruction) && 
+        command.instruction != LAVA_TRIGGER) || 
+        command.instruction == MACRO_RUN) {
+        result = scan_char(scanner, &command.instruction2);
+    }
+    if (result == SCAN_MORE) {
+        return FALSE;
+    }
+    PROFILE_STOP(parse_timer, TIMER_PARSE);
+
+    if (count > SESSION_MAX_COUNT) {
+        count = SESSION_MAX_COUNT;
+    }
+    int batch = count > 1 || command.instruction == MACRO_RUN;
+    if (batch) {
+        session->batch_depth++;
+    }
+    for (int i = 0; i < count && !session->batch_interrupted && 
+        !session->stopped && session->phase != PHASE_OVER; i++) {
+        if (command.instruction == MACRO_RUN) {
+            session_run_macro(session, command.instruction2);
+        } else if (session_turn_ready(session, command)) {
+            session_play(session, command, turn_timer);
+            turn_timer = 0;
+        }
+    }
+    if (batch) {
+        session_end_batch(session);
+    }
+    return TRUE;
+}
+
+//plays one turn, holding back the board while in the middle of a batch
+//unless something happened the player must see straight away, the turn's
+//span starting at start_ns if it is set or else now
+void session_play(struct session *session, struct command command,
+    long long start_ns) {
+
+    PROFILE_START(turn_timer);
+    if (start_ns != 0) {
+        turn_timer = start_ns;
+    }
+    int lives = session->state.status.lives;
+    lava_ahead_active = &session->lava_ahead;
+    int events = engine_step(&session->state, command);
+    lava_ahead_active = NULL;
+    if (session->journal != NULL) {
+        journal_turn(session->journal, command, &session->state);
+    }
+    events = session_end_turn(session, command, events, lives);
+    PROFILE_STOP(turn_timer, TIMER_TURN);
+    if (trace_active) {
+        trace_annotate_turn(command, engine_lava_cells(&session->state));
+    }
+    if (events & EVENT_GAME_OVER) {
+        session->phase = PHASE_OVER;
+    }
+}
+
+//lets the cave move on one turn without a command from the player, for a
+//real-time tick with no key pressed
+void session_tick(struct session *session) {
+
+    struct command none = {0, 0, 0};
+    PROFILE_START(turn_timer);
+    int lives = session->state.status.lives;
+    lava_ahead_active = &session->lava_ahead;
+    int events = engine_tick(&session->state);
+    lava_ahead_active = NULL;
+    if (session->journal != NULL) {
+        journal_tick(session->journal, &session->state);
+    }
+    events = session_end_turn(session, none, events, lives);
+    PROFILE_STOP(turn_timer, TIMER_TURN);
+    if (trace_active) {
+        trace_annotate_turn(none, engine_lava_cells(&session->state));
+    }
+    if (events & EVENT_GAME_OVER) {
+        session->phase = PHASE_OVER;
+    }
+}
+
+//counts a turn that has been played and prints what happened in it, the
+//board only if the render rules and any batch it is in allow, returns the
+//events that were acted on
+int session_end_turn(struct session *session, struct command command,
+    int events, int lives) {
+
+    session->turns++;
+    session->last_events = events;
+    if (session->latency != NULL) {
+        latency_record(session->latency,
+            monotonic_ns() - session->runnable_ns);
+    }
+    if ((events & EVENT_RENDER) && !session_render_due(session, events, 
+        lives)) {
+        events &= ~EVENT_RENDER;
+    }
+    if (session->batch_depth > 0 && (events & SESSION_INTERRUPTS)) {
+        session->batch_interrupted = TRUE;
+        session->render_pending = FALSE;
+    } else if (session->batch_depth > 0 && (events & EVENT_RENDER)) {
+        session->render_pending = TRUE;
+        events &= ~EVENT_RENDER;
+    }
+    if (session->out != NULL) {
+        print_step_events(session, command, events);
+    }
+    return events;
+}
+
+//reads a macro definition such as "{r dddW s}" after its opening brace
+int session_define_macro(struct session *session, struct scanner *scanner) {
+
+    char name;
+    enum scan_result result = scan_char(scanner, &name);
+    if (result != SCAN_OK) {
+        return result == SCAN_FAIL;
+    }
+    int body_start = scanner->position;
+    while (scanner->position < scanner->length && 
+        scanner->data[scanner->position] != MACRO_END) {
+        scanner->position++;
+    }
+    if (scanner->position == scanner->length && !scanner->at_eof) {
+        return FALSE;
+    }
+    int body_length = scanner->position - body_start;
+    if (scanner->position < scanner->length) {
+        scanner->position++;
+    }
+
+    struct session_macro *macro = session_find_macro(session, name);
+    if (macro == NULL && session->macro_count < SESSION_MACROS) {
+        macro = &session->macros[session->macro_count];
+        session->macro_count++;
+    }
+    if (macro == NULL || body_length >= SESSION_MACRO_LENGTH) {
+        if (session->out != NULL) {
+            fprintf(session->out, "Macro %c can't be defined!\n", name);
+        }
+        return TRUE;
+    }
+    macro->name = name;
+    memcpy(macro->body, scanner->data + body_start, body_length);
+    macro->body[body_length] = '\0';
+    return TRUE;
+}
+
+//plays every statement of a macro as part of the current batch
+void session_run_macro(struct session *session, char name) {
+
+    struct session_macro *macro = session_find_macro(session, name);
+    if (macro == NULL || session->batch_depth > SESSION_MACRO_DEPTH) {
+        if (session->out != NULL) {
+            fprintf(session->out, "Macro %c can't be played!\n", name);
+        }
+        session->batch_interrupted = TRUE;
+        return;
+    }
+    struct scanner scanner = {macro->body, strlen(macro->body), 0, TRUE};
+    while (skip_whitespace(&scanner) && !session->batch_interrupted &&
+        !session->stopped && session->phase != PHASE_OVER) {
+        int position = scanner.position;
+        //a definition inside a macro would replace the body being read
+        if (scanner.data[position] == MACRO_DEFINE || 
+            !session_gameplay_statement(session, &scanner) ||
+            scanner.position == position) {
+            break;
+        }
+    }
+}
+
+struct session_macro *session_find_macro(struct session *session, char name) {
+
+    for (int i = 0; i < session->macro_count; i++) {
+        if (session->macros[i].name == name) {
+            return &session->macros[i];
+        }
+    }
+    return NULL;
+}
+
+//decides whether a statement plays its next turn now, skipping the turns
+//it played before it last stopped, and stopping it once out has no room,
+//the caller's slice of turns is used up or a hint has to be searched first
+int session_turn_ready(struct session *session, struct command command) {
+
+    if (session->statement_turn < session->resume_turn) {
+        session->statement_turn++;
+        return FALSE;
+    } else if (session->out_limit > 0 && session->out != NULL &&
+        ftell(session->out) > session->out_limit) {
+        session->stopped = TRUE;
+        return FALSE;
+    } else if (session->turn_limit > 0 &&
+        session->slice_turns >= session->turn_limit) {
+        session->stopped = TRUE;
+        return FALSE;
+    } else if (command.instruction == HINT && session->hint != NULL &&
+        !session->hint->ready) {
+        //searched from the game as it is before this turn is played
+        session->hint->wanted = TRUE;
+        session->hint->command = command;
+        session->stopped = TRUE;
+        return FALSE;
+    }
+    session->statement_turn++;
+    session->slice_turns++;
+    return TRUE;
+}
+
+//finishes a batch, printing the board it held back once the outermost
+//batch is over
+void session_end_batch(struct session *session) {
+
+    session->batch_depth--;
+    if (session->batch_depth > 0 || session->stopped) {
+        //a stopped batch keeps the board it held back for when it goes on
+        return;
+    }
+    if (session->render_pending && session->out != NULL) {
+        print_correct_board(session);
+    }
+    session->render_pending = FALSE;
+    session->batch_interrupted = FALSE;
+}
+
+//decides whether a turn's board is printed under the render rules: always
+//when lives change, exits open or the game ends, otherwise only once the
+//turn or time limit since the last printed board has passed
+int session_render_due(struct session *session, int events, int lives) {
+
+    struct game_state *state = &session->state;
+    if (!session_rules.render_every && !session_rules.render_ms && 
+        !session_rules.render_events) {
+        return TRUE;
+    }
+
+    int locked_exits = session->locked_exits;
+    if (locked_exits > 0) {
+        session->locked_exits = entity_counter(state->board, EXIT_LOCKED);
+    }
+    long long now_ns = session_rules.render_ms ? monotonic_ns() : 0;
+    int due = lives != state->status.lives || 
+        session->locked_exits < locked_exits || 
+        (events & (EVENT_WIN | EVENT_LOST | EVENT_GAME_OVER));
+    if (session_rules.render_every && 
+        session->turns - session->rendered_turn >= session_rules.render_every) {
+        due = TRUE;
+    }
+    if (session_rules.render_ms && 
+        now_ns - session->rendered_ns >= session_rules.render_ms * NS_PER_MS) {
+        due = TRUE;
+    }
+
+    if (due) {
+        session->rendered_turn = session->turns;
+        session->rendered_ns = now_ns;
+    }
+    session->frame_skipped = !due;
+    return due;
+}
+
+//finishes setup and moves on to the gameplay phase
+void session_start_gameplay(struct session *session) {
+
+    if (session->occupancy != NULL) {
+        session_place_features(session);
+        if (session->out != NULL) {
+            print_placement_summary(session->out, &session->bulk_summary);
+        }
+    }
+    engine_start(&session->state);
+    session->phase = PHASE_GAMEPLAY;
+    session->locked_exits = entity_counter(session->state.board, EXIT_LOCKED);
+    if (session->journal != NULL) {
+        journal_start(session->journal, &session->state);
+    }
+    if (session->out != NULL) {
+        print_board(session->out, session->state.board, INITIAL_LIVES);
+        fprintf(session->out, "--- Gameplay Phase ---\n"); 
+    }
+}
+
+//explains why a single-tile feature couldn't be placed
+void print_placement_error(FILE *out, enum placement placement) {
+
+    if (out == NULL) {
+        return;
+    } else if (placement == PLACEMENT_OFF_MAP) {
+        fprintf(out, "Invalid location: position is not on map!\n");
+    } else if (placement == PLACEMENT_OCCUPIED) {
+        fprintf(out, "Invalid location: tile is occupied!\n");
+    }
+}
+
+//reports a whole setup's rejected features at once instead of one by one
+void print_placement_summary(FILE *out, struct placement_summary *summary) {
+
+    int placed = summary->results[PLACEMENT_OK];
+    fprintf(out, "Placed %d of %d feature(s)", placed, summary->requests);
+    if (placed < summary->requests) {
+        fprintf(out, ", %d not on map, %d on occupied tiles",
+            summary->results[PLACEMENT_OFF_MAP],
+            summary->results[PLACEMENT_OCCUPIED]);
+    }
+    fprintf(out, "\n");
+}
+
+/*
+==============================================================================
+============================= END SESSION SECTION ============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+============================ START SCANNER SECTION ===========================
+==============================================================================
+*/
+
+//skips whitespace, returns FALSE if the data ran out before anything else
+int skip_whitespace(struct scanner *scanner) {
+
+    while (scanner->position < scanner->length && 
+        isspace((unsigned char) scanner->data[scanner->position])) {
+        scanner->position++;
+    }
+    return scanner->position < scanner->length;
+}
+
+//reads the next non-whitespace character, like scanf(" %c")
+enum scan_result scan_char(struct scanner *scanner, char *c) {
+
+    if (!skip_whitespace(scanner)) {
+        return scanner->at_eof ? SCAN_FAIL : SCAN_MORE;
+    }
+    *c = scanner->data[scanner->position];
+    scanner->position++;
+    return SCAN_OK;
+}
+
+//reads a signed decimal number, like scanf("%d"), leaving anything that
+//isn't a number unread
+enum scan_result scan_int(struct scanner *scanner, int *value) {
+
+    if (!skip_whitespace(scanner)) {
+        return scanner->at_eof ? SCAN_FAIL : SCAN_MORE;
+    }
+
+    int position = scanner->position;
+    int sign = 1;
+    if (scanner->data[position] == '-' || scanner->data[position] == '+') {
+        if (scanner->data[position] == '-') {
+            sign = -1;
+        }
+        position++;
+    }
+
+    int digits = 0;
+    long number = 0;
+    while (position < scanner->length && 
+        isdigit((unsigned char) scanner->data[position])) {
+        //a number past SESSION_MAX_COUNT is already more than any count,
+        //position or radius can use, so it stops growing once past it
+        if (number <= SESSION_MAX_COUNT) {
+            number = number * 10 + (scanner->data[position] - '0');
+        }
+        position++;
+        digits++;
+    }
+    //the number might carry on in input that hasn't arrived yet
+    if (position == scanner->length && !scanner->at_eof) {
+        return SCAN_MORE;
+    } else if (digits == 0) {
+        return SCAN_FAIL;
+    }
+    *value = (int)(sign * number);
+    scanner->position = position;
+    return SCAN_OK;
+}
+
+/*
+==============================================================================
+============================= END SCANNER SECTION ============================
+==============================================================================
+*/
+
+/*
+==============================================================================
+============================= START OUTPUT SECTION ===========================
+==============================================================================
+*/
+
+//prints every message for the events of a step, then the board if needed
+void print_step_events(struct session *session, struct command command,
+    int events) {
+
+    struct game_state *state = &session->state;
+    FILE *out = session->out;
+
+    if (events & EVENT_GAME_OF_LAVA) {
+        fprintf(out, "Game Of Lava: Activated\n");
+    } else if (events & EVENT_LAVA_SEEDS) {
+        fprintf(out, "Lava Seeds: Activated\n");
+    }
+
+    if (events & EVENT_ILLUMINATION_ON) {
+        fprintf(out, "Illumination Mode: Activated\n");
+    } else if (events & EVENT_ILLUMINATION_OFF) {
+        fprintf(out, "Illumination Mode: Deactivated\n");
+    } else if (events & EVENT_SHADOW_ON) {
+        fprintf(out, "Shadow Mode: Activated\n");
+    } else if (events & EVENT_SHADOW_OFF) {
+        fprintf(out, "Shadow Mode: Deactivated\n");
+    } else if (events & EVENT_GRAVITY) {
+        print_gravity_direction(out, &state->status);
+    } else if (events & EVENT_OUT_OF_BREATH) {
+        fprintf(out, "You're out of breath! Skipping dash move...\n");
+    }
+    static_instructions(session, command.instruction);
+
+    if (events & EVENT_WIN) {
+        print_board(out, state->board, state->status.lives);
+        fprintf(out, "You Win! Final Score: %d point(s)!\n",
+            state->status.score);
+    }
+    print_hit_events(session, events);
+    if (events & EVENT_RENDER) {
+        print_correct_board(session);
+    }
+}
+
+//handles all static instructions
+void static_instructions(struct session *session, char instruction) {
+
+    struct game_state *state = &session->state;
+    FILE *out = session->out;
+
+    if (instruction == QUIT) {
+        fprintf(out, "--- Quitting Game ---\n");
+    } else if (instruction == PRINT_SCORE) {
+        fprintf(out, "You have %d point(s)!\n", engine_score(state));
+    } else if (instruction == PRINT_MAP_STATS) {
+        struct map_statistics statistics;
+        engine_map_statistics(state, &statistics);
+
+        print_map_statistics(out, statistics.dirt, statistics.gems, 
+        statistics.boulders, statistics.completion_percentage, 
+        statistics.maximum_points_remaining);
+    } else if (instruction == HINT) {
+        print_hint(session);
+    } else if (instruction == PRINT_PROFILE) {
+        print_profile(out);
+    }
+}
+
+//prints the respawn and ending messages for boulder and lava hits
+void print_hit_events(struct session *session, int events) {
+
+    struct game_state *state = &session->state;
+    FILE *out = session->out;
+
+    if (events & EVENT_BOULDER_RESPAWN) {
+        fprintf(out, "Respawning!\n");
+    }
+    if (events & EVENT_LAVA_RESPAWN) {
+        fprintf(out, "Respawning!\n");
+    }
+
+    if (events & EVENT_LOST) {
+        fprintf(out, "Game Lost! You scored %d points!\n", state->status.score);
+    } else if (events & EVENT_RESPAWN_BLOCKED && 
+        state->status.lava_mode == LAVA_NONE) {
+        fprintf(out, "Respawn blocked! Game over. Final score: %d points.\n", 
+            state->status.score);
+    } else if (events & EVENT_RESPAWN_BLOCKED) {
+        fprintf(out, "Respawn blocked! You're toast! Final score: %d points.\n",
+            state->status.score);
+    }
+}
+
+//searches for the best line of play and prints it with search statistics
+void print_hint(struct session *session) {
+
+    FILE *out = session->out;
+    struct hint_result result;
+    if (session->hint != NULL && session->hint->ready) {
+        result = session->hint->result;
+        session->hint->ready = FALSE;
+    } else {
+        engine_hint(&session->state, &result);
+    }
+
+    if (result.length == 0) {
+        fprintf(out, "Hint: no move available!\n");
+    } else {
+        fprintf(out, "Hint:");
+        for (int i = 0; i < result.length; i++) {
+            if (i > 0) {
+                fprintf(out, ",");
+            }
+            if (result.line[i].instruction2 == 0) {
+                fprintf(out, " %c", result.line[i].instruction);
+            } else {
+                fprintf(out, " %c %c", result.line[i].instruction, 
+                    result.line[i].instruction2);
+            }
+        }
+        if (result.line_end.game_won) {
+            fprintf(out, " (reaches the exit with %d point(s))\n", 
+                result.line_end.score);
+        } else if (result.line_end.game_over) {
+            fprintf(out, " (no safe line found)\n");
+        } else {
+            fprintf(out, " (%d point(s), %d li%s left)\n",
+                result.line_end.score, result.line_end.lives,
+                result.line_end.lives == 1 ? "fe" : "ves");
+        }
+    }
+    fprintf(out, "Searched depth %d: %lld nodes in %.3fs (%.0f nodes/sec, "
+        "%d thread(s))\n", result.depth, result.nodes, result.seconds, 
+        result.seconds > 0 ? result.nodes / result.seconds : 0.0, 
+        result.thread_count);
+}
+
+//prints either the game or true board depending on illumination mode
+void print_correct_board(struct session *session) {
+    
+    struct game_state *state = &session->state;
+    int visible = compute_visible_board(session->game_board, state);
+    if (session_rules.shadow_check && state->status.shadowed &&
+        !state->status.shadow_entire_board) {
+        print_shadow_conformance(session);
+    }
+
+    PROFILE_START(render_timer);
+    struct tile (*board)[COLS] = visible ? session->game_board : state->board;
+    if (session->frames != NULL) {
+        frame_ring_publish(session->frames, board, &state->status, 
+            session->turns);
+    }
+    if (session->broadcast != NULL) {
+        broadcast_board(session->broadcast, board, &state->status,
+            session->turns);
+    }
+    if (session->pipeline != NULL) {
+        //the render thread formats the board while the next turn is played
+        pipeline_publish(session->pipeline, board, state->status.lives);
+    } else {
+        print_board(session->out, board, state->status.lives);
+    }
+    PROFILE_STOP(render_timer, TIMER_RENDER);
+}
+
+//reports to stderr every tile shadowcast and check_hidden disagree about
+void print_shadow_conformance(struct session *session) {
+
+    static _Thread_local char disagree[ROWS][COLS];
+    struct game_state *state = &session->state;
+
+    if (shadow_conformance(state->board, state->status, disagree) == 0) {
+        return;
+    }
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            if (!disagree[i][j]) {
+                continue;
+            }
+            int hidden = check_hidden(state->board, state->status, i, j);
+            fprintf(stderr, "Turn %d: from (%d, %d) check_hidden has "
+                "(%d, %d) %s but shadowcast has it %s\n", session->turns,
+                state->status.player_row, state->status.player_col, i, j,
+                hidden ? "hidden" : "visible", hidden ? "visible" : "hidden");
+        }
+    }
+}
+
+//prints the latency of every phase of a turn and the work counters
+void print_profile(FILE *out) {
+
+#ifdef CAVERUN_PROFILE
+    fprintf(out, "============== Turn Profile ==============\n");
+    fprintf(out, "%-14s %8s %9s %9s %9s %9s\n", "phase", "count", 
+        "mean(ns)", "p50(ns)", "p99(ns)", "max(ns)");
+    for (int i = 0; i < PROFILE_TIMERS; i++) {
+        struct latency_histogram *timer = &profile.timers[i];
+        fprintf(out, "%-14s %8lld %9lld %9lld %9lld %9lld\n", 
+            PROFILE_TIMER_NAMES[i], timer->total, 
+            timer->total > 0 ? timer->sum_ns / timer->total : 0,
+            latency_percentile(timer, 50), latency_percentile(timer, 99),
+            timer->max_ns);
+    }
+    for (int i = 0; i < PROFILE_COUNTERS; i++) {
+        fprintf(out, "%-18s %lld\n", PROFILE_COUNTER_NAMES[i], 
+            profile.counters[i]);
+    }
+    fprintf(out, "==========================================\n");
+#else
+    fprintf(out, "Profiling is not enabled in this build!\n");
+#endif
+}
+
+//prints messages after gravity direction is changed
+void print_gravity_direction(FILE *out, struct game_status *status) {
+
+    if (status->gravity == GRAVITY_UP) {
+        fprintf(out, "Gravity now pulls UP!\n");
+    } else if (status->gravity == GRAVITY_DOWN) {
+        fprintf(out, "Gravity now pulls DOWN!\n");
+    } else if (status->gravity == GRAVITY_LEFT) {
+        fprintf(out, "Gravity now pulls LEFT!\n");
+    } else if (status->gravity == GRAVITY_RIGHT) {
+        fprintf(out, "Gravity now pulls RIGHT!\n");
+    }
+}
+
+/*
+==============================================================================
+============================== END OUTPUT SECTION ============================
+==============================================================================
+*/
+
+// ===========================================================================
+// Definitions of Provided Functions
+// ===========================================================================
+
+//prints the game board, showing the player's position and lives remaining,
+//each row is put together in a buffer and written at once rather than with
+//a fprintf per tile
+void print_board(FILE *out, struct tile board[ROWS][COLS], 
+    int lives_remaining) {
+
+    char line[BOARD_TEXT_WIDTH];
+    char row_text[BOARD_TEXT_WIDTH];
+    line[0] = '+';
+    for (int col = 0; col < COLS; col++) {
+        memcpy(&line[4 * col + 1], "---+", 4);
+    }
+    line[BOARD_TEXT_WIDTH - 1] = '\n';
+
+    fwrite(line, 1, BOARD_TEXT_WIDTH, out);
+    print_board_header(out, lives_remaining);
+    fwrite(line, 1, BOARD_TEXT_WIDTH, out);
+
+    for (int row = 0; row < ROWS; row++) {
+        for (int col = 0; col < COLS; col++) {
+            struct tile *tile = &board[row][col];
+            const char *text = "   ";
+            if (tile->entity == PLAYER) {
+                text = "^_^";
+            } else if (tile->has_lava) {
+                text = "^^^";
+            } else if (tile->entity >= EMPTY && tile->entity < PLAYER) {
+                text = tile_text[tile->entity];
+            }
+            row_text[4 * col] = '|';
+            memcpy(&row_text[4 * col + 1], text, 3);
+        }
+        row_text[BOARD_TEXT_WIDTH - 2] = '|';
+        row_text[BOARD_TEXT_WIDTH - 1] = '\n';
+        fwrite(row_text, 1, BOARD_TEXT_WIDTH, out);
+        fwrite(line, 1, BOARD_TEXT_WIDTH, out);
+    }
+    fprintf(out, "\n");
+    return;
+}
+
+//the same board printed a tile at a time, as it was provided
+void print_board_scalar(FILE *out, struct tile board[ROWS][COLS], 
+    int lives_remaining) {
+
+    print_board_line(out);
+    print_board_header(out, lives_remaining);
+    print_board_line(out);
+
+    for (int row = 0; row < ROWS; row++) {
+        for (int col = 0; col < COLS; col++) {
+            fprintf(out, "|");
+            if (board[row][col].entity == PLAYER) {
+                fprintf(out, "^_^");
+            } else if (board[row][col].has_lava) {
+                fprintf(out, "^^^");
+            } else if (board[row][col].entity == EMPTY) {
+                fprintf(out, "   ");
+            } else if (board[row][col].entity == DIRT) {
+                fprintf(out, " . ");
+            } else if (board[row][col].entity == WALL) {
+                fprintf(out, "|||");
+            } else if (board[row][col].entity == BOULDER) {
+                fprintf(out, "(O)");
+            } else if (board[row][col].entity == GEM) {
+                fprintf(out, "*^*");
+            } else if (board[row][col].entity == EXIT_LOCKED) {
+                fprintf(out, "[X]");
+            } else if (board[row][col].entity == EXIT_UNLOCKED) {
+                fprintf(out, "[ ]");
+            } else if (board[row][col].entity == HIDDEN) {
+                fprintf(out, " X ");
+            } else {
+                fprintf(out, "   ");
+            }
+        }
+        fprintf(out, "|\n");
+        print_board_line(out);
+    }
+    fprintf(out, "\n");
+    return;
+}
+
+//helper function for print_board(). You will not need to call this.
+void print_board_header(FILE *out, int lives) {
+    fprintf(out, "| Lives: %d    C A V E R U N             |\n", lives);
+}
+
+//helper function for print_board(). You will not need to call this.
+void print_board_line(FILE *out) {
+    fprintf(out, "+");
+    for (int col = 0; col < COLS; col++) {
+        fprintf(out, "---+");
+    }
+    fprintf(out, "\n");
+}
+
+//prints game statistics: tile types, completion %, and points remaining.
+void print_map_statistics(
+    FILE *out,
+    int number_of_dirt_tiles,
+    int number_of_gem_tiles,
+    int number_of_boulder_tiles,
+    double completion_percentage,
+    int maximum_points_remaining
+) {
+    fprintf(out, "========= Map Statistics =========\n");
+    fprintf(out, "Tiles Remaining by Type:\n");
+    fprintf(out, "  - DIRT:      %d\n", number_of_dirt_tiles);
+    fprintf(out, "  - GEMS:      %d\n", number_of_gem_tiles);
+    fprintf(out, "  - BOULDERS:  %d\n", number_of_boulder_tiles);
+    fprintf(out, "Completion Status:\n");
+    fprintf(out, "  - Collectible Completion: %.1f%%\n", completion_percentage);
+    fprintf(out, "  - Maximum Points Remaining: %d\n",
+        maximum_points_remaining);
+    fprintf(out, "==================================\n");
+}
@@ -0,0 +1,172 @@
+// caverun_session.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <The CS Caverun text protocol, shared by every front-end>
+
+/*
+Overview: A session is one game played over the text protocol: the setup
+phase reads the starting position and map features, and the gameplay phase
+reads commands and prints messages and boards, exactly as the console game
+always has. Input is pushed in as raw bytes, so the same session code serves
+stdin, sockets and recorded files. session_step only ever executes complete
+statements and reports how many bytes it used, leaving partial input for the
+caller to complete later.
+
+A counted command or a macro can print far more than a caller with a fixed
+output buffer can hold. Such a caller sets out_limit, and a statement that
+has printed that much stops before its next turn and is left unused. Once
+the caller has made room it passes the same statement in again, and the
+turns already played are skipped rather than played twice. A caller that
+can't let one statement run for long also sets turn_limit, which stops a
+statement the same way once that many turns have been played since the
+caller last reset slice_turns, and hint, which stops a statement before a
+hint turn until the caller has searched the hint somewhere else.
+*/
+
+#ifndef CAVERUN_SESSION_H
+#define CAVERUN_SESSION_H
+
+#include <stdio.h>
+
+#include "caverun.h"
+
+#define MACRO_DEFINE          '{'
+#define MACRO_END             '}'
+#define MACRO_RUN             '!'
+
+#define SESSION_MACROS        16
+#define SESSION_MACRO_LENGTH  128
+#define SESSION_MACRO_DEPTH   4
+#define SESSION_MAX_COUNT     1000
+#define SESSION_BULK_SIZE     64
+
+//a batch stops early on anything the player has to see as it happens
+#define SESSION_INTERRUPTS    (EVENT_BOULDER_RESPAWN | EVENT_LAVA_RESPAWN | \
+    EVENT_WIN | EVENT_GAME_OVER)
+
+struct journal;
+struct latency_histogram;
+struct pipeline;
+struct frame_ring;
+struct broadcast;
+
+enum session_phase {
+    PHASE_PLAYER_POSITION,
+    PHASE_FEATURES,
+    PHASE_GAMEPLAY,
+    PHASE_OVER
+};
+
+//reads tokens the way scanf would, from a buffer that may be incomplete
+struct scanner {
+    const char *data;
+    int length;
+    int position;
+    int at_eof;
+};
+
+enum scan_result {
+    SCAN_OK,
+    SCAN_FAIL,
+    SCAN_MORE
+};
+
+//a named list of gameplay statements, played with "!name"
+struct session_macro {
+    char name;
+    char body[SESSION_MACRO_LENGTH];
+};
+
+//a hint searched away from the session's thread, wanted is set when a
+//statement stops for one, and ready once the result is in for the next
+//hint turn to print
+struct session_hint {
+    int wanted;
+    int ready;
+    struct command command;
+    struct hint_result result;
+};
+
+//rules every game in the process is played with, set once at startup
+struct session_rules {
+    int settle;
+    int render_every;
+    int render_ms;
+    int render_events;
+    int shadowcast;
+    int shadow_check;
+};
+
+struct session {
+    struct game_state state;
+    struct tile game_board[ROWS][COLS];
+    enum session_phase phase;
+    int statements;
+    int turns;
+    int last_events;
+    FILE *out;
+    struct journal *journal;
+    struct pipeline *pipeline;
+    struct frame_ring *frames;
+    struct broadcast *broadcast;
+    struct occupancy_index *occupancy;
+    struct placement_request bulk[SESSION_BULK_SIZE];
+    int bulk_count;
+    struct placement_summary bulk_summary;
+    struct session_macro macros[SESSION_MACROS];
+    int macro_count;
+    int batch_depth;
+    int render_pending;
+    int batch_interrupted;
+    int rendered_turn;
+    long long rendered_ns;
+    int frame_skipped;
+    int locked_exits;
+    long out_limit;
+    int stopped;
+    int statement_turn;
+    int resume_turn;
+    int turn_limit;
+    int slice_turns;
+    struct session_hint *hint;
+    struct latency_histogram *latency;
+    long long runnable_ns;
+    struct lava_ahead lava_ahead;
+};
+
+extern struct session_rules session_rules;
+
+void session_begin(struct session *session, FILE *out);
+int session_step(struct session *session, const char *data, int length,
+    int at_eof);
+void session_finish(struct session *session);
+void session_tick(struct session *session);
+
+enum scan_result scan_char(struct scanner *scanner, char *c);
+enum scan_result scan_int(struct scanner *scanner, int *value);
+int skip_whitespace(struct scanner *scanner);
+
+void print_step_events(struct session *session, struct command command,
+    int events);
+void print_correct_board(struct session *session);
+void print_shadow_conformance(struct session *session);
+void print_profile(FILE *out);
+void print_gravity_direction(FILE *out, struct game_status *status);
+
+//provided Function Prototypes
+void print_board(FILE *out, struct tile board[ROWS][COLS],
+    int lives_remaining);
+void print_board_scalar(FILE *out, struct tile board[ROWS][COLS],
+    int lives_remaining);
+void print_board_line(FILE *out);
+void print_board_header(FILE *out, int lives);
+void print_map_statistics(
+    FILE *out,
+    int number_of_dirt_tiles,
+    int number_of_gem_tiles,
+    int number_of_boulder_tiles,
+    double completion_percentage,
+    int maximum_points_remaining
+);
+
+#endif
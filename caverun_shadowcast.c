@@ -0,0 +1,311 @@
+// caverun_shadowcast.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <The whole field of view by recursive shadowcasting>
+
+/*
+Overview: shadow asks check_hidden about every tile separately, walking a
+ray from the player to it in tiny steps, so a shadowed board costs its area
+times its size. shadowcast works out the same field of view in one sweep
+outwards from the player instead. The board is split into four quadrants
+(up, down, left and right of the player), each scanned one row of depth at
+a time while a list of slopes is still lit. A wall, boulder or gem (the
+tiles type_check says are opaque) covers the slopes of every ray through
+its square, splitting the lit slopes it is in front of, and once none are
+left nothing further out in that direction is looked at at all.
+
+Slopes are kept as exact fractions of tile corners, so a ray from the
+player's centre to a tile's centre is lit exactly when check_hidden's ray
+would be: it is blocked by passing through the inside of an opaque square,
+and a ray that only grazes corners is blocked once opaque corners have
+touched it on both sides. shadow_conformance lists any tile where the two
+still disagree, for checking the sweep against the ray walker on real
+games; on big boards the ray walker's steps can miss a corner.
+*/
+
+#include <limits.h>
+
+#include "caverun.h"
+
+//a slope along a quadrant, col / depth in quadrant coordinates
+struct slope {
+    int col;
+    int depth;
+};
+
+//one row of lit slopes, and from which depth each end became a blocker's
+//edge, since a ray between two blockers' edges sees nothing beyond them
+struct lit_row {
+    int depth;
+    struct slope start;
+    struct slope end;
+    int start_from;
+    int end_from;
+};
+
+void shadowcast_quadrant(struct tile board[ROWS][COLS],
+    struct game_status status, char visible[ROWS][COLS], int quadrant);
+void shadowcast_row(struct tile board[ROWS][COLS],
+    struct game_status status, char visible[ROWS][COLS], int quadrant,
+    struct lit_row row);
+int shadowcast_lit(struct tile board[ROWS][COLS], struct game_status status,
+    int quadrant, struct lit_row row, int col);
+int shadowcast_opaque(struct tile board[ROWS][COLS],
+    struct game_status status, int quadrant, int depth, int col);
+int shadowcast_tile(struct game_status status, int quadrant, int depth,
+    int col, int *i, int *j);
+int shadowcast_max_depth(struct game_status status, int quadrant);
+void shadowcast_blocker(int depth, int col, struct slope *low,
+    struct slope *high);
+int slope_compare(struct slope a, struct slope b);
+int slope_floor(struct slope slope, int depth);
+int slope_ceil(struct slope slope, int depth);
+
+//maps the true board to the game board, with hidden tiles based on shadows,
+//giving the board shadow would
+void shadowcast(struct tile game_board[ROWS][COLS],
+    struct tile true_board[ROWS][COLS], struct game_status status) {
+
+    static _Thread_local char visible[ROWS][COLS];
+
+    shadowcast_visible(true_board, status, visible);
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            game_board[i][j].has_lava = true_board[i][j].has_lava;
+            if (visible[i][j] || true_board[i][j].entity == PLAYER) {
+                game_board[i][j].entity = true_board[i][j].entity;
+            } else {
+                game_board[i][j].entity = HIDDEN;
+            }
+        }
+    }
+}
+
+//marks every tile the player can see from their position
+void shadowcast_visible(struct tile board[ROWS][COLS],
+    struct game_status status, char visible[ROWS][COLS]) {
+
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            visible[i][j] = FALSE;
+        }
+    }
+    visible[status.player_row][status.player_col] = TRUE;
+    for (int quadrant = 0; quadrant < 4; quadrant++) {
+        shadowcast_quadrant(board, status, visible, quadrant);
+    }
+}
+
+//compares shadowcast with check_hidden tile by tile, marking and counting
+//the tiles where they disagree
+int shadow_conformance(struct tile board[ROWS][COLS],
+    struct game_status status, char disagree[ROWS][COLS]) {
+
+    static _Thread_local char visible[ROWS][COLS];
+    int count = 0;
+
+    shadowcast_visible(board, status, visible);
+    for (int i = 0; i < ROWS; i++) {
+        for (int j = 0; j < COLS; j++) {
+            disagree[i][j] = board[i][j].entity != PLAYER &&
+                !visible[i][j] == !check_hidden(board, status, i, j);
+            count += disagree[i][j];
+        }
+    }
+    return count;
+}
+
+//scans one quadrant, everything from slope -1 to 1 lit to begin with
+//except that the tiles either side of the player already touch the edges
+void shadowcast_quadrant(struct tile board[ROWS][COLS],
+    struct game_status status, char visible[ROWS][COLS], int quadrant) {
+
+    struct lit_row row = {1, {-1, 1}, {1, 1}, INT_MAX, INT_MAX};
+    if (shadowcast_opaque(board, status, quadrant, 0, -1)) {
+        row.start_from = 1;
+    }
+    if (shadowcast_opaque(board, status, quadrant, 0, 1)) {
+        row.end_from = 1;
+    }
+    shadowcast_row(board, status, visible, quadrant, row);
+}
+
+//reveals the lit tiles of one row, then scans the next row once for every
+//run of slopes the opaque tiles in this row leave lit
+void shadowcast_row(struct tile board[ROWS][COLS],
+    struct game_status status, char visible[ROWS][COLS], int quadrant,
+    struct lit_row row) {
+
+    int depth = row.depth;
+    if (depth > shadowcast_max_depth(status, quadrant)) {
+        return;
+    }
+    //a single slope between two blockers' edges is dark from here on
+    if (slope_compare(row.start, row.end) == 0 && row.start_from <= depth &&
+        row.end_from <= depth) {
+        return;
+    }
+
+    int first = slope_floor(row.start, depth) - 1;
+    int last = slope_ceil(row.end, depth) + 1;
+    first = first < -depth - 1 ? -depth - 1 : first;
+    last = last > depth + 1 ? depth + 1 : last;
+
+    struct lit_row next = row;
+    next.depth = depth + 1;
+    for (int col = first; col <= last; col++) {
+        int i;
+        int j;
+        if (!shadowcast_tile(status, quadrant, depth, col, &i, &j)) {
+            continue;
+        }
+        if (col >= -depth && col <= depth &&
+            shadowcast_lit(board, status, quadrant, row, col)) {
+            visible[i][j] = TRUE;
+        }
+        if (!type_check(board, i, j)) {
+            continue;
+        }
+
+        int from = depth + 1;
+        struct slope low;
+        struct slope high;
+        shadowcast_blocker(depth, col, &low, &high);
+        if (slope_compare(high, next.start) < 0 ||
+            slope_compare(low, next.end) > 0) {
+            continue;
+        }
+        if (slope_compare(low, next.start) >= 0) {
+            struct lit_row lit = next;
+            lit.end = low;
+            lit.end_from = slope_compare(low, next.end) == 0 &&
+                next.end_from < from ? next.end_from : from;
+            shadowcast_row(board, status, visible, quadrant, lit);
+        }
+        if (slope_compare(high, next.start) == 0) {
+            next.start_from = next.start_from < from ? next.start_from : from;
+        } else {
+            next.start = high;
+            next.start_from = from;
+        }
+        if (slope_compare(next.start, next.end) > 0) {
+            return;
+        }
+    }
+    shadowcast_row(board, status, visible, quadrant, next);
+}
+
+//whether the ray to a tile's centre is lit, the diagonal ray being the
+//only one that passes the corner of the tile itself, where the tile beside
+//it in the same row can still block it
+int shadowcast_lit(struct tile board[ROWS][COLS], struct game_status status,
+    int quadrant, struct lit_row row, int col) {
+
+    int depth = row.depth;
+    struct slope centre = {col, depth};
+    int after_start = slope_compare(centre, row.start);
+    int before_end = slope_compare(row.end, centre);
+    if (after_start < 0 || before_end < 0) {
+        return FALSE;
+    }
+    if (col == depth && before_end == 0 && row.end_from <= depth) {
+        return !(after_start == 0 && row.start_from <= depth) &&
+            !shadowcast_opaque(board, status, quadrant, depth, col - 1);
+    }
+    if (col == -depth && after_start == 0 && row.start_from <= depth) {
+        return !(before_end == 0 && row.end_from <= depth) &&
+            !shadowcast_opaque(board, status, quadrant, depth, col + 1);
+    }
+    return TRUE;
+}
+
+//whether a tile of a quadrant is on the board and opaque
+int shadowcast_opaque(struct tile board[ROWS][COLS],
+    struct game_status status, int quadrant, int depth, int col) {
+
+    int i;
+    int j;
+    return shadowcast_tile(status, quadrant, depth, col, &i, &j) &&
+        type_check(board, i, j);
+}
+
+//the board tile at a depth and column of a quadrant, FALSE if off the board
+int shadowcast_tile(struct game_status status, int quadrant, int depth,
+    int col, int *i, int *j) {
+
+    if (quadrant == 0) {
+        *i = status.player_row - depth;
+        *j = status.player_col + col;
+    } else if (quadrant == 1) {
+        *i = status.player_row + depth;
+        *j = status.player_col + col;
+    } else if (quadrant == 2) {
+        *i = status.player_row + col;
+        *j = status.player_col - depth;
+    } else {
+        *i = status.player_row + col;
+        *j = status.player_col + depth;
+    }
+    return *i >= 0 && *i < ROWS && *j >= 0 && *j < COLS;
+}
+
+//how many rows deep a quadrant goes before leaving the board
+int shadowcast_max_depth(struct game_status status, int quadrant) {
+
+    if (quadrant == 0) {
+        return status.player_row;
+    } else if (quadrant == 1) {
+        return LAST_ROW - status.player_row;
+    } else if (quadrant == 2) {
+        return status.player_col;
+    }
+    return LAST_COL - status.player_col;
+}
+
+//the slopes of the rays through the inside of an opaque square, which are
+//those strictly between its lowest and highest corners
+void shadowcast_blocker(int depth, int col, struct slope *low,
+    struct slope *high) {
+
+    //corners are kept doubled so they stay whole numbers
+    if (col > 0) {
+        *low = (struct slope) {2 * col - 1, 2 * depth + 1};
+        *high = (struct slope) {2 * col + 1, 2 * depth - 1};
+    } else if (col < 0) {
+        *low = (struct slope) {2 * col - 1, 2 * depth - 1};
+        *high = (struct slope) {2 * col + 1, 2 * depth + 1};
+    } else {
+        *low = (struct slope) {-1, 2 * depth - 1};
+        *high = (struct slope) {1, 2 * depth - 1};
+    }
+}
+
+//compares two slopes, their depths always being positive
+int slope_compare(struct slope a, struct slope b) {
+
+    long long left = (long long) a.col * b.depth;
+    long long right = (long long) b.col * a.depth;
+    return (left > right) - (left < right);
+}
+
+//the column a slope crosses at a depth, rounded down
+int slope_floor(struct slope slope, int depth) {
+
+    long long scaled = (long long) slope.col * depth;
+    long long column = scaled / slope.depth;
+    if (scaled % slope.depth != 0 && scaled < 0) {
+        column--;
+    }
+    return (int) column;
+}
+
+//the column a slope crosses at a depth, rounded up
+int slope_ceil(struct slope slope, int depth) {
+
+    long long scaled = (long long) slope.col * depth;
+    long long column = scaled / slope.depth;
+    if (scaled % slope.depth != 0 && scaled > 0) {
+        column++;
+    }
+    return (int) column;
+}
@@ -0,0 +1,140 @@
+// caverun_trace.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Writes turn timelines as Chrome trace-event JSON>
+
+/*
+Overview: Each span becomes a complete ("X") event with its start and length
+in microseconds since the trace opened. Phases of a turn lie inside the
+turn's own span, so the viewer nests them under it. Turn events carry the
+command, the board size and how many tiles were lava afterwards. Writing a
+batch is itself recorded as a "trace flush" span, so any time it costs is
+visible in the timeline rather than hidden inside someone else's turn.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "caverun.h"
+#include "caverun_profile.h"
+#include "caverun_trace.h"
+
+#define TRACE_FLUSH_EVENTS    (TRACE_BUFFER_EVENTS - 256)
+#define TRACE_FILE_BUFFER     (1 << 16)
+
+struct trace_file {
+    FILE *file;
+    long long origin_ns;
+    int first_event;
+    char buffer[TRACE_FILE_BUFFER];
+};
+
+struct trace_file trace_file;
+
+void trace_flush(void);
+void trace_write_span(const char *name, long long start_ns, 
+    long long duration_ns);
+void trace_write_char(char c);
+
+//starts tracing the calling thread into a new file, FALSE if it can't
+int trace_open(const char *path) {
+
+    trace_file.file = fopen(path, "w");
+    if (trace_file.file == NULL) {
+        perror(path);
+        return FALSE;
+    }
+    setvbuf(trace_file.file, trace_file.buffer, _IOFBF, TRACE_FILE_BUFFER);
+    trace_file.origin_ns = monotonic_ns();
+    trace_file.first_event = TRUE;
+    trace_buffer.count = 0;
+    trace_buffer.dropped = 0;
+
+    fprintf(trace_file.file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    trace_active = TRUE;
+    return TRUE;
+}
+
+//writes the buffered spans once the buffer is nearly full, only ever called
+//between turns
+void trace_flush_if_needed(void) {
+
+    if (trace_file.file != NULL && trace_buffer.count >= TRACE_FLUSH_EVENTS) {
+        trace_flush();
+    }
+}
+
+//writes everything left and finishes the file
+void trace_close(void) {
+
+    if (trace_file.file == NULL) {
+        return;
+    }
+    trace_active = FALSE;
+    trace_flush();
+    fprintf(trace_file.file, "],\"otherData\":{\"rows\":%d,\"cols\":%d,"
+        "\"dropped_spans\":%lld}}\n", ROWS, COLS, trace_buffer.dropped);
+    if (fclose(trace_file.file) != 0) {
+        perror("trace");
+    }
+    trace_file.file = NULL;
+}
+
+//writes every buffered span as JSON and empties the buffer
+void trace_flush(void) {
+
+    long long start_ns = monotonic_ns();
+    FILE *file = trace_file.file;
+
+    for (int i = 0; i < trace_buffer.count; i++) {
+        struct trace_event *event = &trace_buffer.events[i];
+        trace_write_span(PROFILE_TIMER_NAMES[event->timer], event->start_ns,
+            event->duration_ns);
+        if (event->timer != TIMER_TURN) {
+            fprintf(file, "}");
+            continue;
+        }
+
+        struct command command = event->command;
+        fprintf(file, ",\"args\":{\"command\":\"");
+        //a real-time tick has no command, so it is left empty
+        if (command.instruction != '\0') {
+            trace_write_char(command.instruction);
+        }
+        if (command.instruction == ILLUMINATE) {
+            fprintf(file, " %d", command.radius);
+        } else if (command.instruction2 != 0) {
+            fprintf(file, " ");
+            trace_write_char(command.instruction2);
+        }
+        fprintf(file, "\",\"rows\":%d,\"cols\":%d,\"lava_cells\":%d}}", 
+            ROWS, COLS, event->lava_cells);
+    }
+    trace_buffer.count = 0;
+    fflush(file);
+
+    trace_write_span("trace flush", start_ns, monotonic_ns() - start_ns);
+    fprintf(file, "}");
+}
+
+//writes the fields every span shares, leaving the event open for arguments
+void trace_write_span(const char *name, long long start_ns, 
+    long long duration_ns) {
+
+    fprintf(trace_file.file, "%s\n{\"name\":\"%s\",\"cat\":\"turn\","
+        "\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f", 
+        trace_file.first_event ? "" : ",", name, 
+        (start_ns - trace_file.origin_ns) / 1e3, duration_ns / 1e3);
+    trace_file.first_event = FALSE;
+}
+
+//writes one character of a command inside a JSON string
+void trace_write_char(char c) {
+
+    unsigned char byte = (unsigned char) c;
+    if (byte < ' ' || byte >= ASCII_LIMIT - 1 || c == '"' || c == '\\') {
+        fprintf(trace_file.file, "\\u%04x", byte);
+    } else {
+        fputc(c, trace_file.file);
+    }
+}
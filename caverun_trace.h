@@ -0,0 +1,20 @@
+// caverun_trace.h
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Writes turn timelines as Chrome trace-event JSON>
+
+/*
+Overview: While a trace is open, every turn and each of its phases is kept
+as a span in memory by caverun_profile.c. The spans are written out in
+batches between turns, so the cost of writing never lands inside a turn. The
+file opens in chrome://tracing or ui.perfetto.dev.
+*/
+
+#ifndef CAVERUN_TRACE_H
+#define CAVERUN_TRACE_H
+
+int trace_open(const char *path);
+void trace_flush_if_needed(void);
+void trace_close(void);
+
+#endif
@@ -0,0 +1,158 @@
+// caverun_visibility.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Shadow mode's rays spread over a pool of worker threads>
+
+/*
+Overview: In shadow mode every tile is decided by its own check_hidden ray,
+and no tile's answer depends on any other's, so on a big board the rows can
+be shared out between threads. A pool of worker threads is started the first
+time it is needed and then kept for the rest of the process, sleeping on a
+condition variable between boards. For each board the caller publishes a
+job and works on it too: rows are handed out one at a time through an
+atomic counter, so a thread that gets cheap rows near the player just takes
+more. Every thread reads the true board without any locking since nothing
+changes it while the job runs, and writes only the game board rows it was
+handed, so no two threads ever write the same tile.
+
+Boards smaller than VISIBILITY_PARALLEL_TILES are never worth waking the
+pool for and stay on the caller's thread, as does any board asked for while
+another thread already has the pool, e.g. two batch games at once.
+*/
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "caverun.h"
+#include "caverun_profile.h"
+
+#define VISIBILITY_MAX_THREADS  8
+
+//one shadowed board being worked out
+struct visibility_job {
+    struct tile (*game_board)[COLS];
+    struct tile (*true_board)[COLS];
+    struct game_status status;
+    atomic_int next_row;
+    atomic_int rays;
+};
+
+//the worker threads, woken for each new job by a bump of generation
+struct visibility_pool {
+    pthread_t threads[VISIBILITY_MAX_THREADS];
+    int helpers;
+    pthread_mutex_t busy;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned generation;
+    int working;
+    struct visibility_job job;
+};
+
+struct visibility_pool visibility_pool = {
+    .busy = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER
+};
+
+void visibility_pool_start(void);
+void *visibility_worker(void *arg);
+int visibility_job_rows(struct visibility_job *job);
+
+//works out a shadowed board with the pool's help, returns FALSE without
+//touching the game board if the pool can't be used right now
+int shadow_parallel(struct tile game_board[ROWS][COLS],
+    struct tile true_board[ROWS][COLS], struct game_status status) {
+
+    static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+    struct visibility_pool *pool = &visibility_pool;
+
+    pthread_once(&pool_once, visibility_pool_start);
+    if (pool->helpers == 0 || pthread_mutex_trylock(&pool->busy) != 0) {
+        return FALSE;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->job.game_board = game_board;
+    pool->job.true_board = true_board;
+    pool->job.status = status;
+    atomic_store(&pool->job.next_row, 0);
+    atomic_store(&pool->job.rays, 0);
+    pool->working = pool->helpers;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    visibility_job_rows(&pool->job);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->working > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    //the workers don't profile, so their rays are counted here
+    PROFILE_COUNT(COUNT_RAYS_TRACED, atomic_load(&pool->job.rays));
+    pthread_mutex_unlock(&pool->busy);
+    return TRUE;
+}
+
+//starts one helper per core beyond the caller's, they are never stopped
+void visibility_pool_start(void) {
+
+    struct visibility_pool *pool = &visibility_pool;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int wanted = cores > VISIBILITY_MAX_THREADS ? VISIBILITY_MAX_THREADS :
+        (int) cores;
+
+    pool->helpers = 0;
+    for (int i = 0; i < wanted - 1; i++) {
+        if (pthread_create(&pool->threads[i], NULL, visibility_worker,
+            pool) != 0) {
+            break;
+        }
+        pthread_detach(pool->threads[i]);
+        pool->helpers++;
+    }
+}
+
+//sleeps until there is a new job, works on it, and goes back to sleep
+void *visibility_worker(void *arg) {
+
+    struct visibility_pool *pool = arg;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (TRUE) {
+        while (pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        int rays = visibility_job_rows(&pool->job);
+        atomic_fetch_add(&pool->job.rays, rays);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->working--;
+        if (pool->working == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    return NULL;
+}
+
+//takes rows of the job until there are none left, returns the number of
+//rays traced
+int visibility_job_rows(struct visibility_job *job) {
+
+    int rays = 0;
+    int row;
+    while ((row = atomic_fetch_add(&job->next_row, 1)) < ROWS) {
+        rays += shadow_rows(job->game_board, job->true_board, job->status,
+            row, row + 1);
+    }
+    return rays;
+}
@@ -0,0 +1,96 @@
+// server_client.c
+// Written by <Danny Sun> <z5691331> on <13/03/2025>
+//
+// Description: <Plays one game against a server for the tests>
+
+/*
+Overview: Connects to a server's Unix socket, trying again for a few seconds
+while the server starts up, sends everything on stdin, then copies all the
+output the server sends back to stdout until it closes the connection. The
+output can then be compared with the console game's for the same input.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define CLIENT_BUFFER_SIZE    4096
+#define CLIENT_ATTEMPTS       100
+#define CLIENT_RETRY_NS       50000000
+
+int client_connect(const char *path);
+int client_write_all(int fd, const char *data, long length);
+
+int main(int argc, char *argv[]) {
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s SOCKET < input > output\n", argv[0]);
+        return 2;
+    }
+    int fd = client_connect(argv[1]);
+    if (fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    char buffer[CLIENT_BUFFER_SIZE];
+    ssize_t count;
+    while ((count = read(STDIN_FILENO, buffer, sizeof(buffer))) > 0) {
+        if (!client_write_all(fd, buffer, count)) {
+            perror("send");
+            return 1;
+        }
+    }
+    shutdown(fd, SHUT_WR);
+
+    while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+        if (!client_write_all(STDOUT_FILENO, buffer, count)) {
+            perror("stdout");
+            return 1;
+        }
+    }
+    close(fd);
+    return count < 0;
+}
+
+//connects to the server, giving it a few seconds to start listening
+int client_connect(const char *path) {
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+    struct timespec retry = {0, CLIENT_RETRY_NS};
+    for (int i = 0; i < CLIENT_ATTEMPTS; i++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr *) &address, sizeof(address)) == 0) {
+            return fd;
+        }
+        close(fd);
+        nanosleep(&retry, NULL);
+    }
+    return -1;
+}
+
+//writes all of the data, returns 0 if it couldn't
+int client_write_all(int fd, const char *data, long length) {
+
+    long written = 0;
+    while (written < length) {
+        ssize_t count = write(fd, data + written, length - written);
+        if (count < 0) {
+            return 0;
+        }
+        written += count;
+    }
+    return 1;
+}
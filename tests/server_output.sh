@@ -0,0 +1,35 @@
+#!/bin/sh
+# server_output.sh
+# Written by <Danny Sun> <z5691331> on <13/03/2025>
+#
+# Description: <Checks a server prints every game exactly as the console does>
+#
+# Usage: server_output.sh GAME CLIENT INPUT...
+# Plays every input through the console game and through a server on a
+# Unix socket, failing if the two print anything different.
+
+game="$1"
+client="$2"
+shift 2
+
+work=$(mktemp -d) || exit 1
+socket="$work/server.sock"
+"$game" --server-unix "$socket" 2> "$work/server.err" &
+server=$!
+trap 'kill $server 2> /dev/null; rm -rf "$work"' EXIT
+
+status=0
+for input in "$@"; do
+    "$game" < "$input" > "$work/console.out"
+    if ! "$client" "$socket" < "$input" > "$work/server.out"; then
+        echo "FAIL $input: could not play it on the server"
+        status=1
+    elif ! cmp -s "$work/console.out" "$work/server.out"; then
+        echo "FAIL $input: the server printed something different"
+        diff "$work/console.out" "$work/server.out" | head -20
+        status=1
+    else
+        echo "ok $input ($(wc -c < "$work/server.out") bytes)"
+    fi
+done
+exit $status